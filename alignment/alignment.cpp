@@ -17,6 +17,7 @@
 #include "gsl/mygsl.h"
 #include <utils/gzstream.h>
 #include <utils/hammingdistance.h> //for sumForUnknownCharacters
+#include <utils/mappedfile.h>      //for BinaryDistanceMatrixFile
 #include <utils/progress.h>        //for progress_display
 #include <utils/safe_io.h>         //for safeGetLine
 #include <utils/stringfunctions.h> //for convert_int, etc.
@@ -34,8 +35,6 @@
 #include <boost/scoped_array.hpp>
 #endif
 
-#define USE_UNINFORMATIVE_PARSIMONY (0)
-
 using namespace std;
 using namespace Eigen;
 
@@ -84,6 +83,7 @@ Alignment::Alignment()
     seq_type = SEQ_UNKNOWN;
     STATE_UNKNOWN = 126;
     pars_lower_bound = nullptr;
+    num_parsimony_bits = 0;
     isShowingProgressDisabled = false;
 }
 
@@ -653,6 +653,7 @@ Alignment::Alignment(const char *filename, const char *sequence_type,
     seq_type = SEQ_UNKNOWN;
     STATE_UNKNOWN = 126;
     pars_lower_bound = nullptr;
+    num_parsimony_bits = 0;
     double readStart = getRealTime();
     cout << "Reading alignment file " << filename << " ... ";
     intype = detectInputFile(filename);
@@ -737,6 +738,7 @@ Alignment::Alignment(NxsDataBlock *data_block, char *sequence_type,
     seq_type = SEQ_UNKNOWN;
     STATE_UNKNOWN = 126;
     pars_lower_bound = nullptr;
+    num_parsimony_bits = 0;
     
     extractDataBlock(data_block);
     if (verbose_mode >= VB_DEBUG)
@@ -1077,17 +1079,6 @@ void Alignment::computeConst(Pattern &pat) {
         if (num_app[j] >= 2) {
             ++count;
         }
-#if (USE_UNINFORMATIVE_PARSIMONY)
-        else if (num_app[j] == 1) {
-            #ifdef _OPENMP
-            #pragma omp critical
-            #endif
-            {
-                singleton_parsimony_states.resize(pat_len,0);
-                singleton_parsimony_states[last_app[j]] += pat.frequency;
-            }
-        }
-#endif
     }
 
     // at least 2 states, each appearing at least twice
@@ -1227,18 +1218,18 @@ bool Alignment::addPatternLazy(Pattern &pat, intptr_t site,
                  << " gaps or ambiguous characters" << endl;
         }
     }
-    PatternIntMap::iterator pat_it = pattern_index.find(pat);
-    if (pat_it == pattern_index.end()) { // not found
+    auto inserted = pattern_index.insert(PatternIntMap::value_type
+                                         (pat, static_cast<int>(size())));
+    if (inserted.second) { // not found
         pat.frequency = freq;
         //We don't do computeConst(pat); here, that's why
         //there's a "Lazy" in this member function's name!
         //We do that in addPattern...
         push_back(pat);
-        pattern_index[back()] = static_cast<int>(size())-1;
         site_pattern[site]    = static_cast<int>(size())-1;
         return true;
     } else {
-        int index = pat_it->second;
+        int index = inserted.first->second;
         at(index).frequency += freq;
         site_pattern[site] = index;
         return false;
@@ -1303,13 +1294,58 @@ void Alignment::addConstPatterns(char *freq_const_patterns) {
     countConstSite();
 }
 
+bool Alignment::foldUninformativePattern(const Pattern& pat) {
+    if (seq_type == SEQ_POMO) {
+        return false;
+    }
+    std::vector<int> num_app(num_states, 0);
+    std::vector<int> last_app(num_states, -1);
+    int pat_len = static_cast<int>(pat.size());
+    for (int i = 0; i < pat_len; ++i) {
+        StateType state = pat[i];
+        if (state == STATE_UNKNOWN) {
+            continue;
+        }
+        if (num_states <= static_cast<int>(state)) {
+            //With ambiguous states, the cost can depend on the tree
+            return false;
+        }
+        ++num_app[state];
+        last_app[state] = i;
+    }
+    //One state (if any) is on more than one taxon.  Every other state
+    //costs one step, on the branch to the taxon that has it.  If no state
+    //appears twice, the first state is "free".
+    bool first_is_free = true;
+    for (int j = 0; j < num_states; ++j) {
+        if (2 <= num_app[j]) {
+            first_is_free = false;
+        }
+    }
+    for (int j = 0; j < num_states; ++j) {
+        if (num_app[j] == 1) {
+            if (first_is_free) {
+                first_is_free = false;
+                continue;
+            }
+            singleton_parsimony_states[last_app[j]] += pat.frequency;
+        }
+    }
+    return true;
+}
+
+bool Alignment::hasFoldedUninformativePatterns() const {
+    return !singleton_parsimony_states.empty();
+}
+
 void Alignment::orderPatternByNumChars(int pat_type) {
     intptr_t nptn       = getNPattern();
     const int UINT_BITS = sizeof(UINT)*8;
-    if (pat_type == PAT_INFORMATIVE) {
-        num_parsimony_sites = num_informative_sites;
-    } else {
-        num_parsimony_sites = num_variant_sites;
+    bool fold_uninformative = (pat_type == PAT_INFORMATIVE);
+    num_parsimony_sites = num_variant_sites;
+    singleton_parsimony_states.clear();
+    if (fold_uninformative) {
+        singleton_parsimony_states.resize(getNSeq(), 0);
     }
 
     size_t frequency_total = 0;
@@ -1326,26 +1362,40 @@ void Alignment::orderPatternByNumChars(int pat_type) {
         }
         quicksort(num_chars, 0, static_cast<int>(nptn-1), ptn_order);
         delete [] num_chars;
+        //Invariant patterns cost nothing, on any tree.  Uninformative
+        //patterns (without ambiguous states) cost num_chars-1 on any tree;
+        //if they are folded, that cost is charged to the taxa with the
+        //singleton states (see singleton_parsimony_states), up front,
+        //and the kernels never see them.
+        intptr_t kept = 0;
         for (intptr_t ptn = 0; ptn < nptn; ++ptn) {
-            auto pat = at(ptn_order[ptn]);
+            const Pattern& pat = at(ptn_order[ptn]);
             if (pat.isInvariant()) {
-                nptn = ptn;
+                continue;
             }
-            else if (pat_type == PAT_INFORMATIVE && !pat.isInformative() ) {
-                nptn = ptn;
+            if (fold_uninformative && !pat.isInformative()
+                && foldUninformativePattern(pat)) {
+                continue;
             }
+            ptn_order[kept++] = ptn_order[ptn];
         }
+        nptn = kept;
         ordered_pattern.clear();
         ordered_pattern.resize(nptn);
+        ordered_pattern_id.resize(nptn);
         #ifdef _OPENMP
         #pragma omp parallel for reduction(+:frequency_total)
         #endif
         for (intptr_t ptn = 0; ptn < nptn; ++ptn) {
             ordered_pattern[ptn] = at(ptn_order[ptn]);
+            ordered_pattern_id[ptn] = static_cast<int>(ptn_order[ptn]);
             frequency_total += ordered_pattern[ptn].frequency;
         }
         delete [] ptn_order;
     }
+    if (fold_uninformative) {
+        num_parsimony_sites = static_cast<int>(frequency_total);
+    }
 
     size_t maxi      = (frequency_total+UINT_BITS-1)/UINT_BITS;
     delete[] pars_lower_bound;
@@ -1387,13 +1437,107 @@ void Alignment::orderPatternByNumChars(int pat_type) {
     }
 
     // fill up to vectorclass with dummy pattern
-    intptr_t maxnptn = get_safe_upper_limit_float(num_parsimony_sites);
+    // (enough for the patterns, not the sites: no more than
+    //  ptn_freq_pars, in PhyloTree, has room for)
+    intptr_t maxnptn = get_safe_upper_limit_float(nptn);
     for (intptr_t ptn = nptn; ptn<maxnptn; ++ptn) {
         Pattern pat;
         pat.resize(getNSeq(), STATE_UNKNOWN);
         pat.frequency = 0;
         ordered_pattern.emplace_back(pat);
+        ordered_pattern_id.push_back(-1);
+    }
+    computeParsimonyBitLayout();
+}
+
+void Alignment::computeParsimonyBitLayout() {
+    const int UINT_BITS = sizeof(UINT)*8;
+    //Planes are padded to the widest parsimony vector (AVX-512),
+    //so that no SIMD block straddles two planes of different weight.
+    const int PLANE_BITS = 512;
+    intptr_t  nptn       = ordered_pattern.size();
+    
+    pars_pattern_bit_start.resize(nptn+1);
+    pars_pattern_bits.clear();
+    pars_word_weight.clear();
+    pars_word_padding.clear();
+
+    if (!Params::getInstance().parsimony_weighted_patterns) {
+        int bit = 0;
+        for (intptr_t ptn = 0; ptn < nptn; ++ptn) {
+            pars_pattern_bit_start[ptn] = bit;
+            for (int j = ordered_pattern[ptn].frequency; 0 < j; --j) {
+                pars_pattern_bits.push_back(bit++);
+            }
+        }
+        pars_pattern_bit_start[nptn] = bit;
+        num_parsimony_bits = bit;
+        size_t words = (bit + UINT_BITS - 1) / UINT_BITS;
+        pars_word_weight.resize(words, 1);
+        pars_word_padding.resize(words, 0);
+        if (bit % UINT_BITS != 0) {
+            pars_word_padding.back() = ~((1U << (bit % UINT_BITS)) - 1);
+        }
+    } else {
+        //Count patterns in each bit-plane of the frequency
+        IntVector plane_count;
+        for (intptr_t ptn = 0; ptn < nptn; ++ptn) {
+            UINT freq = ordered_pattern[ptn].frequency;
+            for (int k = 0; freq != 0; ++k, freq >>= 1) {
+                if (static_cast<int>(plane_count.size()) <= k) {
+                    plane_count.resize(k+1, 0);
+                }
+                plane_count[k] += (freq & 1);
+            }
+        }
+        int planes = static_cast<int>(plane_count.size());
+        IntVector plane_start(planes+1, 0);
+        for (int k = 0; k < planes; ++k) {
+            int padded = (plane_count[k] + PLANE_BITS - 1) / PLANE_BITS * PLANE_BITS;
+            plane_start[k+1] = plane_start[k] + padded;
+        }
+        num_parsimony_bits = plane_start[planes];
+        pars_word_weight.resize(num_parsimony_bits / UINT_BITS);
+        pars_word_padding.resize(num_parsimony_bits / UINT_BITS, ~(UINT)0);
+        for (int k = 0; k < planes; ++k) {
+            for (int w = plane_start[k] / UINT_BITS; w < plane_start[k+1] / UINT_BITS; ++w) {
+                pars_word_weight[w] = (1U << k);
+            }
+        }
+        //Assign each pattern the next free bit in each of its planes
+        IntVector next_bit(plane_start.begin(), plane_start.end()-1);
+        pars_pattern_bits.reserve(nptn);
+        for (intptr_t ptn = 0; ptn < nptn; ++ptn) {
+            pars_pattern_bit_start[ptn] = static_cast<int>(pars_pattern_bits.size());
+            UINT freq = ordered_pattern[ptn].frequency;
+            for (int k = 0; freq != 0; ++k, freq >>= 1) {
+                if (freq & 1) {
+                    int bit = next_bit[k]++;
+                    pars_pattern_bits.push_back(bit);
+                    pars_word_padding[bit / UINT_BITS] &= ~(1U << (bit % UINT_BITS));
+                }
+            }
+        }
+        pars_pattern_bit_start[nptn] = static_cast<int>(pars_pattern_bits.size());
     }
+
+    //Each pattern is looked up by the first of its bits
+    pars_bit_pattern.assign(num_parsimony_bits, -1);
+    for (intptr_t ptn = 0; ptn < nptn; ++ptn) {
+        if (pars_pattern_bit_start[ptn] < pars_pattern_bit_start[ptn+1]) {
+            pars_bit_pattern[pars_pattern_bits[pars_pattern_bit_start[ptn]]] = static_cast<int>(ptn);
+        }
+    }
+}
+
+size_t Alignment::getMaxNumParsimonyBits() {
+    if (!ordered_pattern.empty()) {
+        //Once patterns have been laid out, only the bits
+        //that the layout uses are needed.
+        return num_parsimony_bits;
+    }
+    size_t bits = max(size(), (size_t)num_variant_sites);
+    return max(bits, (size_t)num_parsimony_bits);
 }
 
 void Alignment::ungroupSitePattern()
@@ -1977,6 +2121,24 @@ bool Alignment::buildPattern(StrVector &sequences,
     return constructPatterns(nseq, nsite, sequences, nullptr);
 }
 
+/**
+ * @param nseq       number of sequences
+ * @param site_count number of sites (or codons)
+ * @return the number of sites for which patterns should be constructed
+ *         at a time (enough to keep every thread busy, but few enough
+ *         that the block's patterns take up only a few megabytes)
+ */
+int getPatternBlockSize(int nseq, int site_count) {
+    const size_t block_bytes = 16 << 20;
+    size_t block_size = block_bytes / (max(nseq, 1) * sizeof(StateType));
+    #ifdef _OPENMP
+    block_size = max(block_size, (size_t)(64 * omp_get_max_threads()));
+    #else
+    block_size = max(block_size, (size_t)64);
+    #endif
+    return static_cast<int>(min(block_size, (size_t)max(site_count, 1)));
+}
+
 bool Alignment::constructPatterns(int nseq, int nsite,
                                   const StrVector& sequences,
                                   progress_display_ptr progress) {
@@ -1999,22 +2161,36 @@ bool Alignment::constructPatterns(int nseq, int nsite,
             outError("Number of sites is not multiple of 3");
         }
     }
-    site_pattern.resize(nsite/step, -1);
+    int site_count = nsite / step;
+    site_pattern.resize(site_count, -1);
     clear();
     pattern_index.clear();
+    //Room for every site's Pattern object (but not its states), so that
+    //appending patterns never has to copy the ones already added.
+    reserve(site_count);
     
-    //1. Construct all the patterns, in parallel (*without* trying to consolidate
-    //   duplicated patterns; we'll do that later).
-    resize(nsite / step);
+    //Sites are converted to patterns a block at a time (in parallel),
+    //and each block's patterns are then compressed (sequentially, into
+    //pattern_index) before the next block is converted.  That way,
+    //only one block's worth of duplicate patterns exists at any time,
+    //rather than one pattern for every site in the alignment.
     struct PatternInfo {
         std::ostringstream errors;
         std::ostringstream warnings;
         int num_error;
         bool isAllGaps;
         PatternInfo() : num_error(0), isAllGaps(false) {}
+        void reset() {
+            errors.str("");
+            warnings.str("");
+            num_error = 0;
+            isAllGaps = false;
+        }
     };
-    std::vector<PatternInfo> patternInfo;
-    patternInfo.resize((nsite + (step-1)) / step);
+    int block_size = getPatternBlockSize(nseq, site_count);
+    std::vector<Pattern>       block(block_size);
+    std::vector<PackedPattern> packed(block_size);
+    std::vector<PatternInfo> patternInfo(block_size);
     progress_display_ptr progress_here = nullptr;
     if (progress==nullptr && !isShowingProgressDisabled) {
         #if USE_PROGRESS_DISPLAY
@@ -2023,136 +2199,130 @@ bool Alignment::constructPatterns(int nseq, int nsite,
         progress = progress_here;
         #endif
     }
-    
-    #ifdef _OPENMP
-    #pragma omp parallel for
-    #endif
-    for (int site = 0; site < nsite; site+=step) {
-        PatternInfo& info = patternInfo[site/step];
-        Pattern& pat = at(site / step);
-        pat.resize(nseq);
-        for (int seq = 0; seq < nseq; seq++) {
-            //char state = convertState(sequences[seq][site], seq_type);
-            char state = char_to_state[(int)(sequences[seq][site])];
-            if (seq_type == SEQ_CODON || nt2aa) {
-                // special treatment for codon
-                char state2 = char_to_state[(int)(sequences[seq][site+1])];
-                char state3 = char_to_state[(int)(sequences[seq][site+2])];
-                if (state < 4 && state2 < 4 && state3 < 4) {
-                    //state = non_stop_codon[state*16 + state2*4 + state3];
-                    state = state*16 + state2*4 + state3;
-                    if (genetic_code[(int)state] == '*') {
-                        info.errors << "Sequence " << seq_names[seq]
-                            << " has stop codon " << sequences[seq][site]
-                            << sequences[seq][site + 1] << sequences[seq][site + 2]
-                            << " at site " << site + 1 << "\n";
-                        info.num_error++;
-                        state = STATE_UNKNOWN;
-                    } else if (nt2aa) {
-                        state = AA_to_state[(int)genetic_code[(int)state]];
+    std::stringstream err_str;
+    int num_gaps_only = 0;
+    for (int block_start = 0; block_start < site_count; block_start += block_size) {
+        int block_stop = min(block_start + block_size, site_count);
+        
+        //1. Construct the block's patterns, in parallel (*without* trying
+        //   to consolidate duplicated patterns; we'll do that next).
+        #ifdef _OPENMP
+        #pragma omp parallel for
+        #endif
+        for (int r = block_start; r < block_stop; ++r) {
+            int site = r * step;
+            PatternInfo& info = patternInfo[r - block_start];
+            Pattern& pat = block[r - block_start];
+            info.reset();
+            pat.resize(nseq);
+            for (int seq = 0; seq < nseq; seq++) {
+                //char state = convertState(sequences[seq][site], seq_type);
+                char state = char_to_state[(int)(sequences[seq][site])];
+                if (seq_type == SEQ_CODON || nt2aa) {
+                    // special treatment for codon
+                    char state2 = char_to_state[(int)(sequences[seq][site+1])];
+                    char state3 = char_to_state[(int)(sequences[seq][site+2])];
+                    if (state < 4 && state2 < 4 && state3 < 4) {
+                        //state = non_stop_codon[state*16 + state2*4 + state3];
+                        state = state*16 + state2*4 + state3;
+                        if (genetic_code[(int)state] == '*') {
+                            info.errors << "Sequence " << seq_names[seq]
+                                << " has stop codon " << sequences[seq][site]
+                                << sequences[seq][site + 1] << sequences[seq][site + 2]
+                                << " at site " << site + 1 << "\n";
+                            info.num_error++;
+                            state = STATE_UNKNOWN;
+                        } else if (nt2aa) {
+                            state = AA_to_state[(int)genetic_code[(int)state]];
+                        } else {
+                            state = non_stop_codon[(int)state];
+                        }
+                    } else if (state == STATE_INVALID || state2 == STATE_INVALID ||
+                               state3 == STATE_INVALID) {
+                        state = STATE_INVALID;
                     } else {
-                        state = non_stop_codon[(int)state];
-                    }
-            	} else if (state == STATE_INVALID || state2 == STATE_INVALID ||
-                           state3 == STATE_INVALID) {
-            		state = STATE_INVALID;
-                } else {
-                    if (state != STATE_UNKNOWN || state2 != STATE_UNKNOWN ||
-                        state3 != STATE_UNKNOWN) {
-                        info.warnings << "WARNING: Sequence " << seq_names[seq]
-                            << " has ambiguous character " << sequences[seq][site]
-                            << sequences[seq][site + 1] << sequences[seq][site + 2]
-                            << " at site " << site + 1 << "\n";
+                        if (state != STATE_UNKNOWN || state2 != STATE_UNKNOWN ||
+                            state3 != STATE_UNKNOWN) {
+                            info.warnings << "WARNING: Sequence " << seq_names[seq]
+                                << " has ambiguous character " << sequences[seq][site]
+                                << sequences[seq][site + 1] << sequences[seq][site + 2]
+                                << " at site " << site + 1 << "\n";
+                        }
+                        state = STATE_UNKNOWN;
                     }
-                    state = STATE_UNKNOWN;
                 }
-            }
-            if (state == STATE_INVALID) {
-                if (info.num_error <= 100) {
-                    if (info.num_error < 100) {
-                        info.errors << "Sequence " << seq_names[seq]
-                                    << " has invalid character " << sequences[seq][site];
-                        if (seq_type == SEQ_CODON)
-                            info.errors << sequences[seq][site+1] << sequences[seq][site+2];
-                        info.errors << " at site " << site+1 << endl;
-                    } else if (info.num_error == 100) {
-                        info.errors << "...many more..." << endl;
+                if (state == STATE_INVALID) {
+                    if (info.num_error <= 100) {
+                        if (info.num_error < 100) {
+                            info.errors << "Sequence " << seq_names[seq]
+                                        << " has invalid character " << sequences[seq][site];
+                            if (seq_type == SEQ_CODON)
+                                info.errors << sequences[seq][site+1] << sequences[seq][site+2];
+                            info.errors << " at site " << site+1 << endl;
+                        } else if (info.num_error == 100) {
+                            info.errors << "...many more..." << endl;
+                        }
                     }
+                    ++info.num_error;
                 }
-                ++info.num_error;
+                pat[seq] = state;
+            }
+            computeConst(pat);
+            if (info.num_error == 0)
+            {
+                info.isAllGaps = pat.isAllGaps(STATE_UNKNOWN);
+                packed[r - block_start] = PackedPattern(pat);
             }
-            pat[seq] = state;
-        }
-        computeConst(pat);
-        if (info.num_error == 0)
-        {
-            info.isAllGaps = pat.isAllGaps(STATE_UNKNOWN);
-        }
-        if (progress!=nullptr) {
-            (*progress) += (double)step;
-        }
-    }
-    if (progress_here!=nullptr) {
-        #if USE_PROGRESS_DISPLAY
-        progress_here->done();
-        delete progress_here;
-        #endif
-        progress_here = progress = nullptr;
-    }
-
-    std::stringstream err_str;
-    //2. Now handle warnings and errors, and compress patterns, sequentially
-
-    #if USE_PROGRESS_DISPLAY
-    if (progress==nullptr && !isShowingProgressDisabled) {
-        progress_here = new progress_display((double)nsite, "Compressing patterns",
-                                             "processed", "site");
-        progress = progress_here;
-    }
-    #endif
-
-    int num_gaps_only = 0;
-    int w = 0;
-    int site = 0;
-    for (int r = 0; r < patternInfo.size(); ++r, site+=step) {
-        PatternInfo& info = patternInfo[r];
-        std::string warnings = info.warnings.str();
-        if (!warnings.empty()) {
-            #if USE_PROGRESS_DISPLAY
-            if (progress!=nullptr) { progress->hide(); }
-            #endif
-            cout << warnings;
-            #if USE_PROGRESS_DISPLAY
-            if (progress!=nullptr) { progress->show(); }
-            #endif
-        }
-        std::string errors = info.errors.str();
-        if (!errors.empty()) {
-            err_str << errors;
         }
-        else {
-            num_gaps_only += info.isAllGaps ? 1 : 0;
-            PatternIntMap::iterator pat_it = pattern_index.find(at(r));
-            if (pat_it == pattern_index.end()) {
-                if (w < r) {
-                    std::swap(at(w), at(r));
-                }
-                at(w).frequency = 1;
-                pattern_index[at(w)] = w;
-                site_pattern[r] = w;
-                ++w;
+        
+        //2. Now handle the block's warnings and errors, and compress
+        //   its patterns, sequentially (so patterns are numbered in
+        //   the order of the sites where they first occur).
+        for (int r = block_start; r < block_stop; ++r) {
+            PatternInfo& info = patternInfo[r - block_start];
+            Pattern&     pat  = block[r - block_start];
+            std::string warnings = info.warnings.str();
+            if (!warnings.empty()) {
+                #if USE_PROGRESS_DISPLAY
+                if (progress!=nullptr) { progress->hide(); }
+                #endif
+                cout << warnings;
+                #if USE_PROGRESS_DISPLAY
+                if (progress!=nullptr) { progress->show(); }
+                #endif
+            }
+            std::string errors = info.errors.str();
+            if (!errors.empty()) {
+                err_str << errors;
             }
             else {
-                int q = pat_it->second;
-                ++at(q).frequency;
-                site_pattern[r] = q;
+                num_gaps_only += info.isAllGaps ? 1 : 0;
+                int w = static_cast<int>(size());
+                auto inserted = pattern_index.insert(PatternIntMap::value_type
+                                                     (std::move(packed[r - block_start]), w));
+                if (inserted.second) {
+                    //Hand the block's states over, rather than copying them
+                    //(the block's pattern will be resized for the next block).
+                    push_back(Pattern());
+                    Pattern& added = back();
+                    added.swap(pat);
+                    added.flag       = pat.flag;
+                    added.const_char = pat.const_char;
+                    added.num_chars  = pat.num_chars;
+                    added.frequency  = 1;
+                    site_pattern[r] = w;
+                }
+                else {
+                    int q = inserted.first->second;
+                    ++at(q).frequency;
+                    site_pattern[r] = q;
+                }
             }
         }
         if (progress!=nullptr) {
-            (*progress) += ((double)step);
+            (*progress) += (double)((block_stop - block_start) * step);
         }
     }
-    resize(w);
     if (progress_here!=nullptr) {
         #if USE_PROGRESS_DISPLAY
         progress_here->done();
@@ -2241,6 +2411,9 @@ int Alignment::readPhylip(const char *filename, const char *sequence_type) {
 
             seq_names.resize(nseq, "");
             sequences.resize(nseq, "");
+            for (auto& sequence : sequences) {
+                sequence.reserve(nsite);
+            }
 
         } else { // read sequence contents
             if (seq_names[seq_id] == "") { // cut out the sequence name
@@ -2321,6 +2494,9 @@ int Alignment::readPhylipSequential(const char *filename,
 
             seq_names.resize(nseq, "");
             sequences.resize(nseq, "");
+            for (auto& sequence : sequences) {
+                sequence.reserve(nsite);
+            }
 
         } else { // read sequence contents
             if (seq_id >= nseq) {
@@ -2393,6 +2569,11 @@ int Alignment::readFasta(const char *filename, const char *sequence_type) {
                 seq_names.push_back(line.substr(1, pos-1));
                 trimString(seq_names.back());
                 sequences.push_back("");
+                if (1 < sequences.size()) {
+                    //Sequences are usually all the same length (so
+                    //reserving that much avoids repeated reallocation).
+                    sequences.back().reserve(sequences.front().length());
+                }
                 continue;
             }
             // read sequence contents
@@ -4757,8 +4938,36 @@ template <class S> void Alignment::printDist(const std::string& format,
     out.flush();
 }
 
+void Alignment::printBinaryDist(const char *file_name, double *dist_mat) const {
+    size_t nseqs = getNSeq();
+    std::vector<std::string> names;
+    names.reserve(nseqs);
+    for (size_t seq = 0; seq < nseqs; ++seq) {
+        names.push_back(getSeqName(static_cast<int>(seq)));
+    }
+    BinaryDistanceMatrixFile out;
+    if (!out.create(file_name, names)) {
+        outError(ERR_WRITE_OUTPUT, file_name);
+    }
+    #ifdef _OPENMP
+    #pragma omp parallel for
+    #endif
+    for (intptr_t seq1 = 1; seq1 < static_cast<intptr_t>(nseqs); ++seq1) {
+        float*        writeRow = out.getRow(seq1);
+        const double* readRow  = dist_mat + seq1 * nseqs;
+        for (intptr_t seq2 = 0; seq2 < seq1; ++seq2) {
+            writeRow[seq2] = static_cast<float>(readRow[seq2]);
+        }
+    }
+    out.close();
+}
+
 void Alignment::printDist ( const std::string& format, int compression_level
                            , const char *file_name, double *dist_mat) const {
+    if (format == "binary") {
+        printBinaryDist(file_name, dist_mat);
+        return;
+    }
     try {
         if (format.find("gz") == string::npos) {
             ofstream out;
@@ -5012,11 +5221,84 @@ double Alignment::readDist(igzstream &in, bool is_incremental,
     return longest_dist;
 }
 
+double Alignment::readBinaryDist(const char *file_name, bool is_incremental,
+                                 double *dist_mat) {
+    BinaryDistanceMatrixFile in;
+    if (!in.openForReading(file_name)) {
+        throw "Could not map binary distance file";
+    }
+    size_t nseqs      = getNSeq();
+    size_t file_nseqs = in.getRank();
+    if (!is_incremental && file_nseqs != nseqs) {
+        throw "Distance file has different number of taxa";
+    }
+    std::map< string, int > map_seqName_ID;
+    const std::vector<std::string>& names = in.getSequenceNames();
+    for (size_t seq = 0; seq < file_nseqs; ++seq) {
+        if (map_seqName_ID.find(names[seq]) != map_seqName_ID.end()) {
+            throw "Duplicate sequence name found in the distance file: "
+                  + names[seq];
+        }
+        map_seqName_ID[names[seq]] = static_cast<int>(seq);
+    }
+    size_t missingSequences = 0;
+    std::vector<int> actualToTemp(nseqs, -1);
+    for (size_t seq = 0; seq < nseqs; ++seq) {
+        string seqName = getSeqName(static_cast<int>(seq));
+        auto found = map_seqName_ID.find(seqName);
+        if (found != map_seqName_ID.end()) {
+            actualToTemp[seq] = found->second;
+        } else if (is_incremental) {
+            ++missingSequences;
+        } else {
+            throw "Could not find taxa name " + seqName;
+        }
+    }
+    if (is_incremental) {
+        if ( 0 < missingSequences || file_nseqs != nseqs ) {
+            std::cout << missingSequences << " sequences have been added, "
+                << (file_nseqs + missingSequences - nseqs )
+                << " sequences (found in the distance file) have been removed."
+                << std::endl;
+        }
+    }
+    //Only the lower triangle is stored (so the matrix is
+    //symmetric, with zeroes on its diagonal, by construction).
+    DoubleVector row_longest(nseqs, 0.0);
+    #ifdef _OPENMP
+    #pragma omp parallel for
+    #endif
+    for (intptr_t seq1 = 0; seq1 < static_cast<intptr_t>(nseqs); ++seq1) {
+        double* writeRow = dist_mat + seq1 * nseqs;
+        int     tmp1     = actualToTemp[seq1];
+        double  longest  = 0.0;
+        for (size_t seq2 = 0; seq2 < nseqs; ++seq2) {
+            int tmp2 = actualToTemp[seq2];
+            double dist = ( tmp1 < 0 || tmp2 < 0 ) ? 0.0 : in.cell(tmp1, tmp2);
+            writeRow[seq2] = dist;
+            if (longest < dist) {
+                longest = dist;
+            }
+        }
+        row_longest[seq1] = longest;
+    }
+    double longest_dist = 0.0;
+    for (double longest : row_longest) {
+        longest_dist = max(longest_dist, longest);
+    }
+    return longest_dist;
+}
+
 double Alignment::readDist(const char *file_name, bool is_incremental,
                            double *dist_mat) {
     double longest_dist = 0.0;
 
     try {
+        if (BinaryDistanceMatrixFile::isBinaryDistanceMatrixFile(file_name)) {
+            longest_dist = readBinaryDist(file_name, is_incremental, dist_mat);
+            cout << "Distance matrix was read from " << file_name << endl;
+            return longest_dist;
+        }
         igzstream in;
         in.exceptions(ios::failbit | ios::badbit);
         in.open(file_name);
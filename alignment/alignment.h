@@ -74,17 +74,9 @@ public:
 std::ostream& operator<< (std::ostream& stream, const SymTestResult& res);
 
 #ifdef USE_HASH_MAP
-struct hashPattern {
-    size_t operator()(const vector<StateType> &sp) const {
-        size_t sum = 0;
-        for (Pattern::const_iterator it = sp.begin(); it != sp.end(); it++)
-            sum = (*it) + (sum << 6) + (sum << 16) - sum;
-        return sum;
-    }
-};
-typedef unordered_map<vector<StateType>, int, hashPattern> PatternIntMap;
+typedef unordered_map<PackedPattern, int, hashPackedPattern> PatternIntMap;
 #else
-typedef map<vector<StateType>, int> PatternIntMap;
+typedef map<PackedPattern, int> PatternIntMap;
 #endif
 
 
@@ -262,15 +254,77 @@ public:
     void extractDataBlock(NxsCharactersBlock *data_block);
 
     vector<Pattern> ordered_pattern;
+
+    /** index (into this alignment's patterns) of each pattern of ordered_pattern,
+        -1 for dummy patterns */
+    IntVector ordered_pattern_id;
     
     /** lower bound of sum parsimony scores for remaining pattern in ordered_pattern */
     UINT *pars_lower_bound;
 
     /** order pattern by number of character states and return in ptn_order
-        @param pat_type either PAT_INFORMATIVE or 0
+        @param pat_type either PAT_INFORMATIVE or PAT_VARIANT.
+               With PAT_INFORMATIVE, uninformative patterns (whose cost is
+               the same on every tree) are left out of ordered_pattern, and
+               their cost is added to singleton_parsimony_states instead
+               (only suitable for Fitch parsimony).
     */
     virtual void orderPatternByNumChars(int pat_type);
 
+    /**
+        charge the cost of an uninformative pattern to the taxa that have
+        its singleton states (in singleton_parsimony_states)
+        @param pat the pattern
+        @return false (and do nothing) if the pattern's cost could depend
+                on the tree (because it has ambiguous states)
+     */
+    bool foldUninformativePattern(const Pattern& pat);
+
+    /**
+        @return true if the last call to orderPatternByNumChars left
+                uninformative patterns out of ordered_pattern
+     */
+    bool hasFoldedUninformativePatterns() const;
+
+    /**
+        lay out the patterns of ordered_pattern over the bits of the Fitch
+        parsimony vectors. By default each pattern occupies pattern->frequency
+        consecutive bits. With Params::parsimony_weighted_patterns, each
+        pattern occupies one bit in every bit-plane k for which bit k of its
+        frequency is set; all words of plane k then carry weight 2^k, so the
+        number of bits follows the number of patterns rather than sites.
+        Called by orderPatternByNumChars().
+     */
+    void computeParsimonyBitLayout();
+
+    /**
+        @return number of bits (per state) that a Fitch parsimony vector
+                must have room for (before rounding up to SIMD width)
+     */
+    size_t getMaxNumParsimonyBits();
+
+    /** number of bits per state used by the Fitch parsimony kernels
+        (num_parsimony_sites, unless parsimony patterns are weighted) */
+    int num_parsimony_bits;
+
+    /** bits of pattern ptn of ordered_pattern are
+        pars_pattern_bits[pars_pattern_bit_start[ptn]..pars_pattern_bit_start[ptn+1]) */
+    IntVector pars_pattern_bit_start;
+
+    /** bit positions of the patterns of ordered_pattern (see pars_pattern_bit_start) */
+    IntVector pars_pattern_bits;
+
+    /** ordered_pattern index of the pattern whose first bit is at each bit
+        position of a Fitch parsimony vector, -1 for other bits */
+    IntVector pars_bit_pattern;
+
+    /** weight of each (32-bit) word of a Fitch parsimony vector */
+    std::vector<UINT> pars_word_weight;
+
+    /** for each (32-bit) word of a Fitch parsimony vector, the bits
+        not used by any pattern (to be filled with a dummy state) */
+    std::vector<UINT> pars_word_padding;
+
     /**
      * un-group site-patterns, i.e., making #sites = #patterns and pattern frequency = 1 for all patterns
      */
@@ -725,6 +779,14 @@ public:
      */
     template <class S> void printDist(const std::string&, S &out, double *dist_mat) const;
 
+    /**
+            write distance matrix into a binary, memory-mapped, distance file
+            (see BinaryDistanceMatrixFile, in utils/mappedfile.h)
+            @param file_name distance file name
+            @param dist_mat distance matrix
+     */
+    void printBinaryDist(const char *file_name, double *dist_mat) const;
+
     /**
             read distance matrix from a file in PHYLIP distance format
             @param file_name distance file name
@@ -740,6 +802,14 @@ public:
      */
     double readDist(igzstream &in, bool is_incremental, double *dist_mat);
 
+    /**
+            read distance matrix from a binary, memory-mapped, distance file
+            @param file_name distance file name
+            @param dist_mat distance matrix
+            @return the longest distance
+     */
+    double readBinaryDist(const char *file_name, bool is_incremental, double *dist_mat);
+
 
     /****************************************************************************
             some statistics
@@ -934,7 +1004,9 @@ public:
     vector<double*> site_state_freq;
 
     /** vector counting the number of singleton parsimony states
-        for each taxon (used in Parsimony Joining).*/
+        for each taxon, in the uninformative patterns that were left
+        out of ordered_pattern (see orderPatternByNumChars).  The Fitch
+        kernels start each leaf's subtree score with its count.*/
     std::vector<UINT> singleton_parsimony_states;
     
     /**
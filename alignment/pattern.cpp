@@ -100,3 +100,77 @@ bool Pattern::isAllGaps(int STATE_UNKNOWN) const {
     }
     return true;
 }
+
+namespace {
+    //Packed codes for the states that occur in DNA alignments:
+    //0-3 (A, C, G, T), and the ambiguous states (4 + mask - 1, for
+    //the masks of two or more nucleotides), with 18 (N) for unknown.
+    const int DNA_CODE_COUNT = 19;
+    const int dna_code[DNA_CODE_COUNT] = {
+         0,  1,  2,  3, -1, -1,  4, -1,  5,  6,
+         7, -1,  8,  9, 10, 11, 12, 13, 14
+    };
+    enum PatternEncoding {
+        ENCODE_2_BITS = 2, ENCODE_4_BITS = 4, ENCODE_DNA_4_BITS = 5,
+        ENCODE_8_BITS = 8, ENCODE_32_BITS = 32
+    };
+};
+
+PackedPattern::PackedPattern(const vector<StateType> &pat)
+    : length(static_cast<uint32_t>(pat.size())) {
+    StateType max_state = 0;
+    bool      is_dna    = true;
+    for (StateType state : pat) {
+        max_state = max(max_state, state);
+        is_dna    = is_dna && state < (StateType)DNA_CODE_COUNT
+                           && 0 <= dna_code[state];
+    }
+    int bits;
+    if (max_state < 4) {
+        encoding = ENCODE_2_BITS;     bits = 2;
+    } else if (max_state < 16) {
+        encoding = ENCODE_4_BITS;     bits = 4;
+    } else if (is_dna) {
+        encoding = ENCODE_DNA_4_BITS; bits = 4;
+    } else if (max_state < 256) {
+        encoding = ENCODE_8_BITS;     bits = 8;
+    } else {
+        encoding = ENCODE_32_BITS;    bits = 32;
+    }
+    const int per_word = 64 / bits;
+    words.resize((length + per_word - 1) / per_word, 0);
+    uint64_t* word = words.data();
+    int shift = 0;
+    for (StateType state : pat) {
+        uint64_t code = (encoding == ENCODE_DNA_4_BITS) ? dna_code[state] : state;
+        *word |= code << shift;
+        shift += bits;
+        if (shift == 64) {
+            ++word;
+            shift = 0;
+        }
+    }
+}
+
+bool PackedPattern::operator==(const PackedPattern &rhs) const {
+    return length == rhs.length && encoding == rhs.encoding
+        && words == rhs.words;
+}
+
+bool PackedPattern::operator<(const PackedPattern &rhs) const {
+    if (length != rhs.length) {
+        return length < rhs.length;
+    }
+    if (encoding != rhs.encoding) {
+        return encoding < rhs.encoding;
+    }
+    return words < rhs.words;
+}
+
+size_t PackedPattern::hash() const {
+    uint64_t h = (static_cast<uint64_t>(length) << 8) ^ encoding;
+    for (uint64_t w : words) {
+        h ^= w + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    }
+    return static_cast<size_t>(h ^ (h >> 32));
+}
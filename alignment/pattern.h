@@ -93,4 +93,44 @@ public:
     int num_chars;
 };
 
+/**
+	A site-pattern, packed into 64-bit words (2 bits per state, if every
+	state is one of 4 values; 4 bits, if it is one of 16 (including the
+	ambiguous DNA states); otherwise 8 or 32 bits), so that patterns can
+	be hashed and compared a word at a time.  How a pattern is packed
+	depends only on its states, so two patterns are equal if, and only
+	if, their packed forms are.
+*/
+class PackedPattern
+{
+public:
+	/**
+		constructor (deliberately not explicit, so that a Pattern
+		can be looked up directly in a PatternIntMap)
+		@param pat the states of the pattern
+	*/
+    PackedPattern(const vector<StateType> &pat);
+
+    PackedPattern() : length(0), encoding(0) {}
+
+    bool operator==(const PackedPattern &rhs) const;
+    bool operator<(const PackedPattern &rhs) const;
+
+	/**
+		@return a hash of the packed words
+	*/
+    size_t hash() const;
+
+private:
+    uint32_t length;   //number of states
+    uint32_t encoding; //bits per state (and, for 4 bits, which mapping)
+    vector<uint64_t> words;
+};
+
+struct hashPackedPattern {
+    size_t operator()(const PackedPattern &pat) const {
+        return pat.hash();
+    }
+};
+
 #endif
@@ -1710,25 +1710,25 @@ void SuperAlignment::countConstSite() {
 
 void SuperAlignment::orderPatternByNumChars(int pat_type) {
     const int UINT_BITS = sizeof(UINT)*8;
-    if (pat_type == PAT_INFORMATIVE)
-        num_parsimony_sites = num_informative_sites;
-    else
-        num_parsimony_sites = num_variant_sites;
-
-    int maxi = (num_parsimony_sites+UINT_BITS-1)/UINT_BITS;
-    delete [] pars_lower_bound;
-    pars_lower_bound = nullptr;
-    pars_lower_bound = new UINT[maxi+1];
-    memset(pars_lower_bound, 0, (maxi+1)*sizeof(UINT));
     size_t nseq = getNSeq();
-    
+    bool   unlinked = (Params::getInstance().partition_type == TOPO_UNLINKED);
+
     // compute ordered_pattern
     ordered_pattern.clear();
+    ordered_pattern_id.clear();
+    singleton_parsimony_states.clear();
+    if (pat_type == PAT_INFORMATIVE && !unlinked) {
+        singleton_parsimony_states.resize(nseq, 0);
+    }
+    num_parsimony_sites = 0;
+    // patterns of the super alignment are those of the partitions, concatenated
+    int ptn_offset = 0;
 //    UINT sum_scores[npart];
     for (size_t part  = 0; part != partitions.size(); ++part) {
         partitions[part]->orderPatternByNumChars(pat_type);
+        num_parsimony_sites += partitions[part]->num_parsimony_sites;
         // partial_partition
-        if (Params::getInstance().partition_type == TOPO_UNLINKED) {
+        if (unlinked) {
             continue;
         }
         for (auto pit = partitions[part]->ordered_pattern.begin();
@@ -1742,7 +1742,24 @@ void SuperAlignment::orderPatternByNumChars(int pat_type) {
                     pattern[j] = partitions[part]->STATE_UNKNOWN;
             ordered_pattern.push_back(pattern);
         }
+        for (auto id : partitions[part]->ordered_pattern_id) {
+            ordered_pattern_id.push_back(id < 0 ? -1 : id + ptn_offset);
+        }
+        ptn_offset += static_cast<int>(partitions[part]->getNPattern());
+        // costs of the partition's folded uninformative patterns
+        const std::vector<UINT>& part_singletons = partitions[part]->singleton_parsimony_states;
+        if (!singleton_parsimony_states.empty() && !part_singletons.empty()) {
+            for (int j = 0; j < nseq; j++)
+                if (taxa_index[j][part] >= 0)
+                    singleton_parsimony_states[j] += part_singletons[taxa_index[j][part]];
+        }
 //        sum_scores[part] = partitions[part]->pars_lower_bound[0];
     }
+    int maxi = (num_parsimony_sites+UINT_BITS-1)/UINT_BITS;
+    delete [] pars_lower_bound;
+    pars_lower_bound = nullptr;
+    pars_lower_bound = new UINT[maxi+1];
+    memset(pars_lower_bound, 0, (maxi+1)*sizeof(UINT));
     // TODO compute pars_lower_bound (lower bound of pars score for remaining patterns)
+    computeParsimonyBitLayout();
 }
@@ -4772,9 +4772,8 @@ void computeConsensusTree(const char *input_trees, int burnin,
          }*/
         scale /= sg.maxWeight();
     } else {
-        boot_trees.init(input_trees, rooted, burnin, max_count,
-                tree_weight_file);
-        boot_trees.convertSplits(sg, cutoff, SW_COUNT, weight_threshold);
+        boot_trees.readSplits(input_trees, rooted, burnin, max_count,
+                tree_weight_file, sg, cutoff, SW_COUNT, weight_threshold);
         scale /= boot_trees.sumTreeWeights();
         cout << sg.size() << " splits found" << endl;
     }
@@ -4858,13 +4857,12 @@ void computeConsensusNetwork(const char *input_trees, int burnin,
     bool rooted = false;
 
     // read the bootstrap tree file
-    MTreeSet boot_trees(input_trees, rooted, burnin, max_count,
-            tree_weight_file);
-
+    MTreeSet boot_trees;
     SplitGraph sg;
     //SplitIntMap hash_ss;
 
-    boot_trees.convertSplits(sg, cutoff, weight_summary, weight_threshold);
+    boot_trees.readSplits(input_trees, rooted, burnin, max_count,
+            tree_weight_file, sg, cutoff, weight_summary, weight_threshold);
 
     string out_file;
 
@@ -770,6 +770,253 @@ int mlecoef(double *cnts, double *rr, double bb, int kk,
 
 /* END CODE WAS TAKEN FROM CONSEL PROGRAM */
 
+/** number of bootstrap replicates scored together by computeRELLBlock */
+const int RELL_BLOCK_BOOT = 16;
+
+/** number of patterns per cache tile in computeRELLBlock */
+const intptr_t RELL_BLOCK_PTN = 256;
+
+/**
+ compute RELL log-likelihoods of a set of trees for a block of (at most
+ RELL_BLOCK_BOOT) bootstrap replicates, i.e. one block of the
+ (trees x patterns) by (patterns x replicates) matrix product.
+ Patterns are processed in tiles: the integer weights of a tile are converted
+ to double once and then reused for every tree.
+ Each score is summed over patterns in order, as a plain dot product would.
+ @param pattern_lhs pattern log-likelihoods, ntrees rows of lhs_stride values
+ @param boot_samples pattern frequencies, nboot rows of sample_stride values
+ @param weights scratch space of RELL_BLOCK_PTN*RELL_BLOCK_BOOT doubles
+ @param[out] rell_lhs RELL scores, ntrees rows of RELL_BLOCK_BOOT values
+ */
+static void computeRELLBlock(double *pattern_lhs, size_t ntrees, intptr_t lhs_stride,
+                             int *boot_samples, int nboot, intptr_t sample_stride,
+                             intptr_t nptn, double *weights, double *rell_lhs) {
+    memset(rell_lhs, 0, sizeof(double)*ntrees*RELL_BLOCK_BOOT);
+    for (intptr_t tile = 0; tile < nptn; tile += RELL_BLOCK_PTN) {
+        intptr_t tile_size = min(RELL_BLOCK_PTN, nptn - tile);
+        // transpose the weights of this tile to pattern-major order
+        for (int boot = 0; boot < RELL_BLOCK_BOOT; boot++) {
+            if (boot < nboot) {
+                int *sample = boot_samples + boot*sample_stride + tile;
+                for (intptr_t ptn = 0; ptn < tile_size; ptn++)
+                    weights[ptn*RELL_BLOCK_BOOT + boot] = sample[ptn];
+            } else {
+                for (intptr_t ptn = 0; ptn < tile_size; ptn++)
+                    weights[ptn*RELL_BLOCK_BOOT + boot] = 0.0;
+            }
+        }
+        for (size_t tid = 0; tid < ntrees; tid++) {
+            double *pattern_lh = pattern_lhs + tid*lhs_stride + tile;
+            double lh[RELL_BLOCK_BOOT];
+            memcpy(lh, rell_lhs + tid*RELL_BLOCK_BOOT, sizeof(lh));
+            for (intptr_t ptn = 0; ptn < tile_size; ptn++) {
+                double ptn_lh = pattern_lh[ptn];
+                double *ptn_weights = weights + ptn*RELL_BLOCK_BOOT;
+                for (int boot = 0; boot < RELL_BLOCK_BOOT; boot++)
+                    lh[boot] += ptn_lh * ptn_weights[boot];
+            }
+            memcpy(rell_lhs + tid*RELL_BLOCK_BOOT, lh, sizeof(lh));
+        }
+    }
+}
+
+/**
+ compute RELL log-likelihoods of a set of trees for all bootstrap replicates,
+ in parallel over blocks of replicates
+ @param pattern_lhs pattern log-likelihoods, ntrees rows of lhs_stride values
+ @param boot_samples pattern frequencies, nboot rows of nptn values
+ @param[out] rell_lhs RELL scores, ntrees rows of nboot values
+ */
+static void computeRELLScores(double *pattern_lhs, size_t ntrees, intptr_t lhs_stride,
+                              int *boot_samples, int nboot, intptr_t nptn, double *rell_lhs) {
+    int nblocks = (nboot + RELL_BLOCK_BOOT - 1) / RELL_BLOCK_BOOT;
+#ifdef _OPENMP
+#pragma omp parallel if(nblocks > 1)
+#endif
+    {
+    double *weights = aligned_alloc<double>(RELL_BLOCK_PTN*RELL_BLOCK_BOOT);
+    double *block_lhs = aligned_alloc<double>(ntrees*RELL_BLOCK_BOOT);
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+    for (int block = 0; block < nblocks; block++) {
+        int boot_start = block*RELL_BLOCK_BOOT;
+        int block_size = min(RELL_BLOCK_BOOT, nboot - boot_start);
+        computeRELLBlock(pattern_lhs, ntrees, lhs_stride, boot_samples + boot_start*nptn,
+                         block_size, nptn, nptn, weights, block_lhs);
+        for (size_t tid = 0; tid < ntrees; tid++)
+            memcpy(rell_lhs + tid*nboot + boot_start, block_lhs + tid*RELL_BLOCK_BOOT,
+                   block_size*sizeof(double));
+    }
+    aligned_free(block_lhs);
+    aligned_free(weights);
+    }
+}
+
+/** number of histogram bins per tree and scale, when AU test replicates are streamed */
+const int AU_HIST_BINS = 4096;
+
+/** number of replicates per scale that fix the histogram ranges */
+const int AU_PILOT_BOOT = 512;
+
+/**
+ distribution of the AU test statistic of each tree and scale, kept as a
+ histogram over a range fixed from a pilot sample of replicates, so that
+ the replicates themselves need not be stored. Values outside the range are
+ counted in the end bins.
+ */
+class AUStatHistogram {
+public:
+    /**
+     @param nhist number of histograms (#trees x #scales)
+     */
+    AUStatHistogram(size_t nhist) {
+        this->nhist = nhist;
+        lower = new double[nhist];
+        width = new double[nhist];
+        counts = new int[nhist*AU_HIST_BINS];
+        memset(counts, 0, sizeof(int)*nhist*AU_HIST_BINS);
+    }
+
+    ~AUStatHistogram() {
+        delete [] counts;
+        delete [] width;
+        delete [] lower;
+    }
+
+    /**
+     set the range of a histogram to the range of a pilot sample,
+     widened by half of it on each side, and add the sample
+     */
+    void addPilot(size_t id, double *values, int nvalues) {
+        double min_value = values[0], max_value = values[0];
+        for (int i = 1; i < nvalues; i++) {
+            min_value = min(min_value, values[i]);
+            max_value = max(max_value, values[i]);
+        }
+        double span = max_value - min_value;
+        if (span <= 0.0)
+            span = max(fabs(min_value), 1.0) * 1e-6;
+        lower[id] = min_value - 0.5*span;
+        width[id] = 2.0*span / AU_HIST_BINS;
+        for (int i = 0; i < nvalues; i++)
+            counts[id*AU_HIST_BINS + getBin(id, values[i])]++;
+    }
+
+    /** add a value to a histogram (safe to call from several threads) */
+    void add(size_t id, double value) {
+        int *count = counts + id*AU_HIST_BINS + getBin(id, value);
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+        (*count)++;
+    }
+
+    /** turn bin counts into cumulative counts, once all values are added */
+    void finish() {
+        for (size_t id = 0; id < nhist; id++) {
+            int *count = counts + id*AU_HIST_BINS;
+            for (int bin = 1; bin < AU_HIST_BINS; bin++)
+                count[bin] += count[bin-1];
+        }
+    }
+
+    /**
+     @return number of values <= t, interpolated linearly within bins
+     (the histogram counterpart of cntdist3)
+     */
+    double countBelow(size_t id, double t) {
+        int *cum = counts + id*AU_HIST_BINS;
+        double pos = (t - lower[id]) / width[id];
+        if (pos <= 0.0)
+            return 0.0;
+        if (pos >= AU_HIST_BINS)
+            return cum[AU_HIST_BINS-1];
+        int bin = static_cast<int>(pos);
+        double below = (bin > 0) ? cum[bin-1] : 0.0;
+        return below + (cum[bin] - below) * (pos - bin);
+    }
+
+    /** @return value below which a given number of values lie */
+    double quantile(size_t id, double count) {
+        int *cum = counts + id*AU_HIST_BINS;
+        int bin = static_cast<int>(upper_bound(cum, cum + AU_HIST_BINS, count) - cum);
+        if (bin >= AU_HIST_BINS)
+            return lower[id] + width[id]*AU_HIST_BINS;
+        double below = (bin > 0) ? cum[bin-1] : 0.0;
+        return lower[id] + width[id]*(bin + (count - below) / (cum[bin] - below));
+    }
+
+protected:
+
+    int getBin(size_t id, double value) {
+        double pos = (value - lower[id]) / width[id];
+        if (pos < 0.0)
+            return 0;
+        if (pos >= AU_HIST_BINS)
+            return AU_HIST_BINS-1;
+        return static_cast<int>(pos);
+    }
+
+    size_t nhist;
+    double *lower;
+    double *width;
+    int *counts;
+};
+
+/**
+ compute the AU test statistics of a block of multiscale bootstrap replicates:
+ for each tree, the rescaled RELL log-likelihood difference from the best
+ other tree
+ @param scale scale factor of the replicates
+ @param boot_start index of the first replicate in the block (0 is the original alignment at scale 1)
+ @param boot_samples scratch space of RELL_BLOCK_BOOT rows of maxnptn ints
+ @param weights scratch space for computeRELLBlock
+ @param[out] stats statistics, ntrees rows of RELL_BLOCK_BOOT values
+ */
+static void computeAUBlockStats(PhyloTree *tree, double *pattern_lhs, size_t ntrees,
+                                double scale, int boot_start, int block_size,
+                                int *boot_samples, double *weights, int *rstream, double *stats) {
+    intptr_t nptn = tree->getAlnNPattern();
+    intptr_t maxnptn = get_safe_upper_limit(nptn);
+    string str = "SCALE=" + convertDoubleToString(scale);
+    for (int boot = 0; boot < block_size; boot++) {
+        int *boot_sample = boot_samples + boot*maxnptn;
+        if (scale == 1.0 && boot_start + boot == 0) {
+            // 2018-10-23: get one of the bootstrap sample as the original alignment
+            tree->aln->getPatternFreq(boot_sample);
+        } else {
+            tree->aln->createBootstrapAlignment(boot_sample, str.c_str(), rstream);
+        }
+    }
+    computeRELLBlock(pattern_lhs, ntrees, maxnptn, boot_samples, block_size, maxnptn,
+                     nptn, weights, stats);
+
+    for (int boot = 0; boot < block_size; boot++) {
+        double max_lh = -DBL_MAX, second_max_lh = -DBL_MAX;
+        size_t max_tid = 0;
+        for (size_t tid = 0; tid < ntrees; tid++) {
+            // rescale lh
+            double tree_lh = stats[tid*RELL_BLOCK_BOOT + boot] / scale;
+            // find the max and second max
+            if (tree_lh > max_lh) {
+                second_max_lh = max_lh;
+                max_lh = tree_lh;
+                max_tid = tid;
+            } else if (tree_lh > second_max_lh)
+                second_max_lh = tree_lh;
+            stats[tid*RELL_BLOCK_BOOT + boot] = tree_lh;
+        }
+        // compute difference from max_lh
+        for (size_t tid = 0; tid < ntrees; tid++) {
+            if (tid != max_tid)
+                stats[tid*RELL_BLOCK_BOOT + boot] = max_lh - stats[tid*RELL_BLOCK_BOOT + boot];
+            else
+                stats[tid*RELL_BLOCK_BOOT + boot] = second_max_lh - max_lh;
+        }
+    }
+}
+
 /**
  @param tree_lhs RELL score matrix of size #trees x #replicates
  */
@@ -789,17 +1036,33 @@ void performAUTest(Params &params, PhyloTree *tree, double *pattern_lhs, vector<
     /* STEP 2: compute bootstrap proportion */
     size_t ntrees = info.size();
     int    nboot  = static_cast<int>(params.topotest_replicates);
-    //    double nboot_inv = 1.0 / nboot;
     
     intptr_t nptn = tree->getAlnNPattern();
     intptr_t maxnptn = get_safe_upper_limit(nptn);
     
-    //    double *bp = new double[ntrees*nscales];
-    //    memset(bp, 0, sizeof(double)*ntrees*nscales);
-    
+    // replicates are scored a block at a time: (scale, block) pairs are
+    // shared out among threads. Either every statistic is kept (and sorted),
+    // or, when asked for or when they would not fit in memory, they are
+    // accumulated into per-tree histograms, after a pilot sample of
+    // AU_PILOT_BOOT replicates per scale has fixed the histogram ranges.
+    int nblocks = (nboot + RELL_BLOCK_BOOT - 1) / RELL_BLOCK_BOOT;
+    double mem_limit = params.max_mem_is_in_bytes ? params.max_mem_size : getMemorySize()/2;
+    size_t exact_size = ntrees*nscales*nboot*sizeof(double);
+    bool streaming = params.au_test_streaming || exact_size > mem_limit;
+    int npilot = streaming ? min(nboot, AU_PILOT_BOOT) : nboot;
+    int pilot_blocks = (npilot + RELL_BLOCK_BOOT - 1) / RELL_BLOCK_BOOT;
+    npilot = min(nboot, pilot_blocks*RELL_BLOCK_BOOT);
+
     double *treelhs;
-    cout << (ntrees*nscales*nboot*sizeof(double) >> 20) << " MB required for AU test" << endl;
-    treelhs = new double[ntrees*nscales*nboot];
+    AUStatHistogram *hist = NULL;
+    if (streaming) {
+        cout << ((ntrees*nscales*(npilot*sizeof(double) + AU_HIST_BINS*sizeof(int))) >> 20)
+             << " MB required for AU test (streaming)" << endl;
+        hist = new AUStatHistogram(ntrees*nscales);
+    } else {
+        cout << (exact_size >> 20) << " MB required for AU test" << endl;
+    }
+    treelhs = new double[ntrees*nscales*npilot];
     if (!treelhs)
         outError("Not enough memory to perform AU test!");
     
@@ -816,79 +1079,70 @@ void performAUTest(Params &params, PhyloTree *tree, double *pattern_lhs, vector<
     int *rstream = randstream;
 #endif
 
-    int *boot_sample = aligned_alloc<int>(maxnptn);
-    memset(boot_sample, 0, maxnptn*sizeof(int));
-    
-    double *boot_sample_dbl = aligned_alloc<double>(maxnptn);
+    int *boot_samples = aligned_alloc<int>(RELL_BLOCK_BOOT*maxnptn);
+    memset(boot_samples, 0, RELL_BLOCK_BOOT*maxnptn*sizeof(int));
+    double *weights = aligned_alloc<double>(RELL_BLOCK_PTN*RELL_BLOCK_BOOT);
+    double *stats = aligned_alloc<double>(ntrees*RELL_BLOCK_BOOT);
     
+    // kept replicates (all of them, or the pilot sample)
 #ifdef _OPENMP
 #pragma omp for schedule(dynamic)
 #endif
-    for (int k = 0; k < nscales; ++k) {
-        string str = "SCALE=" + convertDoubleToString(r[k]);
-        for (size_t boot = 0; boot < nboot; boot++) {
-            if (r[k] == 1.0 && boot == 0) {
-                // 2018-10-23: get one of the bootstrap sample as the original alignment
-                tree->aln->getPatternFreq(boot_sample);
-            }
-            else {
-                tree->aln->createBootstrapAlignment(boot_sample, str.c_str(), rstream);
-            }
-            for (intptr_t ptn = 0; ptn < maxnptn; ptn++) {
-                boot_sample_dbl[ptn] = boot_sample[ptn];
-            }
-            double max_lh = -DBL_MAX, second_max_lh = -DBL_MAX;
-            int max_tid = -1;
-            for (int tid = 0; tid < ntrees; tid++) {
-                double *pattern_lh = pattern_lhs + (tid*maxnptn);
-                double tree_lh;
-                if (params.SSE == LK_386) {
-                    tree_lh = 0.0;
-                    for (intptr_t ptn = 0; ptn < nptn; ptn++)
-                        tree_lh += pattern_lh[ptn] * boot_sample_dbl[ptn];
-                } else {
-                    tree_lh = tree->dotProductDoubleCall(pattern_lh, boot_sample_dbl, static_cast<int>(nptn));
-                }
-                // rescale lh
-                tree_lh /= r[k];
-                
-                // find the max and second max
-                if (tree_lh > max_lh) {
-                    second_max_lh = max_lh;
-                    max_lh = tree_lh;
-                    max_tid = tid;
-                } else if (tree_lh > second_max_lh)
-                    second_max_lh = tree_lh;
-                
-                treelhs[(tid*nscales+k)*nboot + boot] = tree_lh;
-            }
-            
-            // compute difference from max_lh
-            for (size_t tid = 0; tid < ntrees; tid++) {
-                if (tid != max_tid) {
-                    treelhs[(tid*nscales+k)*nboot + boot] = max_lh - treelhs[(tid*nscales+k)*nboot + boot];
-                }
-                else {
-                    treelhs[(tid*nscales+k)*nboot + boot] = second_max_lh - max_lh;
-                }
-            //            bp[k*ntrees+max_tid] += nboot_inv;
-            }
-        } // for boot
-        
-        // sort the replicates
-        for (size_t tid = 0; tid < ntrees; tid++) {
-            quicksort<double,int>(treelhs + (tid*nscales+k)*nboot, 0, static_cast<int>(nboot)-1);
+    for (int task = 0; task < nscales*pilot_blocks; task++) {
+        int k = task / pilot_blocks;
+        int boot_start = (task % pilot_blocks) * RELL_BLOCK_BOOT;
+        int block_size = min(RELL_BLOCK_BOOT, npilot - boot_start);
+        computeAUBlockStats(tree, pattern_lhs, ntrees, r[k], boot_start, block_size,
+                            boot_samples, weights, rstream, stats);
+        for (size_t tid = 0; tid < ntrees; tid++)
+            memcpy(treelhs + (tid*nscales+k)*npilot + boot_start, stats + tid*RELL_BLOCK_BOOT,
+                   block_size*sizeof(double));
+    }
+
+    if (streaming) {
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+        for (int id = 0; id < ntrees*nscales; id++)
+            hist->addPilot(id, treelhs + id*npilot, npilot);
+
+        // remaining replicates go straight into the histograms
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+        for (int task = 0; task < nscales*(nblocks-pilot_blocks); task++) {
+            int k = task / (nblocks-pilot_blocks);
+            int boot_start = (pilot_blocks + task % (nblocks-pilot_blocks)) * RELL_BLOCK_BOOT;
+            int block_size = min(RELL_BLOCK_BOOT, nboot - boot_start);
+            computeAUBlockStats(tree, pattern_lhs, ntrees, r[k], boot_start, block_size,
+                                boot_samples, weights, rstream, stats);
+            for (size_t tid = 0; tid < ntrees; tid++)
+                for (int boot = 0; boot < block_size; boot++)
+                    hist->add(tid*nscales+k, stats[tid*RELL_BLOCK_BOOT + boot]);
         }
-        
-    } // for scale
+    } else {
+        // sort the replicates
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+        for (int id = 0; id < ntrees*nscales; id++)
+            quicksort<double,int>(treelhs + id*nboot, 0, nboot-1);
+    }
     
-    aligned_free(boot_sample_dbl);
-    aligned_free(boot_sample);
+    aligned_free(stats);
+    aligned_free(weights);
+    aligned_free(boot_samples);
     
 #ifdef _OPENMP
     finish_random(rstream);
     }
 #endif
+
+    if (streaming) {
+        hist->finish();
+        delete [] treelhs;
+        treelhs = NULL;
+    }
     
     //    if (verbose_mode >= VB_MED) {
     //        cout << "scale";
@@ -913,8 +1167,12 @@ void performAUTest(Params &params, PhyloTree *tree, double *pattern_lhs, vector<
     double *this_bp = new double[nscales];
     cout << "TreeID\tAU\tRSS\td\tc" << endl;
     for (size_t tid = 0; tid < ntrees; tid++) {
-        double *this_stat = treelhs + tid*nscales*nboot;
-        double xn = this_stat[(nscales/2)*nboot + nboot/2], x;
+        double *this_stat = (hist) ? NULL : treelhs + tid*nscales*nboot;
+        double xn, x;
+        if (hist)
+            xn = hist->quantile(tid*nscales + nscales/2, nboot/2);
+        else
+            xn = this_stat[(nscales/2)*nboot + nboot/2];
         double c, d; // c, d in original paper
         int idf0 = -2;
         double z = 0.0, z0 = 0.0, thp = 0.0, th = 0.0, ze = 0.0, ze0 = 0.0;
@@ -928,7 +1186,10 @@ void performAUTest(Params &params, PhyloTree *tree, double *pattern_lhs, vector<
             x = xn;
             int num_k = 0;
             for (size_t k = 0; k < nscales; k++) {
-                this_bp[k] = cntdist3(this_stat + k*nboot, nboot, x) / nboot;
+                if (hist)
+                    this_bp[k] = hist->countBelow(tid*nscales + k, x) / nboot;
+                else
+                    this_bp[k] = cntdist3(this_stat + k*nboot, nboot, x) / nboot;
                 if (this_bp[k] <= 0 || this_bp[k] >= 1) {
                     cc[k] = w[k] = 0.0;
                 } else {
@@ -1044,12 +1305,137 @@ void performAUTest(Params &params, PhyloTree *tree, double *pattern_lhs, vector<
     delete [] this_bp;
     delete [] w;
     delete [] cc;
+    delete hist;
+    delete [] treelhs;
     
     cout << "Time for AU test: " << getRealTime() - start_time << " seconds" << endl;
     //    delete [] bp;
 }
 
 
+/**
+ evaluate a user tree that has just been read into a tree: fit it to the
+ alignment and the model, then optimize its branch lengths (unless they
+ are fixed)
+ @param[out] pattern_lh pattern log-likelihoods of the tree (if not NULL)
+ @param maxnptn size of pattern_lh
+ @return log-likelihood of the tree
+ */
+static double evaluateUserTree(Params &params, PhyloTree *tree, double *pattern_lh, intptr_t maxnptn) {
+    if (!tree->findNodeName(tree->aln->getSeqName(0))) {
+        outError("Taxon " + tree->aln->getSeqName(0) + " not found in tree");
+    }
+    
+    if (tree->rooted && tree->getModel()->isReversible()) {
+        if (tree->leafNum != tree->aln->getNSeq()+1)
+            outError("Tree does not have same number of taxa as alignment");
+        tree->convertToUnrooted();
+    } else if (!tree->rooted && !tree->getModel()->isReversible()) {
+        if (tree->leafNum != tree->aln->getNSeq())
+            outError("Tree does not have same number of taxa as alignment");
+        tree->convertToRooted();
+    }
+    tree->setAlignment(tree->aln);
+    tree->setRootNode(params.root);
+    if (tree->isSuperTree()) {
+        ((PhyloSuperTree*) tree)->mapTrees();
+    }
+    
+    tree->initializeAllPartialLh();
+    tree->fixNegativeBranch(false);
+    if (params.fixed_branch_length) {
+        tree->setCurScore(tree->computeLikelihood());
+    } else if (params.topotest_optimize_model) {
+        tree->getModelFactory()->optimizeParameters(BRLEN_OPTIMIZE, false,
+                                                    params.modelEps, 0.0001, tree);
+        tree->setCurScore(tree->computeLikelihood());
+    } else {
+        tree->setCurScore(tree->optimizeAllBranches(100, 0.001));
+    }
+    if (pattern_lh) {
+        double curScore = tree->getCurScore();
+        memset(pattern_lh, 0, maxnptn*sizeof(double));
+        tree->computePatternLikelihood(pattern_lh, &curScore);
+    }
+    return tree->getCurScore();
+}
+
+/**
+ evaluate the distinct trees of a tree set concurrently. Each thread reads
+ the next tree into a worker tree of its own, which borrows the model, rate
+ and model factory of the main tree (their parameters are not reoptimized).
+ @param in tree set, positioned at the first tree
+ @param nworkers number of worker threads
+ @param[out] tree_logl log-likelihood of each distinct tree
+ @param[out] tree_strings each distinct tree, as it is printed to the .trees file
+ @param[out] tree_flags, tree_precisions stream format that printing each tree leaves behind
+ @param[out] pattern_lhs pattern log-likelihoods, a row of maxnptn values per
+ distinct tree (if not NULL)
+ */
+static void evaluateTreesConcurrently(istream &in, Params &params, IQTree *tree,
+                                      IntVector &distinct_ids, int nworkers,
+                                      DoubleVector &tree_logl, StrVector &tree_strings,
+                                      vector<ios_base::fmtflags> &tree_flags, IntVector &tree_precisions,
+                                      double *pattern_lhs, intptr_t maxnptn) {
+    size_t next_index = 0;
+    int next_tid = 0;
+#ifdef _OPENMP
+#pragma omp parallel num_threads(nworkers)
+#endif
+    {
+    PhyloTree *worker = new PhyloTree(tree->aln);
+    worker->showNoProgress();
+    worker->setParams(&params);
+    worker->optimize_by_newton = params.optimize_by_newton;
+    if (tree->isUsingSankoffParsimony()) {
+        worker->loadCostMatrixFile(params.sankoff_cost_file);
+    }
+    worker->setLikelihoodKernel(params.SSE);
+    worker->setNumThreads(1);
+    worker->setModelFactory(tree->getModelFactory());
+    worker->setModel(tree->getModel());
+    worker->setRate(tree->getRate());
+    
+    for (;;) {
+        int tid = -1;
+#ifdef _OPENMP
+#pragma omp critical (evaluate_trees)
+#endif
+        {
+            // skip over trees identical to earlier ones
+            for (; next_index < distinct_ids.size() && distinct_ids[next_index] >= 0; next_index++) {
+                char ch;
+                do {
+                    in >> ch;
+                } while (!in.eof() && ch != ';');
+            }
+            if (next_index < distinct_ids.size()) {
+                next_index++;
+                tid = next_tid++;
+                worker->freeNode();
+                worker->readTree(in, worker->rooted);
+            }
+        }
+        if (tid < 0) {
+            break;
+        }
+        double *pattern_lh = (pattern_lhs) ? pattern_lhs + tid*maxnptn : NULL;
+        tree_logl[tid] = evaluateUserTree(params, worker, pattern_lh, maxnptn);
+        ostringstream ostr;
+        worker->printTree(ostr);
+        tree_strings[tid] = ostr.str();
+        tree_flags[tid] = ostr.flags();
+        tree_precisions[tid] = static_cast<int>(ostr.precision());
+    }
+    
+    // reset model & rate so that they are not deleted
+    worker->setModel(NULL);
+    worker->setModelFactory(NULL);
+    worker->setRate(NULL);
+    delete worker;
+    }
+}
+
 void evaluateTrees(string treeset_file, Params &params, IQTree *tree, vector<TreeInfo> &info, IntVector &distinct_ids)
 {
     if (treeset_file.empty())
@@ -1162,6 +1548,35 @@ void evaluateTrees(string treeset_file, Params &params, IQTree *tree, vector<Tre
         if (!(max_lh = new double[params.topotest_replicates]))
             outError(ERR_NO_MEMORY);
     }
+    // evaluate trees concurrently, when asked to and when each tree can
+    // be evaluated without changing the (shared) model
+    int nworkers = static_cast<int>(min((size_t)params.topotest_workers, ntrees));
+    if (nworkers > 1 && (tree->isSuperTree() || params.topotest_optimize_model)) {
+        outWarning("--test-workers is not supported with partition models"
+                   " or --estimate-model; evaluating one tree at a time");
+        nworkers = 1;
+    }
+    DoubleVector tree_logl;
+    StrVector tree_strings;
+    vector<ios_base::fmtflags> tree_flags;
+    IntVector tree_precisions;
+    double *tree_pattern_lhs = NULL; // pattern log-likelihoods of each tree, if evaluated concurrently
+    if (nworkers > 1) {
+        cout << "Evaluating trees with " << nworkers << " workers" << endl;
+        tree_logl.resize(ntrees);
+        tree_strings.resize(ntrees);
+        tree_flags.resize(ntrees);
+        tree_precisions.resize(ntrees);
+        if (pattern_lhs) {
+            tree_pattern_lhs = pattern_lhs;
+        } else if (pattern_lh || params.print_site_lh) {
+            tree_pattern_lhs = aligned_alloc<double>(ntrees*maxnptn);
+        }
+        evaluateTreesConcurrently(in, params, tree, distinct_ids, nworkers,
+                                  tree_logl, tree_strings,
+                                  tree_flags, tree_precisions, tree_pattern_lhs, maxnptn);
+    }
+    
     int tree_index, tid, tid2;
     info.resize(ntrees);
     //for (MTreeSet::iterator it = trees.begin(); it != trees.end(); it++, tree_index++) {
@@ -1170,6 +1585,8 @@ void evaluateTrees(string treeset_file, Params &params, IQTree *tree, vector<Tre
         cout << "Tree " << tree_index + 1;
         if (distinct_ids[tree_index] >= 0) {
             cout << " / identical to tree " << distinct_ids[tree_index]+1 << endl;
+            if (nworkers > 1)
+                continue;
             // ignore tree
             char ch;
             do {
@@ -1177,82 +1594,66 @@ void evaluateTrees(string treeset_file, Params &params, IQTree *tree, vector<Tre
             } while (!in.eof() && ch != ';');
             continue;
         }
-        tree->freeNode();
-        tree->readTree(in, tree->rooted);
-        if (!tree->findNodeName(tree->aln->getSeqName(0))) {
-            outError("Taxon " + tree->aln->getSeqName(0) + " not found in tree");
-        }
-        
-        if (tree->rooted && tree->getModel()->isReversible()) {
-            if (tree->leafNum != tree->aln->getNSeq()+1)
-                outError("Tree does not have same number of taxa as alignment");
-            tree->convertToUnrooted();
-        } else if (!tree->rooted && !tree->getModel()->isReversible()) {
-            if (tree->leafNum != tree->aln->getNSeq())
-                outError("Tree does not have same number of taxa as alignment");
-            tree->convertToRooted();
-        }
-        tree->setAlignment(tree->aln);
-        tree->setRootNode(params.root);
-        if (tree->isSuperTree()) {
-            ((PhyloSuperTree*) tree)->mapTrees();
-        }
-        
-        tree->initializeAllPartialLh();
-        tree->fixNegativeBranch(false);
-        if (params.fixed_branch_length) {
-            tree->setCurScore(tree->computeLikelihood());
-        } else if (params.topotest_optimize_model) {
-            tree->getModelFactory()->optimizeParameters(BRLEN_OPTIMIZE, false,
-                                                        params.modelEps, 0.0001, tree);
-            tree->setCurScore(tree->computeLikelihood());
+        double logl;
+        double *this_pattern_lh = pattern_lh;
+        if (nworkers > 1) {
+            logl = tree_logl[tid];
+            treeout << "[ tree " << tree_index+1 << " lh=" << logl << " ]" << tree_strings[tid];
+            // leave the stream formatted as printTree would have
+            treeout.flags(tree_flags[tid]);
+            treeout.precision(tree_precisions[tid]);
+            if (tree_pattern_lhs) {
+                this_pattern_lh = tree_pattern_lhs + tid*maxnptn;
+            }
         } else {
-            tree->setCurScore(tree->optimizeAllBranches(100, 0.001));
+            tree->freeNode();
+            tree->readTree(in, tree->rooted);
+            logl = evaluateUserTree(params, tree, pattern_lh, maxnptn);
+            treeout << "[ tree " << tree_index+1 << " lh=" << logl << " ]";
+            tree->printTree(treeout);
+            if (pattern_lh && (params.do_weighted_test || params.do_au_test))
+                memcpy(pattern_lhs + tid*maxnptn, pattern_lh, maxnptn*sizeof(double));
         }
-        treeout << "[ tree " << tree_index+1 << " lh=" << tree->getCurScore() << " ]";
-        tree->printTree(treeout);
         treeout << endl;
         if (params.print_tree_lh)
-            scoreout << tree->getCurScore() << endl;
+            scoreout << logl << endl;
         
-        cout << " / LogL: " << tree->getCurScore() << endl;
+        cout << " / LogL: " << logl << endl;
         
-        if (pattern_lh) {
-            double curScore = tree->getCurScore();
-            memset(pattern_lh, 0, maxnptn*sizeof(double));
-            tree->computePatternLikelihood(pattern_lh, &curScore);
-            if (params.do_weighted_test || params.do_au_test)
-                memcpy(pattern_lhs + tid*maxnptn, pattern_lh, maxnptn*sizeof(double));
-        }
         if (params.print_site_lh) {
             string tree_name = "Tree" + convertIntToString(tree_index+1);
-            printSiteLh(site_lh_file.c_str(), tree, pattern_lh, true, tree_name.c_str());
+            printSiteLh(site_lh_file.c_str(), tree, this_pattern_lh, true, tree_name.c_str());
         }
         if (params.print_partition_lh) {
             string tree_name = "Tree" + convertIntToString(tree_index+1);
-            printPartitionLh(part_lh_file.c_str(), tree, pattern_lh, true, tree_name.c_str());
+            printPartitionLh(part_lh_file.c_str(), tree, this_pattern_lh, true, tree_name.c_str());
         }
-        info[tid].logl = tree->getCurScore();
+        info[tid].logl = logl;
         
         if (!params.topotest_replicates || ntrees <= 1) {
             tid++;
             continue;
         }
-        // now compute RELL scores
-        orig_tree_lh[tid] = tree->getCurScore();
-        double *tree_lhs_offset = tree_lhs + (tid*params.topotest_replicates);
-        for (size_t boot = 0; boot < params.topotest_replicates; boot++) {
-            double lh = 0.0;
-            int *this_boot_sample = boot_samples + (boot*nptn);
-            for (intptr_t ptn = 0; ptn < nptn; ptn++)
-                lh += pattern_lh[ptn] * this_boot_sample[ptn];
-            tree_lhs_offset[boot] = lh;
+        // now compute RELL scores (of all trees at once, if evaluated concurrently)
+        orig_tree_lh[tid] = logl;
+        if (nworkers <= 1) {
+            double *tree_lhs_offset = tree_lhs + (tid*params.topotest_replicates);
+            computeRELLScores(pattern_lh, 1, maxnptn, boot_samples, params.topotest_replicates,
+                              nptn, tree_lhs_offset);
         }
         tid++;
     }
     
     ASSERT(tid == ntrees);
     
+    if (nworkers > 1 && params.topotest_replicates && ntrees > 1) {
+        computeRELLScores(tree_pattern_lhs, ntrees, maxnptn, boot_samples, params.topotest_replicates,
+                          nptn, tree_lhs);
+    }
+    if (tree_pattern_lhs != pattern_lhs) {
+        aligned_free(tree_pattern_lhs);
+    }
+    
     if (params.topotest_replicates && ntrees > 1) {
         double *tree_probs = new double[ntrees];
         memset(tree_probs, 0, ntrees*sizeof(double));
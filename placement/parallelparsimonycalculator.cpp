@@ -1,20 +1,64 @@
 //
 // parallelparsimonycalculator.cpp
 // ===============================
-// Parallel calculation of parsimony (parallelizes across nodes a given
-// "distance" from the branch for which parsimony is being calculated)
-// (so, in large trees, close-to-linear scaling should be possible,
-// regardless of the number of threads of execution).
+// Parallel calculation of parsimony (each partial parsimony view is
+// a task, that becomes runnable as soon as the views it depends on
+// have been calculated; runnable tasks are executed by the OpenMP
+// runtime's work-stealing task scheduler, so threads are kept busy
+// even when the tree is badly unbalanced, as caterpillar-like trees are).
 //
 // Created by James Barbetti on 08-Oct-2020.
 //
 
 #include "parallelparsimonycalculator.h"
+#include <unordered_map>
+
+//A TaskGraph is a set of (out of date) views, each with a count of the
+//(out of date) views it depends on that have not been calculated yet,
+//and a linked list of "edges" to the views that depend on it.
+//A view might be depended upon by more than one other view in the graph
+//(if views on both sides of a node were scheduled), so edges are kept
+//in a list rather than as a single "parent" index per view.
+//
+struct ParallelParsimonyCalculator::TaskGraph {
+    std::vector<WorkItem> items;       //views to calculate
+    std::vector<int>      pending;     //per view: count of unfinished dependencies
+    std::vector<intptr_t> first_edge;  //per view: first edge to a dependent view (or -1)
+    std::vector<intptr_t> edge_target; //per edge: index of the dependent view
+    std::vector<intptr_t> next_edge;   //per edge: next edge from the same view (or -1)
+    std::unordered_map<PhyloNeighbor*, intptr_t> index_of;
+    intptr_t              progress;    //views calculated since progress last reported
+    bool                  reporting;   //true if progress is to be reported to the tree
+
+    TaskGraph(): progress(0), reporting(false) {}
+    
+    intptr_t add(PhyloNeighbor* dad_branch, PhyloNode* dad) {
+        auto found = index_of.find(dad_branch);
+        if (found != index_of.end()) {
+            return found->second;
+        }
+        intptr_t index = static_cast<intptr_t>(items.size());
+        index_of[dad_branch] = index;
+        items.emplace_back(dad_branch, dad);
+        pending.push_back(0);
+        first_edge.push_back(-1);
+        return index;
+    }
+    
+    void addDependency(intptr_t dependency, intptr_t dependent) {
+        edge_target.push_back(dependent);
+        next_edge.push_back(first_edge[dependency]);
+        first_edge[dependency] = static_cast<intptr_t>(edge_target.size()) - 1;
+        ++pending[dependent];
+    }
+};
 
 ParallelParsimonyCalculator::ParallelParsimonyCalculator(PhyloTree& phylo_tree,
-                                                         bool report_progress)
+                                                         bool report_progress,
+                                                         ParsimonyExecution exec)
     : tree(phylo_tree), task_to_start(nullptr)
     , task_in_progress(nullptr), report_progress_to_tree(report_progress)
+    , execution(exec)
     {}
 
 int ParallelParsimonyCalculator::schedulePartialParsimony
@@ -66,10 +110,10 @@ double ParallelParsimonyCalculator::parsimonyLink4Cost(PhyloNode* a, PhyloNode*
         calculate();
     }
     double score = 0;
-    score += tree.computePartialParsimonyOutOfTree(inputs[0], inputs[1], buffer1);
-    score += tree.computePartialParsimonyOutOfTree(inputs[2], inputs[3], buffer2);
+    score += tree.computePartialParsimonyOutOfTree(inputs[0], inputs[1], buffer1, execution);
+    score += tree.computePartialParsimonyOutOfTree(inputs[2], inputs[3], buffer2, execution);
     int branchCost;
-    tree.computeParsimonyOutOfTree(buffer1, buffer2, &branchCost);
+    tree.computeParsimonyOutOfTree(buffer1, buffer2, &branchCost, execution);
     score += branchCost;
     return score;
 }
@@ -77,7 +121,7 @@ double ParallelParsimonyCalculator::parsimonyLink4Cost(PhyloNode* a, PhyloNode*
 double ParallelParsimonyCalculator::parsimonyLink4CostOutOfTree
        ( const PhyloTree& tree, PhyloNode* a, PhyloNode* b, PhyloNode* c,
          PhyloNode* d, PhyloNode* e, PhyloNode* f,
-         UINT* buffer1, UINT* buffer2) {
+         UINT* buffer1, UINT* buffer2, ParsimonyExecution exec) {
     std::vector<UINT*> inputs;
     inputs.resize(4, nullptr);
 
@@ -94,10 +138,10 @@ double ParallelParsimonyCalculator::parsimonyLink4CostOutOfTree
        else if (x==f) inputs[3] = d->findNeighbor(f)->get_partial_pars();
     }
     double score = 0;
-    score += tree.computePartialParsimonyOutOfTree(inputs[0], inputs[1], buffer1);
-    score += tree.computePartialParsimonyOutOfTree(inputs[2], inputs[3], buffer2);
+    score += tree.computePartialParsimonyOutOfTree(inputs[0], inputs[1], buffer1, exec);
+    score += tree.computePartialParsimonyOutOfTree(inputs[2], inputs[3], buffer2, exec);
     int branchCost;
-    tree.computeParsimonyOutOfTree(buffer1, buffer2, &branchCost);
+    tree.computeParsimonyOutOfTree(buffer1, buffer2, &branchCost, exec);
     score += branchCost;
     return score;
 }
@@ -127,42 +171,99 @@ int  ParallelParsimonyCalculator::computeAllParsimony
 
 void ParallelParsimonyCalculator::computeReverseParsimony(PhyloNode* first,
                                                           PhyloNode* second) {
-    std::vector <PhyloBranch> stuffToDo;
-    stuffToDo.emplace_back(first, second);
-    stuffToDo.emplace_back(second, first);
-    while (!stuffToDo.empty()) {
-        std::vector <PhyloBranch> stuffToDoNext;
-        intptr_t r = 0;
-        intptr_t w = 0;
-        for (;r<static_cast<intptr_t>(stuffToDo.size()); ++r) {
-            PhyloNode* first  = stuffToDo[r].first;
-            PhyloNode* second = stuffToDo[r].second;
-            FOR_EACH_ADJACENT_PHYLO_NODE(first, second, it, back) {
-                stuffToDoNext.emplace_back(back, first);
-            }
-            //Only keep the (PhyloNeighbor*, PhyloNode*)
-            //pairs where we need to compute reverse parsimony now.
-            stuffToDo[w]       = stuffToDo[r];
-            PhyloNeighbor* nei = first->findNeighbor(second);
-            w                 += ( nei->isParsimonyComputed() ? 0 : 1 );
-        }
-        stuffToDo.resize(w);
-        PhyloBranch* firstItem = stuffToDo.data();
+    intptr_t progress = 0;
+    #ifdef _OPENMP
+    #pragma omp parallel if(execution==PARS_SITE_PARALLEL)
+    #pragma omp single
+    #endif
+    {
         #ifdef _OPENMP
-        #pragma omp parallel for schedule(dynamic)
+        #pragma omp task firstprivate(first, second)
         #endif
-        for (intptr_t i = 0; i < w; ++i) {
-            PhyloBranch*   item = firstItem + i;
-            PhyloNeighbor* nei  = item->first->findNeighbor(item->second);
-            tree.computePartialParsimony(nei, item->first);
-            if (report_progress_to_tree && (i%1000) == 999) {
+        runReverseTask(first, second, progress);
+        runReverseTask(second, first, progress);
+    }
+    if (report_progress_to_tree) {
+        tree.trackProgress(static_cast<double>(progress));
+    }
+}
+
+void ParallelParsimonyCalculator::runReverseTask(PhyloNode* first, PhyloNode* second,
+                                                 intptr_t& progress) {
+    for (;;) {
+        PhyloNeighbor* nei = first->findNeighbor(second);
+        if (!nei->isParsimonyComputed()) {
+            tree.computePartialParsimony(nei, first, PARS_BRANCH_PARALLEL);
+            if (report_progress_to_tree) {
+                intptr_t done;
+                #ifdef _OPENMP
+                #pragma omp atomic capture
+                #endif
+                done = ++progress;
+                if ((done%1000)==0) {
+                    tree.trackProgress(1000.0);
+                }
+            }
+        }
+        //Views that look back toward first (from its other neighbors)
+        //depend on the view just calculated.  All but one of them are
+        //spawned as tasks; the last is handled here.
+        PhyloNode* next = nullptr;
+        FOR_EACH_ADJACENT_PHYLO_NODE(first, second, it, back) {
+            if (next != nullptr) {
+                PhyloNode* spawned = next;
+                #ifdef _OPENMP
+                #pragma omp task firstprivate(spawned, first) shared(progress)
+                #endif
+                runReverseTask(spawned, first, progress);
+            }
+            next = back;
+        }
+        if (next == nullptr) {
+            return;
+        }
+        second = first;
+        first  = next;
+    }
+}
+
+void ParallelParsimonyCalculator::runTask(TaskGraph& graph, intptr_t task) {
+    while (0 <= task) {
+        WorkItem& item = graph.items[task];
+        tree.computePartialParsimony(item.first, item.second, PARS_BRANCH_PARALLEL);
+        if (graph.reporting) {
+            intptr_t done;
+            #ifdef _OPENMP
+            #pragma omp atomic capture
+            #endif
+            done = ++graph.progress;
+            if ((done%1000)==0) {
                 tree.trackProgress(1000.0);
             }
         }
-        if (report_progress_to_tree) {
-            tree.trackProgress(static_cast<double>(w%1000));
+        //Run the first dependent view that is now ready as a
+        //continuation (in this thread), and spawn tasks for the rest.
+        intptr_t continuation = -1;
+        for (intptr_t e = graph.first_edge[task]; 0 <= e; e = graph.next_edge[e]) {
+            intptr_t dependent = graph.edge_target[e];
+            int      still_pending;
+            #ifdef _OPENMP
+            #pragma omp atomic capture
+            #endif
+            still_pending = --graph.pending[dependent];
+            if (still_pending != 0) {
+                continue;
+            }
+            if (continuation < 0) {
+                continuation = dependent;
+            } else {
+                #ifdef _OPENMP
+                #pragma omp task firstprivate(dependent) shared(graph)
+                #endif
+                runTask(graph, dependent);
+            }
         }
-        std::swap(stuffToDo, stuffToDoNext);
+        task = continuation;
     }
 }
 
@@ -179,51 +280,47 @@ void ParallelParsimonyCalculator::calculate(intptr_t start_index,
         task_in_progress = task_description;
     }
     
-    //1. Find work to do at a lower level
-    for (intptr_t  i=stop_index-1; i>=start_index; --i) {
-        auto item = workToDo[i];
-        PhyloNeighbor* dad_branch = item.first;
-        PhyloNode*     dad        = item.second;
+    //1. Build the task graph: the views that were asked for, and every
+    //   out of date view that they (transitively) depend upon.
+    TaskGraph graph;
+    for (intptr_t i=start_index; i<stop_index; ++i) {
+        graph.add(workToDo[i].first, workToDo[i].second);
+    }
+    for (intptr_t i=0; i<static_cast<intptr_t>(graph.items.size()); ++i) {
+        PhyloNeighbor* dad_branch = graph.items[i].first;
+        PhyloNode*     dad        = graph.items[i].second;
         PhyloNode*     node       = dad_branch->getNode();
         FOR_EACH_PHYLO_NEIGHBOR(node, dad, it, nei) {
-            schedulePartialParsimony(nei, node);
+            if (!nei->isParsimonyComputed()) {
+                graph.addDependency(graph.add(nei, node), i);
+            }
         }
     }
+    graph.reporting = task_in_progress != nullptr || report_progress_to_tree;
     
-    //2. Do it, and then forget about it
-    calculate(stop_index, "");
-    workToDo.resize(stop_index);
-    
-    //3. Do the actual parsimony calculations at the
-    //   current level (this doesn't change the content
-    //   of workToDo so workToDo's contents can be
-    //   processed with a parallel pointer loop).
-    WorkItem* item_data = workToDo.data();
     if (task_to_start != nullptr) {
-        double estimate = static_cast<double>(workToDo.size());
+        double estimate = static_cast<double>(graph.items.size());
         tree.initProgress( estimate, task_to_start, "", "" );
         task_to_start = nullptr;
     }
+    
+    //2. Run every view that doesn't depend on any other (out of date)
+    //   view; the rest are run as the views they depend on complete.
+    intptr_t task_count = static_cast<intptr_t>(graph.items.size());
     #ifdef _OPENMP
-    #pragma omp parallel for schedule(dynamic)
+    #pragma omp parallel if(execution==PARS_SITE_PARALLEL && 1<task_count)
+    #pragma omp single
     #endif
-    for (intptr_t i = start_index; i < stop_index; ++i) {
-        WorkItem*      item       = item_data + i;
-        PhyloNeighbor* dad_branch = item->first;
-        PhyloNode*     dad        = item->second;
-        
-        tree.computePartialParsimony(dad_branch, dad);
-        
-        if (task_in_progress != nullptr || report_progress_to_tree) {
-            intptr_t j = i - start_index;
-            if ((j%1000)==999) {
-                tree.trackProgress(1000.0);
-            }
+    for (intptr_t i = 0; i < task_count; ++i) {
+        if (graph.pending[i] == 0) {
+            #ifdef _OPENMP
+            #pragma omp task firstprivate(i) shared(graph)
+            #endif
+            runTask(graph, i);
         }
     }
-    if (task_in_progress != nullptr || report_progress_to_tree) {
-        double work_done = (double)((stop_index - start_index)%1000);
-        tree.trackProgress(work_done);
+    if (graph.reporting) {
+        tree.trackProgress(static_cast<double>(graph.progress%1000));
     }
     workToDo.resize(start_index);
     if (tasked) {
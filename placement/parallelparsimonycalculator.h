@@ -15,13 +15,43 @@ private:
     typedef std::pair<PhyloNeighbor*, PhyloNode*> WorkItem;
     std::vector <WorkItem> workToDo;  //A *stack* (rather than a queue)
                                       //of work to do ( partial parsimonies to calculate).
-    std::vector <int> workDone;       //A *stack* of boundaries
+    struct TaskGraph;                 //Partial parsimonies to calculate, and
+                                      //the dependencies between them
+                                      //(see parallelparsimonycalculator.cpp)
     
     const char* task_to_start;
     const char* task_in_progress;
     bool        report_progress_to_tree;
+    ParsimonyExecution execution;     //PARS_BRANCH_PARALLEL if the caller is
+                                      //itself running in a parallel loop
+                                      //(so the work here must be done serially)
+public:
+    explicit ParallelParsimonyCalculator(PhyloTree& phylo_tree, bool report_back=false,
+                                         ParsimonyExecution exec=PARS_SITE_PARALLEL);
+
+private:
+    /**
+     Calculate a partial parsimony, in a task graph, and then (as a
+     continuation, in the same thread) any views that depended on it, that
+     are now ready to run, spawning tasks for any others (so that idle
+     threads can steal them).
+     @param graph the task graph
+     @param task the index of the task (in graph) to run
+     */
+    void runTask(TaskGraph& graph, intptr_t task);
+
+    /**
+     Calculate reverse partial parsimony for the view from first to second
+     (if it is out of date), and then for each view that looks toward it
+     (spawning a task for every such view but one, which is handled
+     as a continuation, in the same thread).
+     @param first  the node the view is from
+     @param second the node the view is toward
+     @param progress a count of views calculated (for progress reporting)
+     */
+    void runReverseTask(PhyloNode* first, PhyloNode* second, intptr_t& progress);
+
 public:
-    explicit ParallelParsimonyCalculator(PhyloTree& phylo_tree, bool report_back=false);
 
     /**
      Indicate a PhyloNeighbor whose partial parsimony is to be calculated
@@ -73,7 +103,10 @@ public:
     /**
      Calculate the partial parsimonies of the PhyloNeighbor instances that have
      been passed to computePartialParsimony(), since the last time calculate() was called
-     (if it ever was).
+     (if it ever was).  The out-of-date views they depend on are calculated too.
+     Each view becomes runnable as soon as the views it depends on have been
+     calculated (there is no level-by-level synchronization), and the runnable
+     views are executed as OpenMP tasks (so idle threads steal work from busy ones).
      @param start_index the "top" of the stack (the point at which to begin calculation)
      @param taskDescription a description of the task; may point to an empty string
      */
@@ -109,7 +142,8 @@ public:
     static double parsimonyLink4CostOutOfTree
                   ( const PhyloTree& tree, PhyloNode* a, PhyloNode* b, PhyloNode* c,
                     PhyloNode* d, PhyloNode* e, PhyloNode* f,
-                    UINT* buffer1, UINT* buffer2);
+                    UINT* buffer1, UINT* buffer2,
+                    ParsimonyExecution exec = PARS_SITE_PARALLEL);
     
 };
 
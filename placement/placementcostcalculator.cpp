@@ -40,9 +40,11 @@ void ParsimonyCostCalculator::assessPlacementCost(PhyloTree& phylo_tree,
                                  const TaxonToPlace& taxon,
                                  PossiblePlacement& placement)  const {
     auto target = placement.getTarget();
+    //Placements are always costed in a loop that is already parallel
     phylo_tree.computeParsimonyOutOfTree( target->getParsimonyBlock(),
                                           taxon.getParsimonyBlock(),
-                                         &placement.parsimony_score);
+                                         &placement.parsimony_score,
+                                          PARS_BRANCH_PARALLEL);
     placement.score      = placement.parsimony_score;
     placement.lenToNode1 = target->first->findNeighbor(target->second)->length * 0.5;
     placement.lenToNode2 = placement.lenToNode1;
@@ -111,10 +111,11 @@ void TargetBranch::dumpNeighbor(VerboseMode level, const char* name,
 double TargetBranch::computeState(PhyloTree& phylo_tree,
                                   double& tree_parsimony_score,
                                   intptr_t target_branch_index,
-                                  LikelihoodBlockPairs &blocks) {
+                                  LikelihoodBlockPairs &blocks,
+                                  ParsimonyExecution exec) {
     PhyloNeighbor* neigh1   = getLeftNeighbor();
     PhyloNeighbor* neigh2   = getRightNeighbor();
-    ParallelParsimonyCalculator c(phylo_tree, false);
+    ParallelParsimonyCalculator c(phylo_tree, false, exec);
     parsimony_dirtiness    += c.schedulePartialParsimony(neigh1, first);
     parsimony_dirtiness    += c.schedulePartialParsimony(neigh2, second);
     c.calculate();
@@ -124,14 +125,14 @@ double TargetBranch::computeState(PhyloTree& phylo_tree,
         if (0<parsimony_dirtiness) {
             connection_cost = phylo_tree.computePartialParsimonyOutOfTree
                               (neigh1->partial_pars, neigh2->partial_pars,
-                               partial_pars);
+                               partial_pars, exec);
         }
     } else {
         if (tree_parsimony_score==-1) {
             int branch_cost_dummy = 0;
             tree_parsimony_score  = phylo_tree.computeParsimonyOutOfTree
                                     ( neigh1->partial_pars, neigh2->partial_pars,
-                                      &branch_cost_dummy);
+                                      &branch_cost_dummy, exec);
         }
         connection_cost = tree_parsimony_score;
     }
@@ -596,7 +597,8 @@ BenefitPair TargetBranch::getPartialDisconnectionBenefit(const PhyloTree& phylo_
 }
 
 double TargetBranch::getForwardConnectionCost(const PhyloTree& phylo_tree,
-                                              const TargetBranch& other_branch) const {
+                                              const TargetBranch& other_branch,
+                                              ParsimonyExecution exec) const {
     //Letter-T connection
     //If this branch is CD, and the other is AB, returns the cost of
     //connecting A     B the subtree C-D by linking A and B to C.
@@ -613,13 +615,14 @@ double TargetBranch::getForwardConnectionCost(const PhyloTree& phylo_tree,
            //what the existing view from C would be
     int    updatedCDCost;
     phylo_tree.computeParsimonyOutOfTree(view_from_D, view_to_D,
-                                         &updatedCDCost);
+                                         &updatedCDCost, exec);
     
     return (double)updatedCDCost;
 }
 
 double TargetBranch::getBackwardConnectionCost(const PhyloTree& phylo_tree,
-                                               const TargetBranch& other_branch) const {
+                                               const TargetBranch& other_branch,
+                                               ParsimonyExecution exec) const {
     //Letter-T connection
     //If this branch is CD, and the other is EF, returns the cost of
     //connecting    C the subtree D-C by linking E and F to D (if 
@@ -634,7 +637,7 @@ double TargetBranch::getBackwardConnectionCost(const PhyloTree& phylo_tree,
     auto view_from_C = other_branch.partial_pars;
     auto view_to_C   = second->findNeighbor(first)->partial_pars;
     int  updatedCDCost;
-    phylo_tree.computeParsimonyOutOfTree(view_from_C, view_to_C, &updatedCDCost);
+    phylo_tree.computeParsimonyOutOfTree(view_from_C, view_to_C, &updatedCDCost, exec);
     
     return (double)updatedCDCost;
 }
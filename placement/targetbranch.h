@@ -117,7 +117,8 @@ public:
     double computeState (PhyloTree& phylo_tree,
                          double& tree_parsimony_score,
                          intptr_t target_branch_index,
-                         LikelihoodBlockPairs &blocks);
+                         LikelihoodBlockPairs &blocks,
+                         ParsimonyExecution exec = PARS_SITE_PARALLEL);
     void   dumpNeighbor (VerboseMode level, const char* prefix,
                          PhyloTree& phylo_tree, PhyloNeighbor* nei) const;
     void   updateMapping(intptr_t branch_id,
@@ -168,9 +169,11 @@ public:
     double      getFullConnectionCost    (const PhyloTree& phylo_tree,
                                           const TargetBranch& other_branch) const;
     double      getForwardConnectionCost (const PhyloTree& phylo_tree,
-                                          const TargetBranch& other_branch) const;
+                                          const TargetBranch& other_branch,
+                                          ParsimonyExecution exec = PARS_SITE_PARALLEL) const;
     double      getBackwardConnectionCost(const PhyloTree& phylo_tree,
-                                          const TargetBranch& other_branch) const;
+                                          const TargetBranch& other_branch,
+                                          ParsimonyExecution exec = PARS_SITE_PARALLEL) const;
     bool        isExternalBranch() const;
     
     void        setParsimonyLength(PhyloTree& tree); //set parsimony length on
@@ -49,8 +49,9 @@ void TaxonToPlace::initialize(BlockAllocator* ba, int interior_id, int leaf_id,
 
 void TaxonToPlace::computeParsimony(PhyloTree* tree) {
     //Assumes new_leaf is the first neighbor of new_interior
+    //(and that this is called from a loop, over taxa, that is already parallel)
     PhyloNeighbor* nei = new_interior->firstNeighbor();
-    tree->computePartialParsimony(nei, new_interior);
+    tree->computePartialParsimony(nei, new_interior, PARS_BRANCH_PARALLEL);
 }
 
 TaxonToPlace::~TaxonToPlace() = default;
@@ -10,6 +10,135 @@
 #include "candidateset.h"
 #include "utils/MPIHelper.h"
 
+/**
+ * splitmix64 finalizer, used to draw a pseudo-random 64-bit key for every
+ * taxon and to mix split hashes into the topology fingerprint
+ */
+static inline uint64_t mixSplitHash(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+void CandidateTopology::encode(MTree *tree) {
+    leafNum = static_cast<int>(tree->leafNum);
+    parent.assign(leafNum, -1);
+    length.assign(leafNum, 0.0);
+    splits.clear();
+
+    // iterative pre-order traversal, internal nodes are numbered on the fly
+    vector<pair<Node*, Node*> > node_stack;
+    IntVector index_stack;
+    node_stack.push_back(make_pair(tree->root, (Node*)NULL));
+    index_stack.push_back(-1);
+    while (!node_stack.empty()) {
+        Node *node = node_stack.back().first;
+        Node *dad = node_stack.back().second;
+        int dad_index = index_stack.back();
+        node_stack.pop_back();
+        index_stack.pop_back();
+        int index;
+        if (node->isLeaf()) {
+            index = node->id;
+            ASSERT(index >= 0 && index < leafNum);
+        } else {
+            index = static_cast<int>(parent.size());
+            parent.push_back(-1);
+            length.push_back(0.0);
+        }
+        parent[index] = dad_index;
+        if (dad)
+            length[index] = dad->findNeighbor(node)->length;
+        FOR_NEIGHBOR_IT(node, dad, it) {
+            node_stack.push_back(make_pair((*it)->node, node));
+            index_stack.push_back(index);
+        }
+    }
+    vector<uint64_t> node_splits;
+    getNodeSplits(node_splits);
+    splits.reserve(parent.size() - leafNum);
+    for (auto split : node_splits)
+        if (split)
+            splits.push_back(split);
+    std::sort(splits.begin(), splits.end());
+    key = mixSplitHash(leafNum);
+    for (auto split : splits)
+        key = mixSplitHash(key ^ split);
+}
+
+void CandidateTopology::getNodeSplits(vector<uint64_t> &node_splits) const {
+    // internal nodes are numbered in pre-order, so processing leaves first and
+    // then internal nodes backwards visits every node after all its descendants
+    size_t num_nodes = parent.size();
+    vector<uint64_t> hash(num_nodes, 0);
+    IntVector num_taxa(num_nodes, 0);
+    vector<bool> has_taxon0(num_nodes, false);
+    uint64_t all_taxa = 0;
+    for (int i = 0; i < leafNum; i++) {
+        hash[i] = mixSplitHash(i);
+        num_taxa[i] = 1;
+        all_taxa ^= hash[i];
+    }
+    has_taxon0[0] = true;
+    node_splits.assign(num_nodes, 0);
+    for (size_t j = 0; j < num_nodes; j++) {
+        int index = static_cast<int>(j < leafNum ? j : num_nodes - 1 - (j - leafNum));
+        int dad_index = parent[index];
+        if (dad_index < 0)
+            continue;
+        hash[dad_index] ^= hash[index];
+        num_taxa[dad_index] += num_taxa[index];
+        if (has_taxon0[index])
+            has_taxon0[dad_index] = true;
+        // skip trivial splits
+        if (num_taxa[index] < 2 || num_taxa[index] > leafNum - 2)
+            continue;
+        // normalize to the side not containing taxon 0
+        node_splits[index] = has_taxon0[index] ? (all_taxa ^ hash[index]) : hash[index];
+    }
+}
+
+void CandidateTopology::getSplit(int node, Split &sp) const {
+    // collect the subtree below node: descendants have larger indices
+    // except for leaves, so a single pass marking nodes suffices
+    vector<bool> below(parent.size(), false);
+    below[node] = true;
+    for (size_t i = node+1; i < parent.size(); i++)
+        if (parent[i] >= 0 && below[parent[i]])
+            below[i] = true;
+    sp.setNTaxa(leafNum);
+    for (int i = 0; i < leafNum; i++)
+        if (i == node || (parent[i] >= 0 && below[parent[i]]))
+            sp.addTaxon(i);
+    if (sp.shouldInvert())
+        sp.invert();
+}
+
+void CandidateTopology::decode(MTree *tree, Alignment *aln, bool rooted) const {
+    NodeVector nodes(parent.size());
+    for (int i = 0; i < nodes.size(); i++) {
+        if (i >= leafNum)
+            nodes[i] = tree->newNode(i);
+        else if (rooted && i == leafNum-1)
+            nodes[i] = tree->newNode(i, ROOT_NAME);
+        else
+            nodes[i] = tree->newNode(i, aln->getSeqName(i).c_str());
+    }
+    tree->root = NULL;
+    for (int i = 0; i < nodes.size(); i++) {
+        if (parent[i] < 0) {
+            tree->root = nodes[i];
+            continue;
+        }
+        nodes[i]->addNeighbor(nodes[parent[i]], length[i]);
+        nodes[parent[i]]->addNeighbor(nodes[i], length[i]);
+    }
+    ASSERT(tree->root);
+    tree->leafNum = leafNum;
+    tree->nodeNum = static_cast<int>(nodes.size());
+}
+
 void CandidateSet::init(Alignment *alignment, int max_size) {
     this->aln     = alignment;
     this->maxSize = max_size;
@@ -21,12 +150,18 @@ CandidateSet::~CandidateSet() {
 CandidateSet::CandidateSet() : CheckpointFactory() {
     aln = NULL;
     numStableSplits = 0;
+    candSplits.setNumTree(0);
     this->maxSize = Params::getInstance().maxCandidates;
 }
 
 void CandidateSet::initTrees(CandidateSet& candSet) {
     int curMaxSize = this->maxSize;
+    clearCandidateSplits();
     *this = candSet;
+    // do not share split objects with candSet, they are rebuilt on demand
+    candSplits.clear();
+    candSplitHashes.clear();
+    candSplits.setNumTree(0);
     setMaxSize(curMaxSize);
 }
 
@@ -76,14 +211,16 @@ string CandidateSet::getRandTopTree(int numTopTrees) {
     ASSERT(!empty());
     if (empty())
         return "";
-    int id = random_int(min(numTopTrees, (int) size()));
-    for (reverse_iterator it = rbegin(); it != rend(); it++) {
-        if (id == 0)
-            return it->second.tree;
-        id--;
-    }
-    ASSERT(0);
-    return "";
+    return getRandTopCandidate(numTopTrees).tree;
+}
+
+const CandidateTree &CandidateSet::getRandTopCandidate(int numTopTrees, int *rstream) {
+    ASSERT(!empty());
+    int id = random_int(min(numTopTrees, (int) size()), rstream);
+    reverse_iterator it = rbegin();
+    for (; id > 0; id--)
+        it++;
+    return it->second;
 }
 
 StrVector CandidateSet::getBestTreeStrings(int numTree) {
@@ -121,65 +258,73 @@ StrVector CandidateSet::getBestTreeStringsForProcess(int numTree) {
     return res;
 }
 
-void CandidateSet::addCandidateSplits(string treeString) {
-    StrVector taxaNames = aln->getSeqNames();
-    MTree tree(treeString, taxaNames, Params::getInstance().is_rooted);
-    SplitGraph allSplits;
-    tree.convertSplits(allSplits);
-    for (auto splitIt = allSplits.begin();
-         splitIt != allSplits.end(); splitIt++) {
-        int value;
-        Split *sp = candSplits.findSplit(*splitIt, value);
-        if (sp != NULL) {
-            sp->setWeight(value + 1);
-            candSplits.setValue(sp, value + 1);
+void CandidateSet::addCandidateSplits(const CandidateTopology &topology) {
+    vector<uint64_t> node_splits;
+    topology.getNodeSplits(node_splits);
+    int numTree = candSplits.getNumTree() + 1;
+    for (int node = 0; node < node_splits.size(); node++) {
+        if (!node_splits[node])
+            continue;
+        auto it = candSplitHashes.find(node_splits[node]);
+        if (it != candSplitHashes.end()) {
+            // avoid hashing the split bitset again
+            it->second->second++;
         } else {
-            sp = new Split(*(*splitIt));
-            sp->setWeight(1);
+            Split *sp = new Split;
+            topology.getSplit(node, *sp);
+            sp->setWeight(1.0 / numTree);
             candSplits.insertSplit(sp, 1);
+            candSplitHashes[node_splits[node]] = &*candSplits.find(sp);
         }
     }
-    candSplits.setNumTree(candSplits.getNumTree() + 1);
-}
-
-void CandidateSet::removeCandidateSplits(string treeString) {
-    StrVector taxaNames = aln->getSeqNames();
-    MTree tree(treeString, taxaNames, Params::getInstance().is_rooted);
-    SplitGraph allSplits;
-    tree.convertSplits(allSplits);
-    for (auto splitIt = allSplits.begin();
-         splitIt != allSplits.end(); splitIt++) {
-        int value = 0;
-        Split *sp;
-        sp = candSplits.findSplit(*splitIt, value);
-        if (value == 0) {
-            cout << "Cannot find split: ";
-            (*splitIt)->report(cout);
-            exit(1);
-        } else {
-            ASSERT(sp->getWeight() >= 1);
-            if (sp->getWeight() > 1) {
-                sp->setWeight(value - 1);
-            } else {
-                candSplits.eraseSplit(*splitIt);
-            }
+    candSplits.setNumTree(numTree);
+}
+
+void CandidateSet::removeCandidateSplits(const CandidateTopology &topology) {
+    for (auto split : topology.splits) {
+        auto it = candSplitHashes.find(split);
+        if (it == candSplitHashes.end()) {
+            outError("Cannot find split of a candidate tree");
+        }
+        ASSERT(it->second->second >= 1);
+        if (--it->second->second == 0) {
+            Split *sp = it->second->first;
+            candSplits.eraseSplit(sp);
+            candSplitHashes.erase(it);
+            delete sp;
         }
     }
     candSplits.setNumTree(candSplits.getNumTree() - 1);
 }
 
+bool CandidateSet::isTrackingSplits() {
+    return (Params::getInstance().fixStableSplits || Params::getInstance().adaptPertubation) &&
+        candSplits.getNumTree() == size();
+}
+
+void CandidateSet::clearCandidateSplits() {
+    for (auto it = candSplitHashes.begin(); it != candSplitHashes.end(); it++)
+        delete it->second->first;
+    candSplitHashes.clear();
+    candSplits.clear();
+    candSplits.setNumTree(0);
+}
+
 int CandidateSet::getNumStableSplits() const {
     return numStableSplits;
 }
 
 
 string CandidateSet::getNextCandTree() {
-    string tree;
+    return getNextCandidate().tree;
+}
+
+CandidateTree CandidateSet::getNextCandidate() {
     ASSERT(!empty());
     if (parentTrees.empty()) {
         initParentTrees();
     }
-    tree = parentTrees.top();
+    CandidateTree tree = parentTrees.top();
     parentTrees.pop();
     return tree;
 }
@@ -189,7 +334,7 @@ void CandidateSet::initParentTrees() {
         int count = Params::getInstance().popSize;
         for (auto i = rbegin();
              i != rend() && count > 0; i++, count--) {
-            parentTrees.push(i->second.tree);
+            parentTrees.push(i->second);
         }
     }
 }
@@ -198,32 +343,50 @@ int CandidateSet::update(string newTree, double newScore) {
     // Do not update candidate set if the new tree has worse score than the
     // worst tree in the candidate set
     // cout << size() << " " << maxSize << endl;
+    auto front = begin();
+    if ( size() >= maxSize && front!=end() && newScore < front->first ) {
+        return -2;
+    }
+    CandidateTopology topology;
+    encodeTreeString(newTree, topology);
+    return update(newTree, topology, newScore);
+}
+
+int CandidateSet::update(string newTree, const CandidateTopology &newTopology, double newScore) {
     auto front = begin();
     if ( size() >= maxSize && front!=end() && newScore < front->first ) {
         return -2;
     }
     CandidateTree candidate;
     candidate.score    = newScore;
-    candidate.topology = convertTreeString(newTree);
+    candidate.topology = newTopology;
     candidate.tree     = newTree;
 
     int treePos;
     CandidateSet::iterator candidateTreeIt;
+    uint64_t key = newTopology.key;
 
-    if (treeTopologyExist(candidate.topology)) {
+    if (treeTopologyExist(key)) {
         // cout << "Existed" << endl;
         // update new score if it is better the old score
-        double oldScore = topologies[candidate.topology];
+        double oldScore = topologies[key];
         if (oldScore < newScore) {
-            removeCandidateTree(candidate.topology);
+            // same topology, so the candidate splits stay the same
+            bool trackSplits = isTrackingSplits();
+            removeCandidateTree(key);
             insert(CandidateSet::value_type(newScore, candidate));
-            topologies[candidate.topology] = newScore;
+            topologies[key] = newScore;
+            if (trackSplits)
+                addCandidateSplits(newTopology);
         }
         ASSERT(topologies.size() == size());
         return -1;
     }
+    bool trackSplits = isTrackingSplits();
     candidateTreeIt = insert(CandidateSet::value_type(newScore, candidate));
-    topologies[candidate.topology] = newScore;
+    topologies[key] = newScore;
+    if (trackSplits)
+        addCandidateSplits(newTopology);
 
     if (size() > maxSize) {
         removeWorstTree();
@@ -254,10 +417,7 @@ double CandidateSet::getBestScore() {
 
 string CandidateSet::convertTreeString(string treeString, int format) {
     MTree mtree;
-    stringstream str;
-    str << treeString;
-    str.seekg(0, ios::beg);
-    mtree.readTree(str, Params::getInstance().is_rooted);
+    mtree.readTreeBuffer(treeString.c_str(), treeString.length(), Params::getInstance().is_rooted);
     mtree.assignLeafID();
     string rootName = "0";
     mtree.root = mtree.findLeafName(rootName);
@@ -267,6 +427,20 @@ string CandidateSet::convertTreeString(string treeString, int format) {
     return ostr.str();
 }
 
+void CandidateSet::encodeTreeString(const string &tree, CandidateTopology &topology) {
+    MTree mtree;
+    bool is_rooted = Params::getInstance().is_rooted;
+    mtree.readTreeBuffer(tree.c_str(), tree.length(), is_rooted);
+    // leaf names are taxon IDs, except the virtual root which already has the last ID
+    NodeVector taxa;
+    mtree.getTaxa(taxa);
+    for (auto node : taxa) {
+        if (node->name != ROOT_NAME)
+            node->id = atoi(node->name.c_str());
+    }
+    topology.encode(&mtree);
+}
+
 string CandidateSet::getTopology(string tree) {
 //	PhyloTree mtree;
 //	mtree.rooted = params->is_rooted;
@@ -290,7 +464,7 @@ string CandidateSet::getTopology(string tree) {
     return ostr.str();
 }
 
-double CandidateSet::getTopologyScore(string topology) {
+double CandidateSet::getTopologyScore(uint64_t topology) {
     ASSERT(topologies.find(topology) != topologies.end());
     return topologies[topology];
 }
@@ -298,6 +472,7 @@ double CandidateSet::getTopologyScore(string topology) {
 void CandidateSet::clear() {
     multimap<double, CandidateTree>::clear();
     clearTopologies();
+    clearCandidateSplits();
 }
 
 void CandidateSet::clearTopologies() {
@@ -332,25 +507,28 @@ void CandidateSet::getAllTrees(StrVector&    trees,
     }
 }
 
-bool CandidateSet::treeTopologyExist(string topo) {
+bool CandidateSet::treeTopologyExist(uint64_t topo) {
     return (topologies.find(topo) != topologies.end());
 }
 
 bool CandidateSet::treeExist(string tree) {
-    return treeTopologyExist(convertTreeString(tree));
+    CandidateTopology topology;
+    encodeTreeString(tree, topology);
+    return treeTopologyExist(topology.key);
 }
 
-CandidateSet::iterator CandidateSet::getCandidateTree(string topology) {
+CandidateSet::iterator CandidateSet::getCandidateTree(uint64_t topology) {
     for (auto rit = rbegin(); rit != rend(); rit++) {
-        if (rit->second.topology == topology)
+        if (rit->second.topology.key == topology)
             return --(rit.base());
     }
     return end();
 }
 
-void CandidateSet::removeCandidateTree(string topology) {
+void CandidateSet::removeCandidateTree(uint64_t topology) {
     bool removed = false;
     double treeScore;
+    bool trackSplits = isTrackingSplits();
     // Find the score of the topology
     treeScore = topologies[topology];
     // Remove the topology
@@ -360,7 +538,9 @@ void CandidateSet::removeCandidateTree(string topology) {
     treeItPair = equal_range(treeScore);
     CandidateSet::iterator it;
     for (it = treeItPair.first; it != treeItPair.second; ++it) {
-        if (it->second.topology == topology) {
+        if (it->second.topology.key == topology) {
+            if (trackSplits)
+                removeCandidateSplits(it->second.topology);
             erase(it);
             removed = true;
             break;
@@ -370,39 +550,24 @@ void CandidateSet::removeCandidateTree(string topology) {
 }
 
 void CandidateSet::removeWorstTree() {
-    topologies.erase(begin()->second.topology);
+    if (isTrackingSplits())
+        removeCandidateSplits(begin()->second.topology);
+    topologies.erase(begin()->second.topology.key);
     erase(begin());
 }
 
 int CandidateSet::computeSplitOccurences(double supportThreshold) {
-    candSplits.clear();
-    candSplits.setNumTree(static_cast<int>(size()));
-
-    /* Store all splits in the best trees in candSplits.
-     * The variable numTree in SpitInMap is the number of trees, from which the splits are converted.
-     */
-    CandidateSet::iterator treeIt;
-    for (treeIt = begin(); treeIt != end(); treeIt++) {
-        MTree tree(treeIt->second.tree, Params::getInstance().is_rooted);
-        SplitGraph splits;
-        tree.convertSplits(splits);
-        SplitGraph::iterator itg;
-        for (itg = splits.begin(); itg != splits.end(); itg++) {
-            int value;
-            Split *sp = candSplits.findSplit(*itg, value);
-            if (sp != NULL) {
-                int newHashWeight = value + 1;
-                double newSupport = (double) newHashWeight / (double) candSplits.getNumTree();
-                sp->setWeight(newSupport);
-                candSplits.setValue(sp, newHashWeight);
-            }
-            else {
-                sp = new Split(*(*itg));
-                sp->setWeight(1.0 / (double) candSplits.getNumTree());
-                candSplits.insertSplit(sp, 1);
-            }
+    if (candSplits.getNumTree() != size()) {
+        // out of sync, e.g. trees were added while splits were not tracked
+        clearCandidateSplits();
+        for (auto treeIt = begin(); treeIt != end(); treeIt++) {
+            addCandidateSplits(treeIt->second.topology);
         }
     }
+    // the number of trees changes whenever a tree is added, so refresh all support values
+    for (auto it = candSplits.begin(); it != candSplits.end(); it++) {
+        it->first->setWeight((double) it->second / (double) candSplits.getNumTree());
+    }
     int newNumStableSplits = countStableSplits(supportThreshold);
     if (verbose_mode >= VB_MED) {
         cout << ((double) newNumStableSplits / (aln->getNSeq() - 3)) * 100;
@@ -467,7 +632,7 @@ void CandidateSet::printTrees(string suffix) {
     outLHs.precision(15);
     for (reverse_iterator rit = rbegin(); rit != rend(); rit++) {
         outLHs << rit->first << endl;
-        outTrees << rit->second.topology << endl;
+        outTrees << convertTreeString(rit->second.tree) << endl;
     }
     outTrees.close();
     outLHs.close();
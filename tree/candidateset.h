@@ -32,6 +32,76 @@
 
 class IQTree;
 
+/**
+ * Compact binary encoding of an (unrooted) tree topology.
+ * Nodes are indexed with leaves first (by taxon ID), followed by internal
+ * nodes in pre-order from the root of the encoded tree. Each split is hashed as the XOR of random
+ * taxon keys on the side not containing taxon 0, so that two trees have
+ * the same topology iff they have the same sorted split hashes.
+ */
+struct CandidateTopology {
+
+	/**
+	 * parent index of every node, -1 for the root
+	 */
+	IntVector parent;
+
+	/**
+	 * length of the branch from every node to its parent
+	 */
+	DoubleVector length;
+
+	/**
+	 * sorted hashes of all non-trivial splits
+	 */
+	vector<uint64_t> splits;
+
+	/**
+	 * fingerprint of the topology, computed from sorted split hashes
+	 */
+	uint64_t key;
+
+	/**
+	 * number of leaves, nodes with index >= leafNum are internal
+	 */
+	int leafNum;
+
+	CandidateTopology() : key(0), leafNum(0) {}
+
+	/**
+	 * encode the topology of \a tree in O(n) (plus sorting the split hashes)
+	 * @param tree a tree whose leaf IDs are the taxon IDs 0..leafNum-1
+	 */
+	void encode(MTree *tree);
+
+	/**
+	 * compute the hash of the split induced by the branch from every node to
+	 * its parent, normalized to the side not containing taxon 0
+	 * @param node_splits (OUT) split hash of every node, 0 for the root and trivial splits
+	 */
+	void getNodeSplits(vector<uint64_t> &node_splits) const;
+
+	/**
+	 * @param node index of a node
+	 * @param sp (OUT) split induced by the branch from \a node to its parent,
+	 * normalized in the same way as MTree::convertSplits()
+	 */
+	void getSplit(int node, Split &sp) const;
+
+	/**
+	 * rebuild the node graph of \a tree from this encoding, without
+	 * going through a Newick string. Leaf names are taken from \a aln,
+	 * the caller is responsible to set the root and call initializeTree().
+	 * @param tree an empty tree
+	 * @param aln alignment providing the name of every taxon ID
+	 * @param rooted true if the last leaf is the virtual root
+	 */
+	void decode(MTree *tree, Alignment *aln, bool rooted) const;
+
+};
+
+typedef unordered_map<uint64_t, double> TopologyScoreMap;
+
 struct CandidateTree {
 
 	/**
@@ -41,11 +111,10 @@ struct CandidateTree {
 	string tree;
 
 	/**
-	 * tree topology WITHOUT branch lengths
-	 * and WITH TAXON ID (instead of taxon names)
-	 * for sorting purpose
+	 * binary tree topology WITH branch lengths,
+	 * used for duplicate detection and fast tree rebuild
 	 */
-	string topology;
+	CandidateTopology topology;
 
 	/**
 	 * log-likelihood or parsimony score
@@ -92,6 +161,13 @@ public:
      */
     string getRandTopTree(int numTopTrees);
 
+    /**
+     * return randomly one of the current best candidate trees
+     * @param numTopTrees [IN] Number of current best trees, from which a random tree is chosen.
+     * @param rstream [IN] random number stream (if NULL, the default stream is used)
+     */
+    const CandidateTree &getRandTopCandidate(int numTopTrees, int *rstream = NULL);
+
     /**
      * return the next parent tree for reproduction.
      * Here we always maintain a list of candidate trees which have not
@@ -100,6 +176,12 @@ public:
      */
     string getNextCandTree();
 
+    /**
+     * same as getNextCandTree() but return the whole candidate,
+     * so that its binary topology can be read back directly
+     */
+    CandidateTree getNextCandidate();
+
     /**
      *  Replace an existing tree in the candidate set
      *  @param tree the new tree string that will replace the existing tree
@@ -127,6 +209,22 @@ public:
      */
     int update(string newTree, double newScore);
 
+    /**
+     *  same as above, with the binary topology of \a newTree already encoded,
+     *  which saves parsing the tree string
+     *
+     *  @param newTopology binary topology of \a newTree
+     */
+    int update(string newTree, const CandidateTopology &newTopology, double newScore);
+
+    /**
+     *  Encode the binary topology of a tree string (with taxon IDs)
+     *
+     *  @param tree the newick tree string
+     *  @param topology (OUT) the binary topology
+     */
+    void encodeTreeString(const string &tree, CandidateTopology &topology);
+
     /**
      *  Get the \a numBestScores best scores in the candidate set
      *
@@ -182,9 +280,9 @@ public:
      * 	Check if tree topology \a topo already exists
      *
      * 	@param topo
-     * 		Newick string of the tree topology
+     * 		fingerprint of the tree topology
      */
-    bool treeTopologyExist(string topo);
+    bool treeTopologyExist(uint64_t topo);
 
     /**
      * 	Check if tree \a tree already exists
@@ -222,11 +320,11 @@ public:
      * return the score of \a topology
      *
      * @param topology
-     * 		Newick topology
+     * 		fingerprint of the topology
      * @return
      * 		Score of the topology
      */
-    double getTopologyScore(string topology);
+    double getTopologyScore(uint64_t topology);
 
     /**
      *  Empty the candidate set
@@ -240,6 +338,8 @@ public:
 
     /**
      *  Collect all splits from the set of current best trees and compute for each of them the number of occurances.
+     *  The occurences are maintained incrementally when trees are inserted or removed, so this
+     *  only rebuilds them if they are out of sync, and then refreshes the support values.
      *
      *  @param supportThres
      *      a number in (0,1] representing the support value threshold for stable splits
@@ -272,16 +372,16 @@ public:
 
     /**
      * Return a pointer to the \a CandidateTree that has topology equal to \a topology
-     * @param topology
+     * @param topology fingerprint of the topology
      * @return
      */
-    iterator getCandidateTree(string topology);
+    iterator getCandidateTree(uint64_t topology);
 
     /**
      * Remove candidate trees with topology equal to the specified topology
-     * @param topology
+     * @param topology fingerprint of the topology
      */
-    void removeCandidateTree(string topology);
+    void removeCandidateTree(uint64_t topology);
 
     /**
      *  Remove the worst tree in the candidate set
@@ -291,7 +391,7 @@ public:
     /* Getter and Setter function */
 	void setAln(Alignment* aln);
 
-	const StringDoubleHashMap& getTopologies() const {
+	const TopologyScoreMap& getTopologies() const {
 		return topologies;
 	}
 
@@ -323,18 +423,29 @@ public:
 	//void getRandomStableSplits(int numSplit, SplitGraph& splits);
 
 	/**
-	 *  Add splits from \a treeString to the current candidate splits
+	 *  Add splits of \a topology to the current candidate splits.
+	 *  Only splits not seen before are materialized as Split objects.
 	 *
-	 *  @param tree collect splits from this tree
+	 *  @param topology collect splits from this tree
 	 */
-	void addCandidateSplits(string treeString);
+	void addCandidateSplits(const CandidateTopology &topology);
 
 	/**
-	 *  Remove splits that appear from \a treeString.
-	 *  If an existing split has weight > 1, their weight will be
+	 *  Remove splits that appear in \a topology.
+	 *  If an existing split occurs more than once, its count will be
 	 *  reduced by 1.
 	 */
-	void removeCandidateSplits(string treeString);
+	void removeCandidateSplits(const CandidateTopology &topology);
+
+	/**
+	 *  @return true if candSplits has to be maintained and is in sync with the candidate trees
+	 */
+	bool isTrackingSplits();
+
+	/**
+	 *  Empty candSplits and free the split objects
+	 */
+	void clearCandidateSplits();
 
     int getNumStableSplits() const;
 
@@ -372,14 +483,20 @@ private:
 	SplitIntMap candSplits;
 
     /**
-     *  Map data structure storing <topology_string, score>
+     *  Map from split hash (see CandidateTopology) to the <split, occurences> entry
+     *  of \a candSplits, so that occurences are updated without hashing the split bitset
+     */
+    unordered_map<uint64_t, SplitIntMap::value_type*> candSplitHashes;
+
+    /**
+     *  Map data structure storing <topology_fingerprint, score>
      */
-    StringDoubleHashMap topologies;
+    TopologyScoreMap topologies;
 
     /**
      *  Trees used for reproduction
      */
-    stack<string> parentTrees;
+    stack<CandidateTree> parentTrees;
 
     /**
      * pointer to alignment, just to assign correct IDs for taxa
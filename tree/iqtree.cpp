@@ -695,7 +695,8 @@ void IQTree::computeInitialTree(LikelihoodKernel kernel) {
         loadCostMatrixFile(params->sankoff_cost_file);
     }
     if (aln->ordered_pattern.empty()) {
-        aln->orderPatternByNumChars(PAT_VARIANT);
+        aln->orderPatternByNumChars(isUsingSankoffParsimony()
+                                    ? PAT_VARIANT : PAT_INFORMATIVE);
     }
     setParsimonyKernel(kernel);
     
@@ -932,9 +933,11 @@ void IQTree::computeInitialTree(LikelihoodKernel kernel) {
 }
 
 int IQTree::addTreeToCandidateSet(string treeString, double score,
-                                  bool updateStopRule, int sourceProcID) {
+                                  bool updateStopRule, int sourceProcID,
+                                  const CandidateTopology *topology) {
     double curBestScore = candidateTrees.getBestScore();
-    int pos = candidateTrees.update(treeString, score);
+    int pos = topology ? candidateTrees.update(treeString, *topology, score)
+                       : candidateTrees.update(treeString, score);
     if (updateStopRule) {
         stop_rule.setCurIt(stop_rule.getCurIt() + 1);
         if (score > curBestScore) {
@@ -1353,7 +1356,8 @@ void IQTree::initializeModel(Params &params, string model_name,
     }
 
     if (aln->ordered_pattern.empty()) {
-        aln->orderPatternByNumChars(PAT_VARIANT);
+        aln->orderPatternByNumChars(isUsingSankoffParsimony()
+                                    ? PAT_VARIANT : PAT_INFORMATIVE);
     }
 
 }
@@ -2011,7 +2015,7 @@ string IQTree::perturbStableSplits(double suppValue) {
     return getTreeString();
 }
 
-string IQTree::doRandomNNIs(bool storeTabu) {
+string IQTree::doRandomNNIs(bool storeTabu, int* rstream) {
     int cntNNI = 0;
     int numRandomNNI;
     Branches nniBranches;
@@ -2043,8 +2047,8 @@ string IQTree::doRandomNNIs(bool storeTabu) {
         for (auto it = nniBranches.begin(); it != nniBranches.end(); ++it) {
             vectorNNIBranches.push_back(it->second);
         }
-        int randInt = random_int((int) vectorNNIBranches.size());
-        NNIMove randNNI = getRandomNNI(vectorNNIBranches[randInt]);
+        int randInt = random_int((int) vectorNNIBranches.size(), rstream);
+        NNIMove randNNI = getRandomNNI(vectorNNIBranches[randInt], rstream);
         if (constraintTree.isCompatible(randNNI)) {
             // only if random NNI satisfies constraintTree
             doNNI(randNNI);
@@ -2699,13 +2703,32 @@ void IQTree::doRandomSPRSearch() {}
 void IQTree::doParsimonyHillClimb() {
     initCandidateTreeSet(100, 100);
     curScore = -computeParsimony();
+    string bestParsTree;
+    double bestParsScore = curScore;
+    if (!boot_samples.empty()) {
+        saveCurrentParsimonyTree(curScore);
+        bestParsTree = getTreeString();
+    }
     params->unsuccess_iteration = (aln->at(0).size() + 99) / 100 * 100;
 
     double startTime = getRealTime(), startCPU = getCPUTime();
     int iterations_passed = 0;
 
+    bool useWalkers = 1 < params->mpboot2_walkers;
+    if (useWalkers && !canUseParsimonyHillClimbWalkers()) {
+        outWarning("-mpboot2-walkers is not supported with the options"
+                   " specified; using a single walker");
+        useWalkers = false;
+    }
+    if (useWalkers) {
+        bestParsTree      = getTreeString();
+        iterations_passed = doParsimonyHillClimbWalkers(bestParsTree, bestParsScore);
+        readTreeString(bestParsTree);
+        curScore = bestParsScore;
+    }
+
     int bestScoreAchieved = getBestScore(), lastUpdated = 0;
-    for(;iterations_passed < lastUpdated + params->unsuccess_iteration;) {
+    for(;!useWalkers && iterations_passed < lastUpdated + params->unsuccess_iteration;) {
         iterations_passed += 1;
         Alignment *saved_aln = aln;
         string curTree;
@@ -2713,11 +2736,21 @@ void IQTree::doParsimonyHillClimb() {
 
         doTreePerturbation();
         doParsimonySPR();
-        curScore = -computeParsimony("Determining two-way parsimony", true, true );
-        initializeAllPartialPars();
+        //doParsimonySPR leaves every view up to date (it rescores
+        //incrementally), so this need not recalculate the whole tree.
+        curScore = -computeDirtyParsimony();
+        if (!boot_samples.empty()) {
+            saveCurrentParsimonyTree(curScore);
+        }
 
         curTree = getTreeString();
-        int pos = addTreeToCandidateSet(curTree, curScore, true, MPIHelper::getInstance().getProcessID());
+        if (!boot_samples.empty() && curScore > bestParsScore) {
+            bestParsScore = curScore;
+            bestParsTree  = curTree;
+        }
+        CandidateTopology curTopology;
+        curTopology.encode(this);
+        int pos = addTreeToCandidateSet(curTree, curScore, true, MPIHelper::getInstance().getProcessID(), &curTopology);
         if (pos != -2 && pos != -1 && (Params::getInstance().fixStableSplits || Params::getInstance().adaptPertubation)) {
             candidateTrees.computeSplitOccurences(Params::getInstance().stableSplitThreshold);
         }
@@ -2748,6 +2781,114 @@ void IQTree::doParsimonyHillClimb() {
     if (iterations_passed > 0) {
         cout << "On average, each search iteration took: " << (endTime - startTime) / iterations_passed << endl;
     }
+    if (!boot_samples.empty()) {
+        summarizeParsimonyBootstrap(bestParsTree);
+    }
+}
+
+bool IQTree::canUseParsimonyHillClimbWalkers() {
+#ifdef _OPENMP
+    //Walkers do the default perturbation (random NNIs on a random top
+    //candidate), which doesn't consult the stable splits of the
+    //candidate set, and they only do Fitch parsimony.
+    return !isSuperTree() && !isUsingSankoffParsimony()
+        && iqp_assess_quartet != IQP_BOOTSTRAP
+        && params->snni && !params->iqp
+        && !params->adaptPertubation && !params->fixStableSplits
+        && !params->tabu;
+#else
+    return false;
+#endif
+}
+
+int IQTree::doParsimonyHillClimbWalkers(string &best_pars_tree, double &best_pars_score) {
+    int walker_count = params->mpboot2_walkers;
+    LOG_LINE(VB_QUIET, "Running " << walker_count << " parsimony hill-climbing walkers");
+
+    string start_tree = getTreeString();
+    int    rand_seed  = random_int(1000);
+    vector<IQTree*> walkers(walker_count, nullptr);
+    vector<int*>    streams(walker_count, nullptr);
+    for (int w = 0; w < walker_count; ++w) {
+        IQTree* walker = new IQTree(aln);
+        walker->rooted = rooted;
+        walker->setParams(params);
+        walker->setNumThreads(1);
+        walker->showNoProgress();
+        walker->setParsimonyKernel(sse);
+        walker->readTreeString(start_tree);
+        walkers[w] = walker;
+        init_random(rand_seed + w, false, &streams[w]);
+    }
+
+    int iterations_passed = 0;
+    int bestScoreAchieved = getBestScore(), lastUpdated = 0;
+#ifdef _OPENMP
+    #pragma omp parallel num_threads(walker_count)
+#endif
+    {
+#ifdef _OPENMP
+        int w = omp_get_thread_num();
+#else
+        int w = 0;
+#endif
+        IQTree* walker  = walkers[w];
+        int*    rstream = streams[w];
+        for (;;) {
+            CandidateTree parent;
+            bool done;
+#ifdef _OPENMP
+            #pragma omp critical (parsimony_walkers)
+#endif
+            {
+                done = lastUpdated + params->unsuccess_iteration <= iterations_passed;
+                if (!done) {
+                    ++iterations_passed;
+                    if (params->five_plus_five) {
+                        parent = candidateTrees.getNextCandidate();
+                    } else {
+                        parent = candidateTrees.getRandTopCandidate(params->popSize, rstream);
+                    }
+                }
+            }
+            if (done) {
+                break;
+            }
+            walker->readCandidateTree(parent);
+            walker->doRandomNNIs(false, rstream);
+            walker->doParsimonySPR(params->parsimony_spr_iterations,
+                                   params->use_lazy_parsimony_spr,
+                                   params->spr_radius, true);
+            double score = -walker->computeDirtyParsimony();
+            string tree  = walker->getTreeString();
+            CandidateTopology topology;
+            topology.encode(walker);
+#ifdef _OPENMP
+            #pragma omp critical (parsimony_walkers)
+#endif
+            {
+                saveCurrentParsimonyTree(score, walker);
+                if (score > best_pars_score) {
+                    best_pars_score = score;
+                    best_pars_tree  = tree;
+                }
+                addTreeToCandidateSet(tree, score, true,
+                                      MPIHelper::getInstance().getProcessID(), &topology);
+                if (score > bestScoreAchieved) {
+                    lastUpdated       = iterations_passed;
+                    bestScoreAchieved = static_cast<int>(score);
+                    LOG_LINE(VB_QUIET, "Best parsimony score updated to " << -score
+                             << " at iteration " << iterations_passed);
+                }
+            }
+        }
+    }
+
+    for (int w = 0; w < walker_count; ++w) {
+        finish_random(streams[w]);
+        delete walkers[w];
+    }
+    return iterations_passed;
 }
 
 double IQTree::doTreeSearch() {
@@ -3319,9 +3460,9 @@ double IQTree::doTreePerturbation() {
     } else {
         if (params->snni) {
             if (Params::getInstance().five_plus_five) {
-                readTreeString(candidateTrees.getNextCandTree());
+                readCandidateTree(candidateTrees.getNextCandidate());
             } else {
-                readTreeString(candidateTrees.getRandTopTree(Params::getInstance().popSize));
+                readCandidateTree(candidateTrees.getRandTopCandidate(Params::getInstance().popSize));
             }
             if (Params::getInstance().iqp) {
                 doIQP();
@@ -3497,7 +3638,7 @@ pair<int, int> IQTree::optimizeNNI(bool speedNNI, const char* context) {
                 }
                 if (!candidateTrees.getCandSplits().empty()) {
                     int value;
-                    auto splits = candidateTrees.getCandSplits();
+                    auto &splits = candidateTrees.getCandSplits();
                     if (splits.findSplit(curSplit, value) != NULL) {
                         stable = true;
                     }
@@ -4160,6 +4301,94 @@ void IQTree::saveCurrentTree(double cur_logl) {
 
 }
 
+void IQTree::saveCurrentParsimonyTree(double cur_score, PhyloTree* tree) {
+    if (boot_samples.empty()) {
+        return;
+    }
+    if (tree == nullptr) {
+        tree = this;
+    }
+    size_t nptn = aln->ordered_pattern.size();
+    if (boot_samples_pars.empty()) {
+        // bootstrap weights of the ordered patterns; constant (and
+        // folded uninformative) patterns do not depend on the tree,
+        // and are left out
+        boot_samples_pars.resize(boot_samples.size());
+        for (int sample = sample_start; sample < sample_end; sample++) {
+            boot_samples_pars[sample].resize(nptn, 0);
+            for (size_t ptn = 0; ptn < nptn; ptn++) {
+                int id = aln->ordered_pattern_id[ptn];
+                if (id >= 0) {
+                    boot_samples_pars[sample][ptn] = static_cast<int>(boot_samples[sample][id]);
+                }
+            }
+        }
+    }
+    vector<UINT> ptn_pars(nptn);
+    tree->computePatternParsimony(ptn_pars.data());
+
+    ostringstream ostr;
+    tree->setRootNode(params->root);
+    if (params->print_ufboot_trees == 2)
+        tree->printTree(ostr, WT_TAXON_ID + WT_SORT_TAXA + WT_BR_LEN + WT_BR_LEN_SHORT);
+    else
+        tree->printTree(ostr, WT_TAXON_ID + WT_SORT_TAXA);
+    string tree_str = ostr.str();
+
+#ifdef _OPENMP
+    int rand_seed = random_int(1000);
+    #pragma omp parallel
+    {
+    int *rstream;
+    init_random(rand_seed + omp_get_thread_num(), false, &rstream);
+    #pragma omp for
+#else
+    int *rstream = randstream;
+#endif
+    for (int sample = sample_start; sample < sample_end; sample++) {
+        const int* boot_sample = boot_samples_pars[sample].data();
+        int64_t boot_pars = 0;
+        for (size_t ptn = 0; ptn < nptn; ptn++) {
+            boot_pars += (int64_t)ptn_pars[ptn] * boot_sample[ptn];
+        }
+        // scores are stored negated, so that higher is better as for log-likelihoods
+        double rell = -(double)boot_pars;
+        bool better = rell > boot_logl[sample];
+        if (!better && rell == boot_logl[sample]) {
+            better = (random_double(rstream) <= 1.0 / (boot_counts[sample] + 1));
+        }
+        if (better) {
+            if (rell == boot_logl[sample]) {
+                ++(boot_counts[sample]);
+            } else {
+                boot_counts[sample] = 1;
+            }
+            boot_logl[sample] = rell;
+            boot_orig_logl[sample] = cur_score;
+            boot_trees[sample] = tree_str;
+        }
+    }
+#ifdef _OPENMP
+    finish_random(rstream);
+    }
+#endif
+}
+
+void IQTree::summarizeParsimonyBootstrap(const string &best_tree) {
+    if (boot_samples.empty()) {
+        return;
+    }
+    readTreeString(best_tree);
+    LOG_LINE(VB_QUIET, "Creating " << RESAMPLE_NAME << " support values from parsimony bootstrap...");
+    summarizeBootstrap(*params);
+    string out_file = string(params->out_prefix) + ".suptree";
+    printTree(out_file.c_str());
+    LOG_LINE(VB_QUIET, "Tree with assigned support written to " << out_file);
+    if (params->print_ufboot_trees) {
+        writeUFBootTrees(*params);
+    }
+}
+
 void IQTree::saveNNITrees(PhyloNode *node, PhyloNode *dad) {
     if (!node) {
         node = getRoot();
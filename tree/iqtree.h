@@ -104,6 +104,23 @@ public:
 
     virtual void doParsimonyHillClimb();
 
+    /**
+     *  the perturbation + SPR loop of doParsimonyHillClimb(), run by
+     *  params->mpboot2_walkers concurrent walkers.  Each walker works on its own
+     *  copy of the tree (with its own parsimony vectors and random number stream);
+     *  they share this tree's candidate set and stopping rule (under a lock).
+     *  @param best_pars_tree  [IN/OUT] the most parsimonious tree found
+     *  @param best_pars_score [IN/OUT] its score (negated, so higher is better)
+     *  @return the number of iterations done (by all the walkers together)
+     */
+    int doParsimonyHillClimbWalkers(string &best_pars_tree, double &best_pars_score);
+
+    /**
+     *  @return true if the perturbation + SPR loop of doParsimonyHillClimb()
+     *          can be run by concurrent walkers, with the current options
+     */
+    bool canUseParsimonyHillClimbWalkers();
+
     virtual void doRandomSPRSearch();
 
     /** 
@@ -258,9 +275,10 @@ public:
 
     /**
      *         Perform a series of random NNI moves
+     *         @param rstream random number stream (if NULL, the default stream is used)
      *         @return the perturbed newick string
      */
-    string doRandomNNIs(bool storeTabu = false);
+    string doRandomNNIs(bool storeTabu = false, int* rstream = NULL);
 
     /**
      *  Do a random NNI on splits that are shared among all the candidate trees.
@@ -694,8 +712,11 @@ public:
      *  @return relative position of the new tree to the current best.
      *      -1 if duplicated
      *      -2 if the candidate set is not updated
+     *  @param topology
+     *      binary topology of \a treeString if already known, NULL to encode it from the string
      */
-    int addTreeToCandidateSet(string treeString, double score, bool updateStopRule, int sourceProcID);
+    int addTreeToCandidateSet(string treeString, double score, bool updateStopRule, int sourceProcID,
+                              const CandidateTopology *topology = NULL);
 
     /**
         MPI: synchronize candidate trees between all processes
@@ -884,6 +905,22 @@ protected:
 
     virtual void saveCurrentTree(double logl); // save current tree
 
+    /**
+     *  MPBoot-style online parsimony bootstrap: score the current tree on every
+     *  bootstrap sample by resampling its per-pattern parsimony (RELL) in integer
+     *  arithmetic, and update boot_trees/boot_counts accordingly
+     *  @param cur_score the (negated) parsimony score of the tree
+     *  @param tree the tree to score (if NULL, this tree)
+     */
+    void saveCurrentParsimonyTree(double cur_score, PhyloTree* tree = NULL);
+
+    /**
+     *  print the most parsimonious tree found with parsimony bootstrap supports
+     *  (and the bootstrap trees if requested)
+     *  @param best_tree the most parsimonious tree found by the search
+     */
+    void summarizeParsimonyBootstrap(const string &best_tree);
+
 
     void saveNNITrees(PhyloNode *node = NULL, PhyloNode *dad = NULL);
 
@@ -1033,5 +1070,8 @@ public:
     bool on_refine_btree;
     Alignment* saved_aln_on_refine_btree;
     vector<IntVector> boot_samples_int;
+
+    /** bootstrap pattern weights indexed by aln->ordered_pattern, used by saveCurrentParsimonyTree() */
+    vector<IntVector> boot_samples_pars;
 };
 #endif
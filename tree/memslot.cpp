@@ -252,3 +252,113 @@ void MemSlotVector::restore(PhyloNeighbor *new_nei, PhyloNeighbor *old_nei) {
 //    nei_id_map[old_nei] = it;
     cout << "slot " << distance(begin(), it) << " restored" << endl;
 }
+
+ParsimonySlotVector::ParsimonySlotVector()
+    : first_block(NULL), block_size(0), lru_head(-1), lru_tail(-1) {
+}
+
+void ParsimonySlotVector::init(PhyloTree *tree, int num_slot) {
+    clear();
+    resize(num_slot);
+    first_block = tree->central_partial_pars;
+    block_size = tree->pars_block_size;
+    lru_head = lru_tail = -1;
+    for (iterator it = begin(); it != end(); it++) {
+        int id = static_cast<int>(it-begin());
+        it->nei = NULL;
+        it->partial_pars = first_block + block_size*id;
+        it->lock_count = 0;
+        append(id);
+    }
+}
+
+void ParsimonySlotVector::reset() {
+    for (iterator it = begin(); it != end(); it++) {
+        it->nei = NULL;
+        it->lock_count = 0;
+    }
+    lru_head = lru_tail = -1;
+    for (int id = 0; id < static_cast<int>(size()); id++) {
+        append(id);
+    }
+}
+
+int ParsimonySlotVector::findNei(PhyloNeighbor *nei) const {
+    // the slot ID follows from where nei->partial_pars points
+    if (empty() || nei->partial_pars < first_block)
+        return -1;
+    uint64_t offset = nei->partial_pars - first_block;
+    if (offset % block_size != 0 || offset / block_size >= size())
+        return -1;
+    int id = static_cast<int>(offset / block_size);
+    if (at(id).nei != nei)
+        return -1;
+    return id;
+}
+
+bool ParsimonySlotVector::lock(PhyloNeighbor *nei) {
+    int id = findNei(nei);
+    if (id < 0)
+        return false;
+    if (at(id).lock_count++ == 0)
+        unlink(id);
+    return true;
+}
+
+void ParsimonySlotVector::unlock(PhyloNeighbor *nei) {
+    int id = findNei(nei);
+    ASSERT(id >= 0 && at(id).lock_count > 0);
+    if (--at(id).lock_count == 0)
+        append(id);
+}
+
+bool ParsimonySlotVector::locked(PhyloNeighbor *nei) const {
+    int id = findNei(nei);
+    return id >= 0 && at(id).lock_count > 0;
+}
+
+int ParsimonySlotVector::allocate(PhyloNeighbor *nei) {
+    int id = findNei(nei);
+    if (id < 0) {
+        id = lru_head;
+        if (id < 0)
+            return -1;
+        ParsimonySlot &slot = at(id);
+        if (slot.nei) {
+            // take the slot away from the view that had it
+            slot.nei->partial_pars = NULL;
+            slot.nei->setParsimonyComputed(false);
+        }
+        slot.nei = nei;
+        nei->partial_pars = slot.partial_pars;
+        // move it to the most recently used end
+        unlink(id);
+        append(id);
+    }
+    nei->setParsimonyComputed(false);
+    return id;
+}
+
+void ParsimonySlotVector::unlink(int id) {
+    ParsimonySlot &slot = at(id);
+    if (slot.prev >= 0)
+        at(slot.prev).next = slot.next;
+    else
+        lru_head = slot.next;
+    if (slot.next >= 0)
+        at(slot.next).prev = slot.prev;
+    else
+        lru_tail = slot.prev;
+    slot.prev = slot.next = -1;
+}
+
+void ParsimonySlotVector::append(int id) {
+    ParsimonySlot &slot = at(id);
+    slot.prev = lru_tail;
+    slot.next = -1;
+    if (lru_tail >= 0)
+        at(lru_tail).next = id;
+    else
+        lru_head = id;
+    lru_tail = id;
+}
@@ -107,5 +107,74 @@ protected:
 
 };
 
+/**
+    one memory slot for a partial parsimony vector,
+    used for the parsimony memory saving technique
+*/
+struct ParsimonySlot {
+    PhyloNeighbor *nei;  // neighbor (view) assigned to this slot, or NULL
+    UINT *partial_pars;  // partial parsimony vector of this slot
+    int lock_count;      // number of outstanding locks on this slot
+    int prev;            // previous (less recently used) unlocked slot, or -1
+    int next;            // next (more recently used) unlocked slot, or -1
+};
+
+/**
+    a bounded pool of partial parsimony vectors (used when -pars-mem
+    is set). Unlocked slots are kept in least-recently-used order,
+    and when a slot is needed for a view that does not have one,
+    the least recently used unlocked slot is taken from whichever
+    view had it (that view's partial_pars is set to NULL, and it
+    is marked as not computed, so it will be recomputed if it is
+    needed again; see PhyloTree::lockParsimonyView).
+*/
+class ParsimonySlotVector : public vector<ParsimonySlot> {
+public:
+
+    ParsimonySlotVector();
+
+    /** initialize with a specified number of slots, carved out of
+        tree->central_partial_pars */
+    void init(PhyloTree *tree, int num_slot);
+
+    /** forget all views (without touching them) and free all slots */
+    void reset();
+
+    /** @return the ID of the slot assigned to nei, or -1 if it has none */
+    int findNei(PhyloNeighbor *nei) const;
+
+    /**
+        lock the slot assigned to nei (locks nest)
+        @param nei neighbor to lock
+        @return TRUE if nei had a slot, FALSE otherwise
+    */
+    bool lock(PhyloNeighbor *nei);
+
+    /** unlock the slot assigned to nei */
+    void unlock(PhyloNeighbor *nei);
+
+    /** test if the slot assigned to nei is locked or not */
+    bool locked(PhyloNeighbor *nei) const;
+
+    /**
+        assign a slot to nei (marking nei as not computed), taking
+        it from the least recently used view, if there are no free slots
+        @return the slot ID or -1 if every slot is locked
+    */
+    int allocate(PhyloNeighbor *nei);
+
+protected:
+
+    /** remove a slot from the list of unlocked slots */
+    void unlink(int id);
+
+    /** add a slot at the (most recently used) end of the list of unlocked slots */
+    void append(int id);
+
+    UINT *first_block;   // start of the first slot's vector
+    uint64_t block_size; // size of each slot's vector (in UINTs)
+    int lru_head;        // least recently used unlocked slot, or -1
+    int lru_tail;        // most recently used unlocked slot, or -1
+};
 
 #endif // MEMSLOT_H
@@ -703,7 +703,121 @@ void MTree::readTree(const char *infile, bool &is_rooted) {
     }
 }
 
+/**
+    read one NEWICK tree from a stream, up to and including its ';'
+    (a ';' inside a comment or a quoted name does not end the tree)
+    @param in input stream
+    @param[out] str the tree
+*/
+static void readNewickString(istream &in, string &str) {
+    streambuf *sb = in.rdbuf();
+    bool in_comment = false;
+    bool name_start = false;
+    char quote = 0;
+    str.clear();
+    for (;;) {
+        int c = sb->sbumpc();
+        if (c == EOF) {
+            in.setstate(ios::eofbit);
+            return;
+        }
+        char ch = static_cast<char>(c);
+        str += ch;
+        if (quote) {
+            if (ch == quote)
+                quote = 0;
+        } else if (in_comment) {
+            if (ch == ']')
+                in_comment = false;
+        } else if (ch == '[') {
+            in_comment = true;
+        } else if (!controlchar(ch)) {
+            // names are only quoted if the quote is their first character
+            if (name_start && (ch == '\'' || ch == '"'))
+                quote = ch;
+            else if (ch == ';')
+                return;
+            name_start = (ch == '(' || ch == ',' || ch == ')');
+        }
+    }
+}
+
 void MTree::readTree(istream &in, bool &is_rooted)
+{
+    string tree_str;
+    readNewickString(in, tree_str);
+    readTreeBuffer(tree_str.c_str(), tree_str.length(), is_rooted);
+}
+
+void MTree::readTreeBuffer(const char *buf, size_t len, bool &is_rooted,
+                           const unordered_map<string, int> *taxon_ids)
+{
+    NewickBuffer in = { buf, len, 0, false };
+    in_line = 1;
+    in_column = 1;
+    in_comment = "";
+    try {
+        char ch;
+        ch = readNextChar(in);
+        if (ch != '(') {
+            cout << string(buf + in.pos, len - in.pos) << endl;
+            throw "Tree file does not start with an opening-bracket '('";
+        }
+
+        leafNum = 0;
+
+        DoubleVector branch_len;
+        Node *node;
+        parseNewick(in, ch, node, branch_len, taxon_ids);
+        // 2018-01-05: assuming rooted tree if root node has two children
+        if (is_rooted || (!branch_len.empty() && branch_len[0] != 0.0) || node->degree() == 2) {
+            if (branch_len.empty())
+                branch_len.push_back(-1.0);
+            if (branch_len[0] == -1.0) branch_len[0] = 0.0;
+            if (branch_len[0] < 0.0)
+                throw ERR_NEG_BRANCH;
+            rooted = is_rooted = true;
+            root = newNode(leafNum, ROOT_NAME);
+            if (taxon_ids) {
+                unordered_map<string, int>::const_iterator id_it = taxon_ids->find(ROOT_NAME);
+                if (id_it != taxon_ids->end())
+                    root->id = id_it->second;
+            }
+            root->addNeighbor(node, branch_len);
+            node->addNeighbor(root, branch_len);
+            ++leafNum;
+            rooted = true;
+        } else { // assign root to one of the neighbor of node, if any
+            FOR_NEIGHBOR_IT(node, NULL, it)
+            if ((*it)->node->isLeaf()) {
+                root = (*it)->node;
+                break;
+            }
+        }
+        // make sure that root is a leaf
+        ASSERT(root->isLeaf());
+
+        if (in.eof || ch != ';')
+            throw "Tree file must be ended with a semi-colon ';'";
+    } catch (bad_alloc) {
+        outError(ERR_NO_MEMORY);
+    } catch (const char *str) {
+        setInputPosition(in);
+        outError(str, reportInputInfo());
+    } catch (string str) {
+        setInputPosition(in);
+        outError(str.c_str(), reportInputInfo());
+    } catch (...) {
+        // anything else
+        setInputPosition(in);
+        outError(ERR_READ_ANY, reportInputInfo());
+    }
+
+    nodeNum = leafNum;
+    initializeTree();
+}
+
+void MTree::readTreeFromStream(istream &in, bool &is_rooted)
 {
     in_line = 1;
     in_column = 1;
@@ -921,6 +1035,124 @@ void MTree::parseFile(istream &infile, char &ch, Node* &root, DoubleVector &bran
 
 
 
+void MTree::parseNewick(NewickBuffer &in, char &ch, Node* &node, DoubleVector &branch_len,
+                        const unordered_map<string, int> *taxon_ids)
+{
+    NodeVector open_nodes; // internal nodes whose children are being read, innermost last
+    for (;;) {
+        node = newNode();
+        if (ch == '(') {
+            // internal node: read its first child
+            ch = readNextChar(in);
+            if (ch != ')' && !in.eof) {
+                open_nodes.push_back(node);
+                continue;
+            }
+            if (!in.eof) ch = readNextChar(in);
+        }
+        // node is complete but for its name and branch length
+        for (;;) {
+            parseNodeLabel(in, ch, node, branch_len, taxon_ids);
+            if (open_nodes.empty())
+                return;
+            Node *dad = open_nodes.back();
+            dad->addNeighbor(node, branch_len);
+            node->addNeighbor(dad, branch_len);
+            if (in.eof)
+                throw "Expecting ')', but end of file instead";
+            if (ch == ',')
+                ch = readNextChar(in);
+            else if (ch != ')') {
+                string err = "Expecting ')', but found '";
+                err += ch;
+                err += "' instead";
+                throw err;
+            }
+            if (ch != ')' && !in.eof)
+                break; // read the next child of dad
+            // all children of dad are read
+            open_nodes.pop_back();
+            if (!in.eof) ch = readNextChar(in);
+            node = dad;
+        }
+    }
+}
+
+void MTree::parseNodeLabel(NewickBuffer &in, char &ch, Node *node, DoubleVector &branch_len,
+                           const unordered_map<string, int> *taxon_ids)
+{
+    const size_t maxlen = 1000;
+    branch_len.clear();
+    // now read the node name (ch is the last character read, unless at the end)
+    char end_ch = 0;
+    if (ch == '\'' || ch == '"') end_ch = ch;
+    size_t start = in.pos - 1;
+    size_t seqlen = 0;
+    while (!in.eof && seqlen < maxlen)
+    {
+        if (end_ch == 0) {
+            if (is_newick_token(ch) || controlchar(ch)) break;
+        }
+        ++seqlen;
+        ch = in.get(static_cast<char>(EOF));
+        if (end_ch != 0 && ch == end_ch) {
+            ++seqlen;
+            break;
+        }
+    }
+    if ((controlchar(ch) || ch == '[' || ch == end_ch) && !in.eof)
+        ch = readNextChar(in, ch);
+    if (seqlen == maxlen)
+        throw "Too long name ( > 1000)";
+    if (seqlen == 0 && node->isLeaf())
+        throw "Redundant double-bracket ‘((…))’ with closing bracket ending at";
+    if (seqlen > 0) {
+        string seqname(in.buf + start, seqlen);
+        if (node->isLeaf())
+            renameString(seqname);
+        node->name.append(seqname);
+    }
+    if (node->isLeaf()) {
+        // is a leaf, assign its ID
+        if (taxon_ids) {
+            unordered_map<string, int>::const_iterator id_it = taxon_ids->find(node->name);
+            if (id_it == taxon_ids->end())
+                throw "Taxon " + node->name + " does not occur in the first tree";
+            node->id = id_it->second;
+        } else {
+            node->id = leafNum;
+        }
+        if (leafNum == 0)
+            MTree::root = node;
+        ++leafNum;
+    }
+
+    if (ch == ';' || in.eof)
+        return;
+    if (ch == ':')
+    {
+        string saved_comment = in_comment;
+        ch = readNextChar(in);
+        if (in_comment.empty())
+            in_comment = saved_comment;
+        start = in.pos - 1;
+        seqlen = 0;
+        while (!is_newick_token(ch) && !controlchar(ch) && !in.eof && seqlen < maxlen)
+        {
+            ++seqlen;
+            ch = in.get(static_cast<char>(EOF));
+        }
+        if ((controlchar(ch) || ch == '[') && !in.eof) {
+            ch = readNextChar(in, ch);
+        }
+        if (seqlen == maxlen || in.eof) {
+            throw "branch length format error.";
+        }
+        string lenstr(in.buf + start, seqlen);
+        parseBranchLength(lenstr, branch_len);
+    }
+}
+
 /**
 	check tree is bifurcating tree (every leaf with level 1 or 3)
 */
@@ -1748,6 +1980,40 @@ char MTree::readNextChar(istream &in, char current_ch) {
     return ch;
 }
 
+char MTree::readNextChar(NewickBuffer &in, char current_ch) {
+    char ch = current_ch;
+    if (current_ch != '[')
+        ch = in.get(ch);
+    while (controlchar(ch) && !in.eof)
+        ch = in.get(ch);
+    in_comment = "";
+    // ignore comment
+    while (ch=='[' && !in.eof) {
+        size_t start = in.pos;
+        while (ch!=']' && !in.eof)
+            ch = in.get(ch);
+        if (ch != ']') {
+            throw "Comments not ended with ]";
+        }
+        in_comment.append(in.buf + start, in.pos - 1 - start);
+        ch = in.get(ch);
+        while (controlchar(ch) && !in.eof)
+            ch = in.get(ch);
+    }
+    return ch;
+}
+
+void MTree::setInputPosition(NewickBuffer &in) {
+    size_t line_start = 0;
+    in_line = 1;
+    for (size_t i = 0; i < in.pos; i++)
+        if (in.buf[i] == '\n') {
+            ++in_line;
+            line_start = i+1;
+        }
+    in_column = static_cast<int>(in.pos - line_start) + 1;
+}
+
 string MTree::reportInputInfo() {
     string str = " (line ";
     str += convertIntToString(in_line) + " column " + convertIntToString(in_column-1) + ")";
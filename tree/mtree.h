@@ -36,6 +36,28 @@ const char BRANCH_LENGTH_SEPARATOR = '/';
 class SplitGraph;
 class MTreeSet;
 
+/**
+    a NEWICK tree held in memory, read by MTree::readTreeBuffer
+ */
+struct NewickBuffer {
+    /** the characters of the tree */
+    const char *buf;
+    /** number of characters */
+    size_t len;
+    /** position of the next character to read */
+    size_t pos;
+    /** true once a read went past the end, as istream::eof() */
+    bool eof;
+
+    /** @return the next character, or ch if there is none */
+    char get(char ch) {
+        if (pos < len)
+            return buf[pos++];
+        eof = true;
+        return ch;
+    }
+};
+
 /**
 General-purposed tree
 @author BUI Quang Minh, Steffen Klaere, Arndt von Haeseler
@@ -309,11 +331,26 @@ public:
     virtual void readTree(istream &in, bool &is_rooted);
 
     /**
-            read the tree from a newick string
-            @param tree_string the tree string.
+            read the tree in newick format from a buffer, without recursion
+            and without per-character stream calls
+            @param buf the tree, up to and including its ';'
+            @param len number of characters in buf
+            @param is_rooted (IN/OUT) true if tree is rooted
+            @param taxon_ids if not nullptr, leaf IDs are taken from this map
+                   (which must cover all leaf names) instead of being
+                   numbered in the order the leaves appear
+     */
+    void readTreeBuffer(const char *buf, size_t len, bool &is_rooted,
+                        const unordered_map<string, int> *taxon_ids = nullptr);
+
+    /**
+            read the tree from the stream character by character with
+            parseFile; this is the parser that readTree used before
+            readTreeBuffer, kept for benchmarking
+            @param in the input stream.
             @param is_rooted (IN/OUT) true if tree is rooted
      */
-    //virtual void readTreeString(string tree_string, bool is_rooted);
+    void readTreeFromStream(istream &in, bool &is_rooted);
 
     /**
             parse the tree from the input file in newick format
@@ -1022,6 +1059,43 @@ protected:
      */
     char readNextChar(istream &in, char current_ch = 0);
 
+    /**
+            read the next character from a NEWICK buffer. Ignore comments [...]
+            @param in input buffer
+            @param current_ch current character in the buffer
+            @return next character read from input buffer
+     */
+    char readNextChar(NewickBuffer &in, char current_ch = 0);
+
+    /**
+            parse a (sub)tree from a NEWICK buffer, keeping the internal nodes
+            being read on an explicit stack instead of recursing
+            @param in input buffer
+            @param ch (IN/OUT) current char
+            @param node (OUT) the root of the (sub)tree
+            @param branch_len (OUT) branch length associated to the root
+            @param taxon_ids if not nullptr, map from leaf names to leaf IDs
+     */
+    void parseNewick(NewickBuffer &in, char &ch, Node* &node, DoubleVector &branch_len,
+                     const unordered_map<string, int> *taxon_ids);
+
+    /**
+            parse the name and branch length of a node from a NEWICK buffer
+            @param in input buffer
+            @param ch (IN/OUT) current char
+            @param node the node
+            @param branch_len (OUT) branch length associated to the node
+            @param taxon_ids if not nullptr, map from leaf names to leaf IDs
+     */
+    void parseNodeLabel(NewickBuffer &in, char &ch, Node *node, DoubleVector &branch_len,
+                        const unordered_map<string, int> *taxon_ids);
+
+    /**
+            set in_line and in_column to a position in a NEWICK buffer
+            @param in input buffer
+     */
+    void setInputPosition(NewickBuffer &in);
+
     string reportInputInfo();
 
     /**
@@ -360,47 +360,7 @@ void MTreeSet::convertSplits(SplitGraph &sg, double split_threshold, int weighti
 	convertSplits(sg, hash_ss, weighting_type, weight_threshold);
 	int nsplits = static_cast<int>(sg.getNSplits());
 
-	double threshold = split_threshold * size();
-//	cout << "threshold = " << threshold << endl;
-    int count=0;
-    for (SplitGraph::iterator it = sg.begin(); it != sg.end(); ) {
-        ++count;
-		//SplitIntMap::iterator ass_it = hash_ss.find(*it);
-		int freq_value;
-		Split *sp = hash_ss.findSplit(*it, freq_value);
-		ASSERT(sp != NULL);
-		ASSERT(*sp == *(*it));
-		//Split *sp = ass_it->first;
-		if (freq_value <= threshold) {
-			if (verbose_mode == VB_DEBUG) {
-				sp->report(cout);
-			}
-			int num = hash_ss.getValue(sg.back());
-			hash_ss.eraseSplit(sp);
-			if (it != sg.end()-1) {
-				hash_ss.eraseSplit(sg.back());
-				*(*it) = (*sg.back());
-			}
-			delete sg.back();
-			sg.pop_back();
-			if (it == sg.end()) break;
-			hash_ss.insertSplit(*it, num);
-        } else {
-            ++it;
-        }
-    }
-	/*
-	sg.taxa = temp.taxa;
-	sg.splits = temp.splits;
-	sg.pda = temp.pda;
-	sg.sets = temp.sets;
-	sg.trees = temp.trees;
-	temp.taxa = NULL;
-	temp.splits = NULL;
-	temp.pda = NULL;
-	temp.sets = NULL;
-	temp.trees = NULL;
-	*/
+	discardRareSplits(sg, hash_ss, split_threshold);
 	cout << nsplits - sg.getNSplits() << " split(s) discarded because frequency <= " << split_threshold << endl;
 }
 
@@ -474,37 +434,83 @@ void MTreeSet::convertSplits(StrVector &taxname, SplitGraph &sg,
 		tree->convertSplits(taxname, *isg);
 		//isg->getTaxa()->Report(cout);
 		//isg->report(cout);
-		for (auto itg = isg->begin(); itg != isg->end(); itg++) {
-			//SplitIntMap::iterator ass_it = hash_ss.find(*itg);
-			int value;
-			//if ((*itg)->getWeight()==0.0) cout << "zero weight!" << endl;
-			Split *sp = hash_ss.findSplit(*itg, value);
-			if (sp != NULL) {
-				//Split *sp = ass_it->first;
-				if (weighting_type != SW_COUNT)
-					sp->setWeight(sp->getWeight() + (*itg)->getWeight() * tree_weights[tree_id]);
-				else
-					sp->setWeight(sp->getWeight() + tree_weights[tree_id]);
-				hash_ss.setValue(sp, value + tree_weights[tree_id]);
+		addSplits(sg, hash_ss, *isg, tree_id, weighting_type, tag_str);
+		delete isg;
+	}
+
+	finishSplitWeights(sg, hash_ss, weighting_type, weight_threshold);
+	//sg.report(cout);
+}
+
+
+void MTreeSet::discardRareSplits(SplitGraph &sg, SplitIntMap &hash_ss, double split_threshold) {
+	double threshold = split_threshold * tree_weights.size();
+//	cout << "threshold = " << threshold << endl;
+    int count=0;
+    for (SplitGraph::iterator it = sg.begin(); it != sg.end(); ) {
+        ++count;
+		//SplitIntMap::iterator ass_it = hash_ss.find(*it);
+		int freq_value;
+		Split *sp = hash_ss.findSplit(*it, freq_value);
+		ASSERT(sp != NULL);
+		ASSERT(*sp == *(*it));
+		//Split *sp = ass_it->first;
+		if (freq_value <= threshold) {
+			if (verbose_mode == VB_DEBUG) {
+				sp->report(cout);
 			}
-			else {
-				sp = new Split(*(*itg));
-				if (weighting_type != SW_COUNT)
-					sp->setWeight((*itg)->getWeight() * tree_weights[tree_id]);
-				else				
-					sp->setWeight(tree_weights[tree_id]);
-				sg.push_back(sp);
-				//SplitIntMap::value_type spair(sp, 1);
-				//hash_ss.insert(spair);
-				
-				hash_ss.insertSplit(sp, tree_weights[tree_id]);
- 			}
-            if (tag_str)
-                sp->name += "@" + convertIntToString(tree_id+1);
+			int num = hash_ss.getValue(sg.back());
+			hash_ss.eraseSplit(sp);
+			if (it != sg.end()-1) {
+				hash_ss.eraseSplit(sg.back());
+				*(*it) = (*sg.back());
+			}
+			delete sg.back();
+			sg.pop_back();
+			if (it == sg.end()) break;
+			hash_ss.insertSplit(*it, num);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void MTreeSet::addSplits(SplitGraph &sg, SplitIntMap &hash_ss, SplitGraph &tree_splits,
+	int tree_id, int weighting_type, char *tag_str)
+{
+	for (auto itg = tree_splits.begin(); itg != tree_splits.end(); itg++) {
+		//SplitIntMap::iterator ass_it = hash_ss.find(*itg);
+		int value;
+		//if ((*itg)->getWeight()==0.0) cout << "zero weight!" << endl;
+		Split *sp = hash_ss.findSplit(*itg, value);
+		if (sp != NULL) {
+			//Split *sp = ass_it->first;
+			if (weighting_type != SW_COUNT)
+				sp->setWeight(sp->getWeight() + (*itg)->getWeight() * tree_weights[tree_id]);
+			else
+				sp->setWeight(sp->getWeight() + tree_weights[tree_id]);
+			hash_ss.setValue(sp, value + tree_weights[tree_id]);
 		}
-		delete isg;
+		else {
+			sp = new Split(*(*itg));
+			if (weighting_type != SW_COUNT)
+				sp->setWeight((*itg)->getWeight() * tree_weights[tree_id]);
+			else				
+				sp->setWeight(tree_weights[tree_id]);
+			sg.push_back(sp);
+			//SplitIntMap::value_type spair(sp, 1);
+			//hash_ss.insert(spair);
+			
+			hash_ss.insertSplit(sp, tree_weights[tree_id]);
+		}
+		if (tag_str)
+			sp->name += "@" + convertIntToString(tree_id+1);
 	}
+}
 
+void MTreeSet::finishSplitWeights(SplitGraph &sg, SplitIntMap &hash_ss,
+	int weighting_type, double weight_threshold)
+{
 	if (weighting_type == SW_AVG_PRESENT) {
 		for (auto itg = sg.begin(); itg != sg.end(); itg++) {
 			int value = 0;
@@ -530,7 +536,142 @@ void MTreeSet::convertSplits(StrVector &taxname, SplitGraph &sg,
     if (discarded) {
         cout << discarded << " split(s) discarded because weight <= " << weight_threshold << endl;
     }
-	//sg.report(cout);
+}
+
+/** number of trees that MTreeSet::readSplits parses together */
+const int READ_SPLITS_CHUNK = 256;
+
+/**
+	read the next tree of a NEWICK stream, up to and including its ';'
+	@param in input stream
+	@param[out] str the tree
+	@return false if there is no further tree
+*/
+static bool readNextTreeString(istream &in, string &str) {
+	str.clear();
+	int comment_depth = 0;
+	char ch;
+	while (in.get(ch)) {
+		if (str.empty() && isspace(ch))
+			continue;
+		str += ch;
+		if (ch == '[')
+			++comment_depth;
+		else if (ch == ']')
+			--comment_depth;
+		else if (ch == ';' && comment_depth <= 0)
+			return true;
+	}
+	// a final tree without ';' is left for readTree to complain about
+	return !str.empty();
+}
+
+void MTreeSet::readSplits(const char *infile, bool &is_rooted, int burnin, int max_count,
+	const char *tree_weight_file, SplitGraph &sg, SplitIntMap &hash_ss,
+	int weighting_type, double weight_threshold)
+{
+	cout << "Reading tree(s) file " << infile << " ..." << endl;
+	IntVector weights;
+	if (tree_weight_file)
+		readIntVector(tree_weight_file, burnin, max_count, weights);
+
+	igzstream in;
+	in.open(infile);
+	if (!in.is_open())
+		outError(ERR_READ_INPUT, infile);
+	string tree_str;
+	for (int cnt = 0; cnt < burnin; cnt++)
+		if (!readNextTreeString(in, tree_str))
+			outError("Burnin value is too large.");
+	if (burnin > 0)
+		cout << burnin << " beginning tree(s) discarded" << endl;
+
+	StrVector taxname;
+	unordered_map<string, int> taxon_id; // leaf name -> leaf ID
+	StrVector chunk;
+	vector<SplitGraph*> chunk_splits;
+	int nrooted = 0;
+	bool more_trees = true;
+	while (more_trees && tree_weights.size() < max_count) {
+		chunk.clear();
+		while (chunk.size() < READ_SPLITS_CHUNK && tree_weights.size() + chunk.size() < max_count) {
+			if (!readNextTreeString(in, tree_str)) {
+				more_trees = false;
+				break;
+			}
+			chunk.push_back(tree_str);
+		}
+		int nchunk = static_cast<int>(chunk.size());
+		if (nchunk == 0)
+			break;
+		int first_id = static_cast<int>(tree_weights.size());
+		if (tree_weight_file && first_id + nchunk > weights.size())
+			outError("Tree file and tree weight file have different number of entries");
+
+		if (taxname.empty()) {
+			// leaf IDs follow the sorted taxon names of the first tree
+			MTree tree;
+			bool myrooted = is_rooted;
+			tree.readTreeBuffer(chunk[0].c_str(), chunk[0].length(), myrooted);
+			tree.getTaxaName(taxname);
+			sort(taxname.begin(), taxname.end());
+			for (int i = 0; i < taxname.size(); i++)
+				taxon_id[taxname[i]] = i;
+			sg.createBlocks();
+			for (auto its = taxname.begin(); its != taxname.end(); its++)
+				sg.getTaxa()->AddTaxonLabel(NxsString(its->c_str()));
+		}
+
+		chunk_splits.assign(nchunk, NULL);
+		int chunk_rooted = 0;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) reduction(+:chunk_rooted)
+#endif
+		for (int i = 0; i < nchunk; i++) {
+			MTree tree;
+			bool myrooted = is_rooted;
+			tree.readTreeBuffer(chunk[i].c_str(), chunk[i].length(), myrooted, &taxon_id);
+			if (tree.rooted)
+				++chunk_rooted;
+			if (tree_weight_file && weights[first_id + i] == 0)
+				continue;
+			if (tree.leafNum != taxname.size())
+				outError("Tree has different number of taxa!");
+			chunk_splits[i] = new SplitGraph();
+			Split sp(tree.leafNum);
+			tree.convertSplits(*chunk_splits[i], &sp);
+		}
+		nrooted += chunk_rooted;
+
+		// add the splits in input order, so that the split system is the same
+		// as with convertSplits
+		for (int i = 0; i < nchunk; i++) {
+			tree_weights.push_back(tree_weight_file ? weights[first_id + i] : 1);
+			if (chunk_splits[i]) {
+				addSplits(sg, hash_ss, *chunk_splits[i], first_id + i, weighting_type, NULL);
+				delete chunk_splits[i];
+			}
+		}
+	}
+	in.close();
+	if (tree_weight_file && tree_weights.size() != weights.size())
+		outError("Tree file and tree weight file have different number of entries");
+	cout << tree_weights.size() << " tree(s) loaded (" << nrooted << " rooted and "
+		<< tree_weights.size() - nrooted << " unrooted)" << endl;
+
+	finishSplitWeights(sg, hash_ss, weighting_type, weight_threshold);
+}
+
+void MTreeSet::readSplits(const char *infile, bool &is_rooted, int burnin, int max_count,
+	const char *tree_weight_file, SplitGraph &sg, double split_threshold,
+	int weighting_type, double weight_threshold)
+{
+	SplitIntMap hash_ss;
+	readSplits(infile, is_rooted, burnin, max_count, tree_weight_file, sg, hash_ss,
+		weighting_type, weight_threshold);
+	int nsplits = static_cast<int>(sg.getNSplits());
+	discardRareSplits(sg, hash_ss, split_threshold);
+	cout << nsplits - sg.getNSplits() << " split(s) discarded because frequency <= " << split_threshold << endl;
 }
 
 
@@ -544,74 +685,212 @@ MTreeSet::~MTreeSet()
 }
 
 
-void MTreeSet::computeRFDist(double *rfdist, int mode, double weight_threshold) {
-	// exit if less than 2 trees
-	if (size() < 2)
-		return;
-#ifdef USE_HASH_MAP
-	cout << "Using hash_map" << endl;
-#else
-	cout << "Using map" << endl;
-#endif
-	cout << "Computing Robinson-Foulds distance..." << endl;
-
-    StrVector taxname(front()->leafNum);
-	vector<SplitIntMap*> hs_vec;
-	vector<SplitGraph*> sg_vec;
+/**
+	mix a 64-bit word into a running hash (splitmix64 finalizer)
+*/
+static inline uint64_t mixSplitWord(uint64_t hash, uint64_t word) {
+	uint64_t z = hash + word + 0x9e3779b97f4a7c15ULL;
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
 
-	front()->getTaxaName(taxname);
+/**
+	@return fingerprint of a split given as a taxon bitset
+	@param taxa bitset of the taxa on one side of the split
+	@param nwords number of 64-bit words in the bitset
+	@param ntaxa number of taxa
+	@param heavy true if the branch weight reaches the weight threshold
+*/
+static SplitFingerprint makeSplitFingerprint(const uint64_t *taxa, int nwords, int ntaxa, bool heavy) {
+	// make sure that taxon 0 is included
+	bool invert = (taxa[0] & 1) == 0;
+	uint64_t hi = 0x243f6a8885a308d3ULL;
+	uint64_t lo = 0x13198a2e03707344ULL;
+	for (int i = 0; i < nwords; i++) {
+		uint64_t word = invert ? ~taxa[i] : taxa[i];
+		if (i == nwords-1 && ntaxa % 64 != 0)
+			word &= (((uint64_t)1) << (ntaxa % 64)) - 1;
+		hi = mixSplitWord(hi, word);
+		lo = mixSplitWord(lo, word ^ 0x5bd1e9955bd1e995ULL);
+	}
+	SplitFingerprint fp;
+	fp.hi = hi;
+	fp.lo = (lo & ~((uint64_t)1)) | (heavy ? 1 : 0);
+	return fp;
+}
 
+/**
+	collect the split fingerprints of the subtree below node, in the same
+	way as MTree::convertSplits collects its splits
+	@param[out] taxa bitset of the taxa in the subtree (must be zeroed by the caller)
+*/
+static void getSplitFingerprints(Node *node, Node *dad, int nwords, int ntaxa,
+	double weight_threshold, uint64_t *taxa, SplitFingerprintVector &fingerprints)
+{
+	bool has_child = false;
+	uint64_t *child_taxa = NULL;
+	FOR_NEIGHBOR_IT(node, dad, it) {
+		if (!child_taxa)
+			child_taxa = new uint64_t[nwords];
+		memset(child_taxa, 0, nwords*sizeof(uint64_t));
+		getSplitFingerprints((*it)->node, node, nwords, ntaxa, weight_threshold, child_taxa, fingerprints);
+		for (int i = 0; i < nwords; i++)
+			taxa[i] |= child_taxa[i];
+		/* ignore nodes with degree of 2 because such split will be added before */
+		if (node->degree() != 2)
+			fingerprints.push_back(makeSplitFingerprint(child_taxa, nwords, ntaxa,
+				(*it)->length >= weight_threshold));
+		has_child = true;
+	}
+	delete [] child_taxa;
+	if (!has_child)
+		taxa[node->id / 64] |= ((uint64_t)1) << (node->id % 64);
+}
 
-	// converting trees into split system then stored in SplitIntMap for efficiency
-	for (iterator it = begin(); it != end(); it++) {
-		SplitGraph *sg = new SplitGraph();
-		SplitIntMap *hs = new SplitIntMap();
+void MTreeSet::computeSplitFingerprints(MTree *tree, double weight_threshold,
+	SplitFingerprintVector &fingerprints)
+{
+	int nwords = (tree->leafNum + 63) / 64;
+	uint64_t *taxa = new uint64_t[nwords];
+	memset(taxa, 0, nwords*sizeof(uint64_t));
+	fingerprints.clear();
+	getSplitFingerprints(tree->root, NULL, nwords, tree->leafNum, weight_threshold, taxa, fingerprints);
+	delete [] taxa;
+	sort(fingerprints.begin(), fingerprints.end());
+	fingerprints.erase(unique(fingerprints.begin(), fingerprints.end()), fingerprints.end());
+}
 
-		(*it)->convertSplits(taxname, *sg);
-		// make sure that taxon 0 is included
-		for (SplitGraph::iterator sit = sg->begin(); sit != sg->end(); sit++) {
-			if (!(*sit)->containTaxon(0)) (*sit)->invert();
-			hs->insertSplit((*sit), 1);
+/**
+	@return number of splits with weight above the threshold that occur in
+	only one of the two trees
+*/
+static int countDifferentSplits(const SplitFingerprintVector &fp1, const SplitFingerprintVector &fp2) {
+	int diff_splits = 0;
+	SplitFingerprintVector::const_iterator it1 = fp1.begin(), it2 = fp2.begin();
+	while (it1 != fp1.end() && it2 != fp2.end()) {
+		if (*it1 < *it2) {
+			diff_splits += it1->isHeavy();
+			++it1;
+		} else if (*it2 < *it1) {
+			diff_splits += it2->isHeavy();
+			++it2;
+		} else {
+			++it1;
+			++it2;
 		}
-		hs_vec.push_back(hs);
-		sg_vec.push_back(sg);
 	}
+	for (; it1 != fp1.end(); ++it1)
+		diff_splits += it1->isHeavy();
+	for (; it2 != fp2.end(); ++it2)
+		diff_splits += it2->isHeavy();
+	return diff_splits;
+}
 
-	// now start the RF computation
-	int id = 0;
-	for (vector<SplitIntMap*>::iterator hsit = hs_vec.begin(); hsit+1 != hs_vec.end(); hsit++, id++) {
-		vector<SplitIntMap*>::iterator end_it = hs_vec.end();
-		if (mode == RF_ADJACENT_PAIR) end_it = hsit+2;
-		int id2 = id+1;
-		for (vector<SplitIntMap*>::iterator hsit2 = hsit+1; hsit2 != end_it; hsit2++, id2++) {
-			int diff_splits = 0;
-			SplitIntMap::iterator spit;
-			for (spit = (*hsit2)->begin(); spit != (*hsit2)->end(); spit++) {
-                if (spit->first->getWeight() >= weight_threshold &&
-                    !(*hsit)->findSplit(spit->first)) {
-                    ++diff_splits;
-                }
-			}
-			for (spit = (*hsit)->begin(); spit != (*hsit)->end(); spit++) {
-                if (spit->first->getWeight() >= weight_threshold &&
-                    !(*hsit2)->findSplit(spit->first)) {
-                    ++diff_splits;
-                }
-			}
-			//int rf_val = (*hsit)->size() + (*hsit2)->size() - 2*common_splits;
-			int rf_val = diff_splits;
-			if (mode == RF_ADJACENT_PAIR) 
+void MTreeSet::computeRFDist(vector<SplitFingerprintVector> &fingerprints, double *rfdist, int mode) {
+	int ntrees = static_cast<int>(fingerprints.size());
+	// exit if less than 2 trees
+	if (ntrees < 2)
+		return;
+	cout << "Computing Robinson-Foulds distance..." << endl;
+	// rows get shorter towards the end, hence dynamic scheduling
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+	for (int id = 0; id < ntrees-1; id++) {
+		int end_id = (mode == RF_ADJACENT_PAIR) ? id+2 : ntrees;
+		for (int id2 = id+1; id2 < end_id; id2++) {
+			int rf_val = countDifferentSplits(fingerprints[id], fingerprints[id2]);
+			if (mode == RF_ADJACENT_PAIR)
 				rfdist[id] = rf_val;
 			else {
-				rfdist[id*size() + id2] = rfdist[id2*size() + id] = rf_val;
+				rfdist[(size_t)id*ntrees + id2] = rfdist[(size_t)id2*ntrees + id] = rf_val;
 			}
 		}
 	}
-	// delete memory 
-	for (id = static_cast<int>(size())-1; id >= 0; id--) {
-		delete hs_vec[id];
-		delete sg_vec[id];
+}
+
+void MTreeSet::computeRFDist(double *rfdist, int mode, double weight_threshold) {
+	// exit if less than 2 trees
+	if (size() < 2)
+		return;
+
+	// converting trees into sorted split fingerprints for efficiency
+	int ntrees = static_cast<int>(size());
+	vector<SplitFingerprintVector> fingerprints(ntrees);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+	for (int id = 0; id < ntrees; id++)
+		computeSplitFingerprints(at(id), weight_threshold, fingerprints[id]);
+
+	computeRFDist(fingerprints, rfdist, mode);
+}
+
+void MTreeSet::readSplitFingerprints(const char *infile, bool &is_rooted, int burnin,
+	int max_count, double weight_threshold, vector<SplitFingerprintVector> &fingerprints)
+{
+	cout << "Reading tree(s) file " << infile << " one tree at a time ..." << endl;
+	fingerprints.clear();
+	StrVector taxname; // sorted taxon names of the first tree
+	int nrooted = 0;
+	try {
+		ifstream in;
+		in.exceptions(ios::failbit | ios::badbit);
+		in.open(infile);
+		if (burnin > 0) {
+			int cnt = 0;
+			while (cnt < burnin && !in.eof()) {
+				char ch;
+				in >> ch;
+				if (ch == ';') {
+					++cnt;
+				}
+			}
+			cout << cnt << " beginning tree(s) discarded" << endl;
+			if (in.eof())
+				throw "Burnin value is too large.";
+		}
+		for (int count = 1; !in.eof() && count <= max_count; count++) {
+			MTree tree;
+			bool myrooted = is_rooted;
+			tree.readTree(in, myrooted);
+			if (tree.rooted)
+				++nrooted;
+			// assign leaf IDs by sorted names, like checkConsistency
+			NodeVector taxa;
+			tree.getTaxa(taxa);
+			sort(taxa.begin(), taxa.end(), nodenamecmp);
+			for (int i = 0; i < taxa.size(); i++)
+				taxa[i]->id = i;
+			if (taxname.empty()) {
+				for (int i = 0; i < taxa.size(); i++)
+					taxname.push_back(taxa[i]->name);
+			} else {
+				if (taxa.size() != taxname.size())
+					outError("Tree " + convertIntToString(count) + " has a different number of taxa");
+				for (int i = 0; i < taxa.size(); i++)
+					if (taxa[i]->name != taxname[i])
+						outError("Tree " + convertIntToString(count) + " has a different taxon set");
+			}
+			fingerprints.resize(fingerprints.size()+1);
+			computeSplitFingerprints(&tree, weight_threshold, fingerprints.back());
+
+			char ch;
+			in.exceptions(ios::goodbit);
+			in >> ch;
+			if (in.eof()) break;
+			in.unget();
+			in.exceptions(ios::failbit | ios::badbit);
+		}
+		in.close();
+	} catch (ios::failure) {
+		outError(ERR_READ_INPUT, infile);
+	} catch (const char* str) {
+		outError(str);
 	}
+	cout << fingerprints.size() << " tree(s) loaded (" << nrooted << " rooted and "
+		<< fingerprints.size() - nrooted << " unrooted)" << endl;
 }
 
 
@@ -26,6 +26,30 @@
 
 void readIntVector(const char *file_name, int burnin, int max_count, IntVector &vec);
 
+/**
+	128-bit fingerprint of a split (normalized to contain taxon 0), as used
+	for Robinson-Foulds distances. The lowest bit of lo is not part of the
+	fingerprint: it is set if the branch weight reaches the weight threshold.
+*/
+struct SplitFingerprint {
+	uint64_t hi;
+	uint64_t lo;
+
+	/** @return true if the split's branch weight reaches the threshold */
+	bool isHeavy() const { return (lo & 1) != 0; }
+
+	bool operator<(const SplitFingerprint &other) const {
+		return hi < other.hi || (hi == other.hi && (lo >> 1) < (other.lo >> 1));
+	}
+
+	bool operator==(const SplitFingerprint &other) const {
+		return hi == other.hi && (lo >> 1) == (other.lo >> 1);
+	}
+};
+
+/** sorted, duplicate-free split fingerprints of a tree */
+typedef vector<SplitFingerprint> SplitFingerprintVector;
+
 /**
 Set of trees
 
@@ -158,6 +182,35 @@ public:
 	void convertSplits(SplitGraph &sg, double split_threshold, 
 		int weighting_type, double weight_threshold);
 
+	/**
+		read trees from a NEWICK file (plain or gzipped) and convert them into
+		the split system one chunk of trees at a time, never keeping the trees.
+		Trees of a chunk are parsed in parallel; their splits are then added in
+		input order, so the result is the same as init() then convertSplits().
+		Leaf IDs follow the sorted taxon names of the first tree.
+		Only tree_weights is filled, with one entry per tree read.
+		@param infile the name of the tree file
+		@param is_rooted (IN/OUT) true if trees are rooted
+		@param burnin the number of beginning trees to be discarded
+		@param max_count max number of trees to load
+		@param tree_weight_file file containing a weight for each tree (or NULL)
+		@param sg (OUT) resulting split graph
+		@param hash_ss (OUT) hash split set
+		@param weighting_type split weighting, as for convertSplits
+		@param weight_threshold minimum weight cutoff
+	*/
+	void readSplits(const char *infile, bool &is_rooted, int burnin, int max_count,
+		const char *tree_weight_file, SplitGraph &sg, SplitIntMap &hash_ss,
+		int weighting_type, double weight_threshold);
+
+	/**
+		like readSplits above, but only keep those splits which appear in more
+		than split_threshold of the trees (as convertSplits does)
+	*/
+	void readSplits(const char *infile, bool &is_rooted, int burnin, int max_count,
+		const char *tree_weight_file, SplitGraph &sg, double split_threshold,
+		int weighting_type, double weight_threshold);
+
 	/**
 		compute the Robinson-Foulds distance between trees
 		@param rfdist (OUT) RF distance
@@ -166,6 +219,39 @@ public:
 	*/
 	void computeRFDist(double *rfdist, int mode = RF_ALL_PAIR, double weight_threshold = -1000);
 
+	/**
+		compute the split fingerprints of a tree, whose leaf IDs must already
+		be assigned consistently with the other trees (see checkConsistency)
+		@param tree the tree
+		@param weight_threshold minimum weight for a split to count towards distances
+		@param[out] fingerprints sorted, duplicate-free split fingerprints
+	*/
+	static void computeSplitFingerprints(MTree *tree, double weight_threshold,
+		SplitFingerprintVector &fingerprints);
+
+	/**
+		compute the Robinson-Foulds distance between trees given by their split
+		fingerprints, comparing pairs of trees in parallel by merging sorted fingerprints
+		@param fingerprints split fingerprints of each tree
+		@param rfdist (OUT) RF distance
+		@param mode RF_ALL_PAIR or RF_ADJACENT_PAIR
+	*/
+	static void computeRFDist(vector<SplitFingerprintVector> &fingerprints, double *rfdist,
+		int mode = RF_ALL_PAIR);
+
+	/**
+		read trees from a NEWICK file one at a time, keeping only their split
+		fingerprints (so that the trees are never all in memory at once)
+		@param infile the name of the tree file
+		@param is_rooted (IN/OUT) true if trees are rooted
+		@param burnin the number of beginning trees to be discarded
+		@param max_count max number of trees to load
+		@param weight_threshold minimum weight for a split to count towards distances
+		@param[out] fingerprints split fingerprints of each tree
+	*/
+	static void readSplitFingerprints(const char *infile, bool &is_rooted, int burnin,
+		int max_count, double weight_threshold, vector<SplitFingerprintVector> &fingerprints);
+
 	/**
 		compute the Robinson-Foulds distance between trees
 		@param[out] rfdist output RF distance
@@ -191,6 +277,36 @@ public:
 	*/
 	virtual MTree *newTree() { return new MTree(); }
 
+	/**
+		add the splits of one tree to the split system
+		@param sg (IN/OUT) split graph
+		@param hash_ss (IN/OUT) hash split set
+		@param tree_splits splits of the tree
+		@param tree_id ID of the tree (for tree_weights and tag_str)
+		@param weighting_type split weighting, as for convertSplits
+		@param tag_str TRUE to tag each split with the trees it appears in
+	*/
+	void addSplits(SplitGraph &sg, SplitIntMap &hash_ss, SplitGraph &tree_splits,
+		int tree_id, int weighting_type, char *tag_str);
+
+	/**
+		turn summed split weights into the requested weighting and drop light splits
+		@param sg (IN/OUT) split graph
+		@param hash_ss hash split set
+		@param weighting_type split weighting, as for convertSplits
+		@param weight_threshold minimum weight cutoff
+	*/
+	void finishSplitWeights(SplitGraph &sg, SplitIntMap &hash_ss,
+		int weighting_type, double weight_threshold);
+
+	/**
+		discard the splits that appear in at most split_threshold of the trees
+		@param sg (IN/OUT) split graph
+		@param hash_ss (IN/OUT) hash split set
+		@param split_threshold frequency threshold
+	*/
+	void discardRareSplits(SplitGraph &sg, SplitIntMap &hash_ss, double split_threshold);
+
     /** weight vector for trees */
 	IntVector tree_weights;
 
@@ -89,7 +89,8 @@ public:
             for (intptr_t c=r+1; c<row_count; ++c) {
                 auto colVector = topOfCluster[c]->partial_pars;
                 int score;
-                tree->computeParsimonyOutOfTree( rowVector, colVector, &score );
+                tree->computeParsimonyOutOfTree( rowVector, colVector, &score,
+                                                 PARS_BRANCH_PARALLEL );
                 currRow[c] = static_cast<T>(score);
             }
             progress += (row_count - r);
@@ -163,7 +164,8 @@ public:
                 //Parsimony distance
                 auto iVector  = topOfCluster[rowToCluster[i]]->partial_pars;
                 int score     = 0;
-                tree->computeParsimonyOutOfTree( abVector, iVector, &score );
+                tree->computeParsimonyOutOfTree( abVector, iVector, &score,
+                                                 PARS_BRANCH_PARALLEL );
                 T Dci         = static_cast<T>(score);
 
                 aRow[i]       = Dci;
@@ -318,10 +320,11 @@ public:
             PhyloNeighbor* nei2 = b.getRightNeighbor();
             tree.computePartialParsimonyOutOfTree(nei1->get_partial_pars(),
                                                   nei2->get_partial_pars(),
-                                                  scratch_vector);
+                                                  scratch_vector,
+                                                  PARS_BRANCH_PARALLEL);
             int branch_score = 0;
             tree.computeParsimonyOutOfTree(pars, scratch_vector,
-                                           &branch_score);
+                                           &branch_score, PARS_BRANCH_PARALLEL);
             if ( s == 0 || branch_score<candidate.best_score) {
                 candidate.best_score  = branch_score;
                 candidate.best_branch = sample[s];
@@ -362,9 +365,11 @@ public:
                 PhyloNeighbor* nei2 = b.getRightNeighbor();
                 tree.computePartialParsimonyOutOfTree(nei1->get_partial_pars(),
                                                       nei2->get_partial_pars(),
-                                                      scratch_vector);
+                                                      scratch_vector,
+                                                      PARS_BRANCH_PARALLEL);
                 int branch_score = 0;
-                tree.computeParsimonyOutOfTree(pars, scratch_vector, &branch_score);
+                tree.computeParsimonyOutOfTree(pars, scratch_vector, &branch_score,
+                                               PARS_BRANCH_PARALLEL);
                 auto touching_nei = doesFirstTouch(b, target) ? nei1 : nei2;
                 int subtree_score = tree.getSubTreeParsimony(touching_nei);
                 if (branch_score<taxon.best_score) {
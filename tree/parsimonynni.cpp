@@ -94,7 +94,8 @@ void ParsimonyNNIMove::findMove(const PhyloTree& tree, /* problem, not const */
     double cost1 = ParallelParsimonyCalculator::parsimonyLink4CostOutOfTree
                    ( tree, left1, right1, tb.first, tb.second,
                      left2, right2,
-                     path_parsimony[0], path_parsimony[1]);
+                     path_parsimony[0], path_parsimony[1],
+                     PARS_BRANCH_PARALLEL);
     TREE_LOG_LINE(tree, VB_DEBUG, "for " << source_branch_id
                   << " cost1 " << cost1 << ","
                   << " oldcost " << parsimony_score );
@@ -103,7 +104,8 @@ void ParsimonyNNIMove::findMove(const PhyloTree& tree, /* problem, not const */
     double cost2 = ParallelParsimonyCalculator::parsimonyLink4CostOutOfTree
                    ( tree, left1, right2, tb.first,
                      tb.second, left2, right1,
-                     path_parsimony[0], path_parsimony[1]);
+                     path_parsimony[0], path_parsimony[1],
+                     PARS_BRANCH_PARALLEL);
     TREE_LOG_LINE(tree, VB_DEBUG, "for " << source_branch_id
                   << " cost2 " << cost2 << ","
                   << " oldcost " << parsimony_score );
@@ -194,9 +196,9 @@ double ParsimonyNNIMove::apply(PhyloTree& tree,
     std::swap(nei_to_right->partial_pars, buffer2[0]);
     nei_to_right->setParsimonyComputed(true);
     
-    //Mark inward views as out of date
-    middle.first->clearReversePartialParsimony (middle.second);
-    middle.second->clearReversePartialParsimony(middle.first);
+    //Mark inward views as out of date (and remember them, so that
+    //rescoring need only recompute them)
+    tree.invalidateReverseParsimony(middle.first, middle.second);
             
     ParallelParsimonyCalculator ppc(tree, false);
     parsimony_score = ppc.computeParsimonyBranch(middle.getLeftNeighbor(), middle.first);
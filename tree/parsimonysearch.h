@@ -133,9 +133,18 @@ int PhyloTree::optimizeSubtreeParsimony(ParsimonySearchParameters& s,
     timeSpent.start();
     for (intptr_t iteration=1; iteration<=s.iterations; ++iteration) {
         s.rescoring.start();
-        parsimony_score = computeParsimony("Determining two-way parsimony", true, true,
-                                           targets[0].first->findNeighbor(targets[0].second),
-                                           targets[0].first);
+        context.setPhase(PARS_SITE_PARALLEL);
+        if (iteration==1) {
+            dirty_parsimony_views.clear();
+            parsimony_score = computeParsimony("Determining two-way parsimony", true, true,
+                                               targets[0].first->findNeighbor(targets[0].second),
+                                               targets[0].first);
+        } else {
+            //Only the views that the moves applied in the previous
+            //iteration invalidated need to be recomputed.
+            parsimony_score = computeDirtyParsimony(targets[0].first->findNeighbor(targets[0].second),
+                                                    targets[0].first);
+        }
         s.rescoring.stop();
         if (!s.be_quiet) {
             if (iteration==1) {
@@ -155,13 +164,17 @@ int PhyloTree::optimizeSubtreeParsimony(ParsimonySearchParameters& s,
         s.evaluating.start();
         LikelihoodBlockPairs dummyBlocks(0);
         
+        //Moves are evaluated for many branches at once, so the
+        //parsimony kernels called while evaluating them run serially.
+        context.setPhase(PARS_BRANCH_PARALLEL);
         LOG_LINE(VB_DEBUG, "Computing branch initial states");
 #ifdef _OPENMP
-#pragma omp parallel for
+#pragma omp parallel for num_threads(context.getBranchThreadCount())
 #endif
         for (intptr_t i=0; i<branch_count; ++i) {
             TargetBranch&     tb   = targets[i];
-            tb.computeState(*this, parsimony_score, i, dummyBlocks);
+            tb.computeState(*this, parsimony_score, i, dummyBlocks,
+                            context.getPhase());
             LOG_LINE(VB_DEBUG, "Branch " << i
                      << " has branch cost " << tb.getBranchCost()
                      << " and connection_cost " << tb.getConnectionCost() );
@@ -171,7 +184,7 @@ int PhyloTree::optimizeSubtreeParsimony(ParsimonySearchParameters& s,
         moves.resize(branch_count);
         
 #ifdef _OPENMP
-#pragma omp parallel for num_threads(num_threads) reduction(+:positions_considered)
+#pragma omp parallel for num_threads(context.getBranchThreadCount()) reduction(+:positions_considered)
 #endif
         for (intptr_t i=0; i<branch_count; ++i) {
             Move&         move   = moves[i];
@@ -189,6 +202,7 @@ int PhyloTree::optimizeSubtreeParsimony(ParsimonySearchParameters& s,
         }
         trackProgress(static_cast<double>(branch_count % 100));
         s.evaluating.stop();
+        context.setPhase(PARS_SITE_PARALLEL);
         
         LOG_LINE(VB_DEBUG, "sorting " << s.name << " moves");
         s.sorting.start();
@@ -297,14 +311,9 @@ int PhyloTree::optimizeSubtreeParsimony(ParsimonySearchParameters& s,
     }
     
     if (rescore_when_done) {
-        s.initializing.start();
-        clearAllPartialParsimony(false);
-        s.initializing.stop();
-        
         s.rescoring.start();
-        parsimony_score = computeParsimony("Determining one-way parsimony", false, true,
-                                           targets[0].first->findNeighbor(targets[0].second),
-                                           targets[0].first);
+        parsimony_score = computeDirtyParsimony(targets[0].first->findNeighbor(targets[0].second),
+                                                targets[0].first);
         s.rescoring.stop();
     }
     
@@ -344,9 +353,18 @@ int PhyloTree::optimizeRandomSubtreeParsimony(ParsimonySearchParameters& s,
     timeSpent.start();
     for (intptr_t iteration=1; iteration<=s.iterations; ++iteration) {
         s.rescoring.start();
-        parsimony_score = computeParsimony("Determining two-way parsimony", true, true,
-                                           targets[0].first->findNeighbor(targets[0].second),
-                                           targets[0].first);
+        context.setPhase(PARS_SITE_PARALLEL);
+        if (iteration==1) {
+            dirty_parsimony_views.clear();
+            parsimony_score = computeParsimony("Determining two-way parsimony", true, true,
+                                               targets[0].first->findNeighbor(targets[0].second),
+                                               targets[0].first);
+        } else {
+            //Only the views that the moves applied in the previous
+            //iteration invalidated need to be recomputed.
+            parsimony_score = computeDirtyParsimony(targets[0].first->findNeighbor(targets[0].second),
+                                                    targets[0].first);
+        }
         s.rescoring.stop();
         if (!s.be_quiet) {
             if (iteration==1) {
@@ -366,13 +384,17 @@ int PhyloTree::optimizeRandomSubtreeParsimony(ParsimonySearchParameters& s,
         s.evaluating.start();
         LikelihoodBlockPairs dummyBlocks(0);
         
+        //Moves are evaluated for many branches at once, so the
+        //parsimony kernels called while evaluating them run serially.
+        context.setPhase(PARS_BRANCH_PARALLEL);
         LOG_LINE(VB_DEBUG, "Computing branch initial states");
 #ifdef _OPENMP
-#pragma omp parallel for
+#pragma omp parallel for num_threads(context.getBranchThreadCount())
 #endif
         for (intptr_t i=0; i<branch_count; ++i) {
             TargetBranch&     tb   = targets[i];
-            tb.computeState(*this, parsimony_score, i, dummyBlocks);
+            tb.computeState(*this, parsimony_score, i, dummyBlocks,
+                            context.getPhase());
             LOG_LINE(VB_DEBUG, "Branch " << i
                      << " has branch cost " << tb.getBranchCost()
                      << " and connection_cost " << tb.getConnectionCost() );
@@ -382,7 +404,7 @@ int PhyloTree::optimizeRandomSubtreeParsimony(ParsimonySearchParameters& s,
         moves.resize(branch_count);
         
 #ifdef _OPENMP
-#pragma omp parallel for num_threads(num_threads) reduction(+:positions_considered)
+#pragma omp parallel for num_threads(context.getBranchThreadCount()) reduction(+:positions_considered)
 #endif
         for (intptr_t i=0; i<branch_count; ++i) {
             Move&         move   = moves[i];
@@ -400,6 +422,7 @@ int PhyloTree::optimizeRandomSubtreeParsimony(ParsimonySearchParameters& s,
         }
         trackProgress(static_cast<double>(branch_count % 100));
         s.evaluating.stop();
+        context.setPhase(PARS_SITE_PARALLEL);
         
         LOG_LINE(VB_DEBUG, "sorting " << s.name << " moves");
         s.sorting.start();
@@ -519,14 +542,9 @@ int PhyloTree::optimizeRandomSubtreeParsimony(ParsimonySearchParameters& s,
     }
     
     if (rescore_when_done) {
-        s.initializing.start();
-        clearAllPartialParsimony(false);
-        s.initializing.stop();
-        
         s.rescoring.start();
-        parsimony_score = computeParsimony("Determining one-way parsimony", false, true,
-                                           targets[0].first->findNeighbor(targets[0].second),
-                                           targets[0].first);
+        parsimony_score = computeDirtyParsimony(targets[0].first->findNeighbor(targets[0].second),
+                                                targets[0].first);
         s.rescoring.stop();
     }
     
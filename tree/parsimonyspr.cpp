@@ -52,7 +52,8 @@ void ParsimonyLazySPRMove::LazySPRSearch::searchForForwardsSPR
         }
         int target_branch_id = (*it)->id;
         const TargetBranch& target = branches[target_branch_id];
-        double cost    = source.getForwardConnectionCost(tree, target);
+        double cost    = source.getForwardConnectionCost(tree, target,
+                                                         PARS_BRANCH_PARALLEL);
         double benefit = discon - cost;
         if (put_answer_here.benefit<benefit) {
             put_answer_here.benefit          = benefit;
@@ -71,7 +72,8 @@ void ParsimonyLazySPRMove::LazySPRSearch::searchForBackwardsSPR
         }
         int target_branch_id = (*it)->id;
         const TargetBranch& target = branches[target_branch_id];
-        double cost    = source.getBackwardConnectionCost(tree, target);
+        double cost    = source.getBackwardConnectionCost(tree, target,
+                                                          PARS_BRANCH_PARALLEL);
         double benefit = discon - cost;
         if (put_answer_here.benefit<benefit) {
             put_answer_here.benefit          = benefit;
@@ -213,12 +215,23 @@ double ParsimonyLazySPRMove::apply(PhyloTree& tree,  double parsimony_score,
     new_right ->updateNeighbor(new_left,   moved_node);
     
     TargetBranch& left_branch  = branches[snip_left_id];
-    left_branch.updateMapping(snip_left_id, new_left, moved_node, true);
+    left_branch.updateMapping(snip_left_id, new_left, moved_node, false);
             
     TargetBranch& right_branch = branches[snip_right_id];
-    right_branch.updateMapping(snip_right_id, new_right, moved_node, true);
+    right_branch.updateMapping(snip_right_id, new_right, moved_node, false);
     
-    target.updateMapping(target_branch_id, snip_left, snip_right, true);
+    target.updateMapping(target_branch_id, snip_left, snip_right, false);
+    
+    //Only the views on (and looking toward) the three branches
+    //that were rewired are out of date.  They are remembered, so
+    //that rescoring need only recompute them (see
+    //PhyloTree::computeDirtyParsimony).
+    tree.invalidateBranchParsimony (new_left,   moved_node);
+    tree.invalidateBranchParsimony (new_right,  moved_node);
+    tree.invalidateBranchParsimony (snip_left,  snip_right);
+    tree.invalidateReverseParsimony(new_left,   moved_node);
+    tree.invalidateReverseParsimony(new_right,  moved_node);
+    tree.invalidateReverseParsimony(snip_left,  snip_right);
     //Note: The branch that target_branch_id now refers to,
     //      is the branch that, were we reversing the SPR,
     //      would be the "new" target branch (it's the branch
@@ -281,7 +294,7 @@ void ParsimonySPRMove::ProperSPRSearch::searchForForwardsSPR(PhyloNode* current,
         UINT*      off_path_vector = current->findNeighbor(off_path_node)->get_partial_pars();
         tree.computePartialParsimonyOutOfTree
             ( on_path_vector, off_path_vector
-            , path_parsimony[radius] );
+            , path_parsimony[radius], PARS_BRANCH_PARALLEL );
         if (1<radius) {
             searchForForwardsSPR(next, current, radius-1, parsimony);
         }
@@ -289,12 +302,13 @@ void ParsimonySPRMove::ProperSPRSearch::searchForForwardsSPR(PhyloNode* current,
         
         double pruned_tree_score = tree.computePartialParsimonyOutOfTree
                                    ( current->findNeighbor(next)->get_partial_pars()
-                                   , path_parsimony[radius], path_parsimony[0] );
+                                   , path_parsimony[radius], path_parsimony[0]
+                                   , PARS_BRANCH_PARALLEL );
         int new_branch_cost = 0;
         tree.computeParsimonyOutOfTree
             ( path_parsimony[0]
             , source.first->findNeighbor(source.second)->get_partial_pars()
-            , &new_branch_cost );
+            , &new_branch_cost, PARS_BRANCH_PARALLEL );
         auto   subtree_root_nei = source.first->findNeighbor(source.second);
         double subtree_cost = tree.getSubTreeParsimony(subtree_root_nei);
         double benefit = parsimony       - pruned_tree_score
@@ -316,7 +330,7 @@ void ParsimonySPRMove::ProperSPRSearch::searchForBackwardsSPR
         UINT*      off_path_vector = current->findNeighbor(off_path_node)->get_partial_pars();
         tree.computePartialParsimonyOutOfTree
             ( on_path_vector, off_path_vector
-            , path_parsimony[radius] );
+            , path_parsimony[radius], PARS_BRANCH_PARALLEL );
         if (1<radius) {
             searchForBackwardsSPR(next, current, radius-1, parsimony);
         }
@@ -324,12 +338,13 @@ void ParsimonySPRMove::ProperSPRSearch::searchForBackwardsSPR
         
         double pruned_tree_score = tree.computePartialParsimonyOutOfTree
                                    ( current->findNeighbor(next)->get_partial_pars()
-                                   , path_parsimony[radius], path_parsimony[0] );
+                                   , path_parsimony[radius], path_parsimony[0]
+                                   , PARS_BRANCH_PARALLEL );
         int new_branch_cost = 0;
         tree.computeParsimonyOutOfTree
             ( path_parsimony[0]
             , source.second->findNeighbor(source.first)->get_partial_pars()
-            , &new_branch_cost );
+            , &new_branch_cost, PARS_BRANCH_PARALLEL );
         auto   subtree_root_nei = source.second->findNeighbor(source.first);
         double subtree_cost = tree.getSubTreeParsimony(subtree_root_nei);
         double benefit = parsimony       - pruned_tree_score
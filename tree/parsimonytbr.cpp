@@ -9,9 +9,13 @@
 //  its estimates were better, it would be worth using).
 //  (ParsimonyLazyTBRMove::apply() works, all it needs is
 //  better benefit estimates).
+//  (ProperParsimonyTBRMove scores moves exactly, by calculating
+//   the parsimony vectors of both subtrees, rerooted at each of
+//   the branches within range, and reconnecting them).
 //
 
 #include "parsimonytbr.h"
+#include "parsimonyspr.h"                          //for ParsimonySPRMove
 
 #include "phylotree.h"
 #include "parsimonysearch.h"
@@ -177,7 +181,7 @@ void ParsimonyLazyTBRMove::LazyTBRSearch::searchPart2
         int  reconnect_cost = 0;
         tree.computeParsimonyOutOfTree(branch_one.getParsimonyBlock(),
                                        branch_two.getParsimonyBlock(),
-                                       &reconnect_cost);
+                                       &reconnect_cost, PARS_BRANCH_PARALLEL);
         double gain = move.disconnection_benefit - reconnect_cost;
         considerMove(first_id, second_id, gain, depth);
     }
@@ -267,10 +271,11 @@ void ParsimonyLazyTBRMove::reconnect(PhyloNode* first, PhyloNode* second,
 }
 
 void ParsimonyLazyTBRMove::updateBranch
-    ( TargetBranchRange& branches, intptr_t id,
+    ( PhyloTree& tree, TargetBranchRange& branches, intptr_t id,
       PhyloNode* left, PhyloNode* right) {
     TargetBranch& branch = branches[id];
     branch.updateMapping(id, left, right, false);
+    tree.invalidateBranchParsimony(left, right);
 }
 
 double ParsimonyLazyTBRMove::apply
@@ -296,9 +301,12 @@ double ParsimonyLazyTBRMove::apply
     // 4. what was ED, becomes ID
     // 5. what was FD, becomes JD
     //
-    TargetBranch& t1    = branches[first_target_branch_id].clearReverseParsimony();
-    TargetBranch& t2    = branches[second_target_branch_id].clearReverseParsimony();
-    TargetBranch& moved = branches[source_branch_id].clearReverseParsimony();
+    TargetBranch& t1    = branches[first_target_branch_id];
+    TargetBranch& t2    = branches[second_target_branch_id];
+    TargetBranch& moved = branches[source_branch_id];
+    tree.invalidateReverseParsimony(t1.first,    t1.second);
+    tree.invalidateReverseParsimony(t2.first,    t2.second);
+    tree.invalidateReverseParsimony(moved.first, moved.second);
     
     PhyloNode* nodes[10];     //nodes that are invoved (A through J)
     intptr_t   branch_ids[7]; //branches that get messed with (element [6] is moved)
@@ -316,12 +324,13 @@ double ParsimonyLazyTBRMove::apply
     reconnect ( nodes[6], nodes[7], nodes[2]/*C*/, nodes[3] );//Link C to G and H and vice versa
     reconnect ( nodes[8], nodes[9], nodes[3]/*D*/, nodes[2] );//Link D to I and J and vice versa
     
-    updateBranch ( branches, branch_ids[0], nodes[0], nodes[1]); //t1 now AB
-    updateBranch ( branches, branch_ids[1], nodes[4], nodes[5]); //t2 now EF
-    updateBranch ( branches, branch_ids[2], nodes[6], nodes[2]); //AC becomes GC
-    updateBranch ( branches, branch_ids[3], nodes[7], nodes[2]); //BC becomes HC
-    updateBranch ( branches, branch_ids[4], nodes[8], nodes[3]); //ED becomes ID
-    updateBranch ( branches, branch_ids[5], nodes[9], nodes[3]); //FD becomes JD
+    updateBranch ( tree, branches, branch_ids[0], nodes[0], nodes[1]); //t1 now AB
+    updateBranch ( tree, branches, branch_ids[1], nodes[4], nodes[5]); //t2 now EF
+    updateBranch ( tree, branches, branch_ids[2], nodes[6], nodes[2]); //AC becomes GC
+    updateBranch ( tree, branches, branch_ids[3], nodes[7], nodes[2]); //BC becomes HC
+    updateBranch ( tree, branches, branch_ids[4], nodes[8], nodes[3]); //ED becomes ID
+    updateBranch ( tree, branches, branch_ids[5], nodes[9], nodes[3]); //FD becomes JD
+    tree.invalidateBranchParsimony(nodes[2], nodes[3]); //CD now separates GH from IJ
 
     parsimony_score = -1;
     for (int i=0; i<7; ++i) {
@@ -335,13 +344,15 @@ double ParsimonyLazyTBRMove::apply
     return parsimony_score;
 }
 /*static*/ intptr_t ProperParsimonyTBRMove::getParsimonyVectorSize(intptr_t radius) {
-    return radius+1;
+    return radius*2+2;
 }
 ProperParsimonyTBRMove::ProperTBRSearch::ProperTBRSearch(const PhyloTree& t, const TargetBranchRange& b, int r,
           std::vector<UINT*>& p, double s, ParsimonyLazyTBRMove& m )
-    : super(t, b, r, p, s, m), front_parsimony(nullptr)
-    , back_parsimony(nullptr) {
-    path.resize(max_radius, nullptr);
+    : super(t, b, r, p, s, m), front_rerooted(nullptr)
+    , back_rerooted(nullptr) {
+    ASSERT(static_cast<intptr_t>(path_parsimony.size()) >= getParsimonyVectorSize(max_radius));
+    first_id    = -1;
+    first_depth = 0;
 }
 UINT* ProperParsimonyTBRMove::ProperTBRSearch::offPathParsimony(PhyloNode* a, PhyloNode* b, PhyloNode* c ) {
     //parsimony, viewed from a, to its non-b, non-c neighbor
@@ -354,70 +365,85 @@ UINT* ProperParsimonyTBRMove::ProperTBRSearch::offPathParsimony(PhyloNode* a, Ph
     ASSERT(false && "could not find third adjacent node");
     return nullptr;
 }
-
-void ProperParsimonyTBRMove::ProperTBRSearch::searchPart1(PhyloNode* from, PhyloNode* prev, int depth) {
-    path[depth] = prev;
-    if (0==depth) {
-        front_parsimony = offPathParsimony(front, from, back);
-    }
-    else {
-        UINT* on_path     = (depth>1) ? path_parsimony[depth-2]: front_parsimony;
-        UINT* off_path    = offPathParsimony ( prev, from, path[depth-1] );
-        tree.computePartialParsimonyOutOfTree(off_path, on_path,
-                                                  path_parsimony[depth-1]);
-        if (1<depth) {
-            PhyloNeighbor* nei = prev->findNeighbor(from);
-            front_score        = tree.computePartialParsimonyOutOfTree
-                                 ( path_parsimony[depth-1],
-                                   nei->get_partial_pars(),
-                                   path_parsimony[max_radius-1]);
-            first_id           = nei->id;
-            first_depth        = depth;
-            FOR_EACH_ADJACENT_PHYLO_NODE(back, front , it, node) {
-                searchPart2(node, back, depth+1);
-            }
-        }
-    }
-    if (depth<max_radius-3) {
-        FOR_EACH_ADJACENT_PHYLO_NODE(from, prev, it, node) {
-            searchPart1(node, from, depth+1);
+UINT* ProperParsimonyTBRMove::ProperTBRSearch::rerootAtSnippedNode
+    ( PhyloNode* a, PhyloNode* b, UINT* output ) {
+    if (a->isLeaf()) {
+        //Nothing to snip out; the subtree is just the leaf.
+        return b->findNeighbor(a)->get_partial_pars();
+    }
+    PhyloNode* x;
+    PhyloNode* y;
+    GET_OTHER_ADJACENT_PHYLO_NODES(a, b, x, y);
+    tree.computePartialParsimonyOutOfTree(a->findNeighbor(x)->get_partial_pars(),
+                                          a->findNeighbor(y)->get_partial_pars(),
+                                          output, PARS_BRANCH_PARALLEL);
+    return output;
+}
+void ProperParsimonyTBRMove::ProperTBRSearch::searchFront
+    ( PhyloNode* node, PhyloNode* prev, const UINT* behind, int depth ) {
+    FOR_EACH_PHYLO_NEIGHBOR(node, prev, it, nei) {
+        PhyloNode* next     = nei->getNode();
+        UINT*      off_path = offPathParsimony(node, next, prev);
+        UINT*      on_path  = path_parsimony[depth-1];
+        tree.computePartialParsimonyOutOfTree(behind, off_path, on_path,
+                                              PARS_BRANCH_PARALLEL);
+        front_rerooted = path_parsimony[max_radius];
+        tree.computePartialParsimonyOutOfTree(on_path, nei->get_partial_pars(),
+                                              front_rerooted, PARS_BRANCH_PARALLEL);
+        first_id    = nei->id;
+        first_depth = depth;
+        searchBackTargets();
+        if (depth<max_radius) {
+            searchFront(next, node, on_path, depth+1);
         }
     }
 }
-void ProperParsimonyTBRMove::ProperTBRSearch::searchPart2(PhyloNode* from, PhyloNode* prev,
-                 int depth) {
-    path[depth] = prev;
-    if ( first_depth + 1 == depth ) {
-        back_parsimony = offPathParsimony(back, from, front);
-    }
-    else {
-        UINT* on_path     = (first_depth+2<depth) ? path_parsimony[depth-2]: back_parsimony;
-        UINT* off_path    = offPathParsimony(prev, from, path[depth-1]);
-        tree.computePartialParsimonyOutOfTree(off_path, on_path,
-                                              path_parsimony[depth-1]);
-        if ( first_depth + 2 < depth ) {
-            PhyloNeighbor* nei = prev->findNeighbor(from);
-            back_score         = tree.computePartialParsimonyOutOfTree
-                                 ( path_parsimony[depth-1],
-                                   nei->get_partial_pars(),
-                                   path_parsimony[max_radius] );
-            int reconnect_cost = 0;
-            tree.computeParsimonyOutOfTree(path_parsimony[max_radius-1],
-                                           path_parsimony[max_radius],
-                                           &reconnect_cost );
-            double gain        = parsimony_score - front_score
-                               - back_score - reconnect_cost;
-            
-            considerMove(first_id, nei->id, gain, depth);
-        }
+void ProperParsimonyTBRMove::ProperTBRSearch::searchBackTargets() {
+    //The back subtree, reconnected where it was (unless the front
+    //subtree is too, in which case there's nothing to consider).
+    back_rerooted = rerootAtSnippedNode(back, front,
+                                        path_parsimony[max_radius*2+1]);
+    if (0<=first_id) {
+        considerConnection(-1, first_depth);
+    }
+    if (back->isLeaf() || max_radius<=first_depth) {
+        return;
     }
-    if ( depth+1 < max_radius ) {
-        FOR_EACH_ADJACENT_PHYLO_NODE(from, prev, it, node) {
-            searchPart2(node, from, depth+1);
+    PhyloNode* left;
+    PhyloNode* right;
+    GET_OTHER_ADJACENT_PHYLO_NODES(back, front, left, right);
+    searchBack(left,  back, back->findNeighbor(right)->get_partial_pars(), first_depth+1);
+    searchBack(right, back, back->findNeighbor(left)->get_partial_pars(),  first_depth+1);
+}
+void ProperParsimonyTBRMove::ProperTBRSearch::searchBack
+    ( PhyloNode* node, PhyloNode* prev, const UINT* behind, int depth ) {
+    FOR_EACH_PHYLO_NEIGHBOR(node, prev, it, nei) {
+        PhyloNode* next     = nei->getNode();
+        UINT*      off_path = offPathParsimony(node, next, prev);
+        UINT*      on_path  = path_parsimony[max_radius + depth - first_depth];
+        tree.computePartialParsimonyOutOfTree(behind, off_path, on_path,
+                                              PARS_BRANCH_PARALLEL);
+        back_rerooted = path_parsimony[max_radius*2+1];
+        tree.computePartialParsimonyOutOfTree(on_path, nei->get_partial_pars(),
+                                              back_rerooted, PARS_BRANCH_PARALLEL);
+        considerConnection(nei->id, depth);
+        if (depth<max_radius) {
+            searchBack(next, node, on_path, depth+1);
         }
     }
 }
-    
+void ProperParsimonyTBRMove::ProperTBRSearch::considerConnection
+    ( intptr_t second_id, int depth ) {
+    //Rerooted vectors record the parsimony score of their
+    //whole subtree, so the score returned here is the score
+    //of the tree, as it would be after the move.
+    int connection_cost = 0;
+    double new_score    = tree.computeParsimonyOutOfTree
+                          ( front_rerooted, back_rerooted,
+                            &connection_cost, PARS_BRANCH_PARALLEL );
+    considerMove(first_id, second_id, parsimony_score - new_score, depth);
+}
+
 void ProperParsimonyTBRMove::findMove(const PhyloTree& tree,
                       const TargetBranchRange& branches,
                       int radius,
@@ -431,19 +457,102 @@ void ProperParsimonyTBRMove::findMove(const PhyloTree& tree,
     auto source_branch    = branches[source_branch_id];
     PhyloNode* front      = source_branch.first;
     PhyloNode* back       = source_branch.second;
-    if (front->isLeaf()) {
-        return;
-    }
-    if (back->isLeaf()) {
-        return;
-    }
     disconnection_benefit = source_branch.getBranchCost();
     depth                 = radius;
     ProperTBRSearch s(tree, branches, radius,
                 path_parsimony, parsimony_score, *this);
-    FOR_EACH_ADJACENT_PHYLO_NODE(front, back, it, node) {
-        s.searchPart1(node, front, 0);
+    //First, with the front subtree reconnected where it was
+    //(these are the SPR moves that move the back of the source branch).
+    s.front_rerooted = s.rerootAtSnippedNode(front, back, path_parsimony[radius]);
+    s.searchBackTargets();
+    if (front->isLeaf() || radius<1) {
+        return;
     }
+    PhyloNode* left;
+    PhyloNode* right;
+    GET_OTHER_ADJACENT_PHYLO_NODES(front, back, left, right);
+    s.searchFront(left,  front, front->findNeighbor(right)->get_partial_pars(), 1);
+    s.searchFront(right, front, front->findNeighbor(left)->get_partial_pars(),  1);
+}
+
+void ProperParsimonyTBRMove::finalize(PhyloTree& tree,
+                                      const TargetBranchRange& branches) {
+    if (lazy) {
+        super::finalize(tree, branches);
+        return;
+    }
+    if (benefit<=0) {
+        return;
+    }
+    TREE_LOG_LINE(tree, VB_DEBUG, "move s=" << source_branch_id
+        << ", t1=" << first_target_branch_id
+        << ", t2=" << second_target_branch_id
+        << ", b=" << benefit);
+    copy_of_source        = branches[source_branch_id];
+    copy_of_first_target  = PhyloBranch(nullptr, nullptr);
+    copy_of_second_target = PhyloBranch(nullptr, nullptr);
+    if (0<=first_target_branch_id) {
+        copy_of_first_target  = branches[first_target_branch_id];
+    }
+    if (0<=second_target_branch_id) {
+        copy_of_second_target = branches[second_target_branch_id];
+    }
+}
+
+bool ProperParsimonyTBRMove::isStillPossible(const TargetBranchRange& branches,
+                                             PhyloBranchVector& path) const {
+    if (lazy) {
+        return super::isStillPossible(branches, path);
+    }
+    path.clear();
+    if (benefit<=0 || branches[source_branch_id] != copy_of_source) {
+        return false;
+    }
+    PhyloNode* front = copy_of_source.first;
+    PhyloNode* back  = copy_of_source.second;
+    PhyloBranchVector path_to_second;
+    if (0<=first_target_branch_id) {
+        if (branches[first_target_branch_id] != copy_of_first_target) {
+            return false;
+        }
+        if (!isAConnectedThroughBToC(back, front, copy_of_first_target.first, path)) {
+            return false;
+        }
+    }
+    if (0<=second_target_branch_id) {
+        if (branches[second_target_branch_id] != copy_of_second_target) {
+            path.clear();
+            return false;
+        }
+        if (!isAConnectedThroughBToC(front, back, copy_of_second_target.first,
+                                     path_to_second)) {
+            path.clear();
+            return false;
+        }
+    }
+    for (auto branch : path_to_second) {
+        path.push_back(branch);
+    }
+    return true;
+}
+
+double ProperParsimonyTBRMove::apply
+    ( PhyloTree& tree, double parsimony_score,
+      TargetBranchRange& branches, LikelihoodBlockPairs blocks,
+      ParsimonyPathVector& parsimony_path_vectors) {
+    if (0<=first_target_branch_id && 0<=second_target_branch_id) {
+        return super::apply(tree, parsimony_score, branches,
+                            blocks, parsimony_path_vectors);
+    }
+    //One subtree stays where it was, so this is an SPR of the
+    //other (ParsimonyLazySPRMove::apply is also its own inverse).
+    ParsimonySPRMove spr;
+    spr.initialize(source_branch_id, lazy);
+    spr.isForward        = (second_target_branch_id < 0);
+    spr.target_branch_id = spr.isForward ? first_target_branch_id
+                                         : second_target_branch_id;
+    return spr.apply(tree, parsimony_score, branches,
+                     blocks, parsimony_path_vectors);
 }
 
 int PhyloTree::doParsimonyTBR() {
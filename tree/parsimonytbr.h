@@ -111,7 +111,7 @@ public:
     void reconnect(PhyloNode* first, PhyloNode* second,
                    PhyloNode* third, PhyloNode* fourth);
     
-    void updateBranch(TargetBranchRange& branches, intptr_t id,
+    void updateBranch(PhyloTree& tree, TargetBranchRange& branches, intptr_t id,
                       PhyloNode* left, PhyloNode* right);
     
     virtual double apply(PhyloTree& tree,
@@ -121,6 +121,18 @@ public:
                          ParsimonyPathVector& parsimony_path_vectors);
 };
 
+/**
+ * A TBR move scored exactly: the source branch is removed, and
+ * the two subtrees it separated are reconnected, by a new branch,
+ * between a branch of one (the "first" target) and a branch of the
+ * other (the "second" target).  The benefit of a move is the
+ * parsimony score of the tree as it is, less the parsimony score
+ * of the tree the move would produce.
+ * @note  a target branch id of -1 means that the subtree on that
+ *        side of the source branch is reconnected where it already
+ *        was (the move is then an SPR of the other subtree, and is
+ *        applied as one).
+ */
 struct ProperParsimonyTBRMove : public ParsimonyLazyTBRMove {
 public:
     typedef ParsimonyLazyTBRMove super;
@@ -128,46 +140,77 @@ public:
     class ProperTBRSearch: public LazyTBRSearch {
     public:
         typedef LazyTBRSearch super;
-        std::vector<PhyloNode*> path;
-        UINT*  front_parsimony;
-        double front_score;
-        UINT*  back_parsimony;
-        double back_score;
+        //path_parsimony has 2*max_radius+2 entries:
+        //[0..max_radius-1]              path vectors, front subtree
+        //[max_radius]                   rerooted vector, front subtree
+        //[max_radius+1..2*max_radius]   path vectors, back subtree
+        //[2*max_radius+1]               rerooted vector, back subtree
+        UINT*  front_rerooted;
+        UINT*  back_rerooted;
         ProperTBRSearch(const PhyloTree& t, const TargetBranchRange& b, int r,
                         std::vector<UINT*>& p, double s, ParsimonyLazyTBRMove& m );
         inline UINT* offPathParsimony(PhyloNode* a, PhyloNode* b, PhyloNode* c ) ;
-        
         /**
-         * @param from    where we are
-         * @param prev    where we were
-         * @param depth  how far we have gone (0 if we are on a branch adjacent
-         *              to the source branch).
-         * @note  path_parsimony[max_radius-1] is the calculated vector
-         *        for the view of the subtree from the first target branch.
-         *        path[0..depth-1] are the nodes visited in the path to "prev".
+         * @param a      one end of the source branch
+         * @param b      the other end of the source branch
+         * @param output where to write the parsimony vector of the
+         *               subtree (containing a, but not b), rerooted at
+         *               the branch that replaces a (when a is snipped out)
+         * @return output (or, if a is a leaf, the parsimony vector of
+         *         the view, from b, of a)
          */
-        void searchPart1(PhyloNode* from, PhyloNode* prev, int depth);
+        UINT* rerootAtSnippedNode(PhyloNode* a, PhyloNode* b, UINT* output);
         /**
-         * @param from    where we are (on the back side of the source branch)
-         * @param prev    where we were
-         * @param depth  how far we have searched on both sides of the
-         *              source branch (==first_depth+1, if we are looking at
-         *              a branch adjacent to the "back" end of the source branch).
-         * @note  path_parsimony[max_radius] is the calculated vector
-         *        for the view of the subtree from the second target branch.
-         *        path[0..first_depth]] are the nodes visited in the path from
-         *        front to the first target branch.
-         *        path[first_depth+1..depth-1] are the nodes visited in the path
-         *        from back to where we are search now.
+         * @param node   where we are (in the front subtree)
+         * @param prev   where we were
+         * @param behind parsimony vector for the view, from node, of the
+         *               front subtree (with the source branch removed),
+         *               looking back toward prev
+         * @param depth  how far we have gone (1 if node is adjacent
+         *               to the front of the source branch).
+         * @note  for each branch linking node to a node further away,
+         *        path_parsimony[depth-1] is set to the view of the front
+         *        subtree, looking back through node, and front_rerooted
+         *        to the vector for the front subtree rerooted at the
+         *        branch, before the back subtree is searched.
+         */
+        void searchFront(PhyloNode* node, PhyloNode* prev,
+                         const UINT* behind, int depth);
+        /**
+         * @param node   where we are (in the back subtree)
+         * @param prev   where we were
+         * @param behind (as for searchFront, but for the back subtree)
+         * @param depth  how far we have gone (first_depth+1 if node is
+         *               adjacent to the back of the source branch).
+         */
+        void searchBack(PhyloNode* node, PhyloNode* prev,
+                        const UINT* behind, int depth);
+        /**
+         * Consider reconnecting the front subtree (rerooted at the
+         * branch with id first_id, as per front_rerooted) to each
+         * of the branches in the back subtree within range.
          */
-        void searchPart2(PhyloNode* from, PhyloNode* prev, int depth) ;
+        void searchBackTargets();
+        void considerConnection(intptr_t second_id, int depth);
     };
     
+    virtual void finalize(PhyloTree& tree,
+                          const TargetBranchRange& branches) ;
+
+    virtual bool isStillPossible(const TargetBranchRange& branches,
+                                 PhyloBranchVector& path) const;
+
     virtual void findMove(const PhyloTree& tree,
                           const TargetBranchRange& branches,
                           int radius,
                           std::vector<UINT*>& path_parsimony,
                           double parsimony_score);
+
+    virtual double apply(PhyloTree& tree,
+                         double parsimony_score,
+                         TargetBranchRange& branches,
+                         LikelihoodBlockPairs blocks,
+                         ParsimonyPathVector& parsimony_path_vectors);
 };
 
 #endif /* parsimonytbr_h */
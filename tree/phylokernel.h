@@ -1462,11 +1462,11 @@ double PhyloTree::computeLikelihoodFromBufferEigenSIMD(LikelihoodBufferSet& buff
  ****************************************************************************/
 
 #ifdef _MSC_VER
-    #define MEM_ALIGN_BEGIN __declspec(align(32))
+    #define MEM_ALIGN_BEGIN __declspec(align(64))
     #define MEM_ALIGN_END
 #else
     #define MEM_ALIGN_BEGIN
-    #define MEM_ALIGN_END __attribute__((aligned(32)))
+    #define MEM_ALIGN_END __attribute__((aligned(64)))
 #endif
 
 inline UINT fast_popcount(Vec4ui &x) {
@@ -1495,6 +1495,60 @@ inline UINT fast_popcount(Vec8ui &x) {
     return horizontal_add(y);
 }
 
+#if INSTRSET >= 9
+inline UINT fast_popcount(Vec16ui &x) {
+#ifdef __AVX512VPOPCNTDQ__
+    return static_cast<UINT>(_mm512_reduce_add_epi64(_mm512_popcnt_epi64(x)));
+#else
+    MEM_ALIGN_BEGIN uint64_t vec[8] MEM_ALIGN_END;
+    x.store_a(vec);
+    uint64_t count = 0;
+    for (int i = 0; i < 8; ++i) {
+        count += _mm_popcnt_u64(vec[i]);
+    }
+    return static_cast<UINT>(count);
+#endif
+}
+
+//vectori512.h only defines horizontal_or for the boolean vector types
+inline bool horizontal_or(Vec16ui const &x) {
+    return _mm512_test_epi32_mask(x, x) != 0;
+}
+#endif
+
+/**
+ The Fitch step, for one state, for the bits of a block of sites:
+ a state is kept if both children have it, or (where w is set, because
+ the children have no state in common) if either of them has it.
+ That's the majority of x, y, and w.
+ */
+template <class VectorClass>
+inline VectorClass fitch_state(const VectorClass &x, const VectorClass &y,
+                               const VectorClass &w) {
+    return (x & y) | (w & (x | y));
+}
+
+/**
+ Accumulates, in w, the bits of sites where both children have a state
+ */
+template <class VectorClass>
+inline VectorClass fitch_or_and(const VectorClass &w, const VectorClass &x,
+                                const VectorClass &y) {
+    return w | (x & y);
+}
+
+#if INSTRSET >= 9
+//With AVX-512, each is a single vpternlogd
+//(0xE8 is the truth table of majority(a,b,c); 0xF8, of a | (b & c)).
+inline Vec16ui fitch_state(const Vec16ui &x, const Vec16ui &y, const Vec16ui &w) {
+    return _mm512_ternarylogic_epi32(x, y, w, 0xE8);
+}
+
+inline Vec16ui fitch_or_and(const Vec16ui &w, const Vec16ui &x, const Vec16ui &y) {
+    return _mm512_ternarylogic_epi32(w, x, y, 0xF8);
+}
+#endif
+
 inline void horizontal_popcount(Vec4ui &x) {
     MEM_ALIGN_BEGIN UINT vec[4] MEM_ALIGN_END;
     x.store_a(vec);
@@ -1520,13 +1574,13 @@ inline void horizontal_popcount(Vec8ui &x) {
 }
 
 template<class VectorClass>
-void PhyloTree::computePartialParsimonyFastSIMD(PhyloNeighbor *dad_branch, PhyloNode *dad) {
+void PhyloTree::computePartialParsimonyFastSIMD(PhyloNeighbor *dad_branch, PhyloNode *dad,
+                                                ParsimonyExecution exec) {
     if (dad_branch->isParsimonyComputed()) {
         return;
     }
     PhyloNode* node     = dad_branch->getNode();
     int        nstates  = aln->getMaxNumStates();
-    int        site     = 0;
     const int  VCSIZE   = VectorClass::size();
     const int  NUM_BITS = VectorClass::size() * UINT_BITS;
 
@@ -1539,277 +1593,71 @@ void PhyloTree::computePartialParsimonyFastSIMD(PhyloNeighbor *dad_branch, Phylo
 //            aln->orderPatternByNumChars();
 //        ASSERT(!aln->ordered_pattern.empty());
         memset(dad_branch->partial_pars, 255, pars_block_size*sizeof(UINT));
-        size_t nsites = (aln->num_parsimony_sites+NUM_BITS-1)/NUM_BITS;
+        size_t nsites = (aln->num_parsimony_bits+NUM_BITS-1)/NUM_BITS;
         dad_branch->partial_pars[nstates*VCSIZE*nsites] = 0;
     } else if (node->isLeaf() && dad) {
         // external node
-        vector<Alignment*> *partitions = NULL;
-        if (aln->isSuperAlignment())
-            partitions = &((SuperAlignment*)aln)->partitions;
-        else {
-            partitions = new vector<Alignment*>;
-            partitions->push_back(aln);
-        }
-//        if (aln->ordered_pattern.empty())
-//            aln->orderPatternByNumChars();
-//        ASSERT(!aln->ordered_pattern.empty());
-        int leafid = node->id;
-        memset(dad_branch->partial_pars, 0, pars_block_size*sizeof(UINT));
-        int ambi_aa[] = {2, 3, 5, 6, 9, 10}; // {4+8, 32+64, 512+1024};
-        UINT *x = dad_branch->partial_pars;
-        intptr_t start_pos = 0;
-
-        for (auto alnit = partitions->begin(); 
-            alnit != partitions->end(); ++alnit) {
-            //JB 22-Dec-2020 end_pos now intptr_t, to prevent overflow
-            intptr_t end_pos = start_pos + (*alnit)->ordered_pattern.size(); 
-            switch ((*alnit)->seq_type) {
-            case SEQ_DNA:
-                for (intptr_t patid = start_pos; patid != end_pos; patid++) {
-                    Alignment::iterator pat = aln->ordered_pattern.begin()+ patid;
-                    int state = pat->at(leafid);
-                    int freq = pat->frequency;
-                    if (state < 4) {
-                        for (int j = 0; j < freq; j++, site++) {
-                            if (site == NUM_BITS) {
-                                x += nstates*VCSIZE;
-                                site = 0;
-                            }
-                            x[state*VCSIZE + site/UINT_BITS] |= (1 << (site % UINT_BITS));
-                        }
-                    } else if (state == (*alnit)->STATE_UNKNOWN) {
-                        for (int j = 0; j < freq; j++, site++) {
-                            if (site == NUM_BITS) {
-                                x += nstates*VCSIZE;
-                                site = 0;
-                            }
-                            UINT bit1 = (1 << (site%UINT_BITS));
-                            UINT *p = x+(site/UINT_BITS);
-                            p[0] |= bit1;
-                            p[VCSIZE] |= bit1;
-                            p[2*VCSIZE] |= bit1;
-                            p[3*VCSIZE] |= bit1;
-                        }
-                    } else {
-                        state -= 3;
-                        for (int j = 0; j < freq; j++, site++) {
-                            if (site == NUM_BITS) {
-                                x += nstates*VCSIZE;
-                                site = 0;
-                            }
-                            UINT *p = x + ((site/UINT_BITS));
-                            
-                            UINT bit1 = (1 << (site%UINT_BITS));
-                            for (int i = 0; i < 4; i++)
-                                if (state & (1<<i))
-                                    p[i*VCSIZE] |= bit1;
-                        }
-                    }
-                }
-                break;
-            case SEQ_PROTEIN:
-                for (intptr_t patid = start_pos; patid != end_pos; patid++) {
-                    Alignment::iterator pat = aln->ordered_pattern.begin()+ patid;
-                    int state = pat->at(leafid);
-                    int freq = pat->frequency;
-                    if (state < 20) {
-                        for (int j = 0; j < freq; j++, site++) {
-                            if (site == NUM_BITS) {
-                                x += nstates*VCSIZE;
-                                site = 0;
-                            }
-                            x[state*VCSIZE + site/UINT_BITS] |= (1 << (site % UINT_BITS));
-                        }
-                    } else if (state == (*alnit)->STATE_UNKNOWN) {
-                        for (int j = 0; j < freq; j++, site++) {
-                            if (site == NUM_BITS) {
-                                x += nstates*VCSIZE;
-                                site = 0;
-                            }
-                            UINT bit1 = (1 << (site%UINT_BITS));
-                            UINT *p = x+(site/UINT_BITS);
-                            for (int i = 0; i < 20; i++)
-                                p[i*VCSIZE] |= bit1;
-                        }
-                    } else {
-                        ASSERT(state < 23);
-                        state = (state-20)*2;
-                        for (int j = 0; j < freq; j++, site++) {
-                            if (site == NUM_BITS) {
-                                x += nstates*VCSIZE;
-                                site = 0;
-                            }
-                            UINT *p = x + ((site/UINT_BITS));
-                            UINT bit1 = (1 << (site%UINT_BITS));
-
-                            p[ambi_aa[state]*VCSIZE] |= bit1;
-                            p[ambi_aa[state+1]*VCSIZE] |= bit1;
-                        }
-                    }
-                }
-            break;
-            default:
-            for (intptr_t patid = start_pos; patid != end_pos; patid++) {
-                Alignment::iterator pat = aln->ordered_pattern.begin()+ patid;
-                int state = pat->at(leafid);
-                int freq = pat->frequency;
-                if (aln->seq_type == SEQ_POMO && state >= nstates 
-                    && state < static_cast<int>( aln->STATE_UNKNOWN)) {
-                    state -= nstates;
-                    ASSERT(state < aln->pomo_sampled_states.size());
-                    int id1 = aln->pomo_sampled_states[state] & 3;
-                    int id2 = (aln->pomo_sampled_states[state] >> 16) & 3;
-                    int value1 = (aln->pomo_sampled_states[state] >> 2) & 16383;
-                    int value2 = aln->pomo_sampled_states[state] >> 18;
-                    double weight1 = ((double)value1)/(value1+value2);
-//                    int N = aln->virtual_pop_size;
-//                    int M = value1 + value2;
-
-                    // 2016-09-30: resolving polymorphic states to fixed states
-
-                    // value1 = value1*N/(value1+value2);
-                    int real_state;
-
-                    if (weight1 < 1.0/4)
-                        real_state = id2;
-                    else if (weight1 > 3.0/4)
-                        real_state = id1;
-                    else
-                        real_state = (*alnit)->STATE_UNKNOWN;
-                    /*
-                    if (value1 == 0) 
-                        real_state = id2;
-                    else if (value1 >= N)
-                        real_state = id1;
-                    else {
-                        int j;
-                        if (id1 == 0) j = id2 - 1;
-                        else j = id1 + id2;
-                        real_state = 4 + j*(N-2) + j + value1 - 1;
-                    }
-                    */
-                    state = real_state;
-                    ASSERT(state < 4 || state == (*alnit)->STATE_UNKNOWN);
-//                    assert(state < nstates);
-                }
-                if (state < (*alnit)->num_states) {
-                    for (int j = 0; j < freq; j++, site++) {
-                        if (site == NUM_BITS) {
-                            x += nstates*VCSIZE;
-                            site = 0;
-                        }
-                        x[state*VCSIZE + site/UINT_BITS] |= (1 << (site % UINT_BITS));
-                    }
-                } else if (state == (*alnit)->STATE_UNKNOWN) {
-                    for (int j = 0; j < freq; j++, site++) {
-                        if (site == NUM_BITS) {
-                            x += nstates*VCSIZE;
-                            site = 0;
-                        }
-                        UINT bit1 = (1 << (site%UINT_BITS));
-                        UINT *p = x+(site/UINT_BITS);
-                        for (int i = 0; i < (*alnit)->num_states; i++)
-                            p[i*VCSIZE] |= bit1;
-                    }
-                } else {
-                    ASSERT(0);
-                }
-            } // FOR loop
-            break; // of switch
-            } // end of switch
-            start_pos = end_pos;
-        } // of end FOR LOOP
-
-        ASSERT(start_pos == aln->ordered_pattern.size());
-//        assert(site == aln->num_parsimony_sites % NUM_BITS);
-        // add dummy states
-        if (site > 0 && site < NUM_BITS) {
-            x += site/UINT_BITS;
-            if (site % UINT_BITS != 0) {
-                *x |= ~((1<<(site%UINT_BITS)) - 1);
-                x++;
-            }
-            int max_sites = ((site+UINT_BITS-1)/UINT_BITS);
-            memset(x, 255, (VCSIZE - max_sites)*sizeof(UINT));
-        }
-        {
-            //Count sites where the taxon, indicated by leafid, is the
-            //taxon that has a "singleton" state (is the only one in the
-            //pattern with this state, when all of the others that have
-            //known states have the one known state).
-            //
-            //(Such sites are parsimony-uninformative but tracking how
-            // many of them there are, per taxon, potentially makes
-            // parsimony branch lengths more accurate).
-            //
-            const size_t NUM_BITS   = VectorClass::size() * UINT_BITS;
-            const size_t nstates    = aln->getMaxNumStates();
-            const size_t nsites     = (aln->num_parsimony_sites+NUM_BITS-1)/NUM_BITS;
-            const size_t VCSIZE     = VectorClass::size();
-            auto  total             = nstates*VCSIZE*nsites;
-            if ( 0 <= leafid && leafid < aln->singleton_parsimony_states.size() ) {
-                UINT onesuch_site_count = aln->singleton_parsimony_states[leafid];
-                dad_branch->partial_pars[total] = onesuch_site_count;
-            }
-        }
-        if (!aln->isSuperAlignment()) {
-            delete partitions;
-        }
+        size_t nsites = (aln->num_parsimony_bits+NUM_BITS-1)/NUM_BITS;
+        memcpy(dad_branch->partial_pars,
+               getLeafPartialParsimony(node->id, VCSIZE, nstates*VCSIZE*nsites),
+               pars_block_size*sizeof(UINT));
     } else {
         // internal node
         ASSERT(node->degree() == 3 || (dad==nullptr && 1<node->degree())  ); // it works only for strictly bifurcating tree
         PhyloNeighbor *left = NULL, *right = NULL; // left & right are two neighbors leading to 2 subtrees
         FOR_EACH_PHYLO_NEIGHBOR(node, dad, it, pit) {
             if (!pit->isParsimonyComputed()) {
-                computePartialParsimonyFastSIMD<VectorClass>(pit, node);
+                computePartialParsimonyFastSIMD<VectorClass>(pit, node, exec);
             }
             if (!left) left = pit; else right = pit;
         }
         
         computePartialParsimonyOutOfTreeSIMD<VectorClass>(left->partial_pars,
                                                           right->partial_pars,
-                                                          dad_branch->partial_pars);
+                                                          dad_branch->partial_pars,
+                                                          exec);
     }
 }
 
 template<class VectorClass>
 double PhyloTree::computePartialParsimonyOutOfTreeSIMD(const UINT* left_partial_pars,
                                                      const UINT* right_partial_pars,
-                                                     UINT* dad_partial_pars) const {
+                                                     UINT* dad_partial_pars,
+                                                     ParsimonyExecution exec) const {
     const int NUM_BITS   = VectorClass::size() * UINT_BITS;
     int       nstates    = aln->getMaxNumStates();
     UINT      score      = 0;
-    size_t    nsites     = (aln->num_parsimony_sites+NUM_BITS-1)/NUM_BITS;
+    size_t    nsites     = (aln->num_parsimony_bits+NUM_BITS-1)/NUM_BITS;
     const int VCSIZE     = VectorClass::size();
     int       entry_size = nstates * VCSIZE;
+    const UINT* weight   = aln->pars_word_weight.data();
     
     switch (nstates) {
     case 4:
         #ifdef _OPENMP
-        #pragma omp parallel for reduction(+: score) if(nsites>num_threads*10)
+        #pragma omp parallel for reduction(+: score) if(exec==PARS_SITE_PARALLEL && nsites>num_threads*10)
         #endif
         for (int site = 0; site<nsites; ++site) {
             size_t  offset = entry_size*site;
             VectorClass* x = (VectorClass*)(left_partial_pars  + offset);
             VectorClass* y = (VectorClass*)(right_partial_pars + offset);
             VectorClass* z = (VectorClass*)(dad_partial_pars   + offset);
-            z[0] = x[0] & y[0];
-            z[1] = x[1] & y[1];
-            z[2] = x[2] & y[2];
-            z[3] = x[3] & y[3];
-            VectorClass w = z[0] | z[1] | z[2] | z[3];
+            VectorClass  w = x[0] & y[0];
+            w = fitch_or_and(w, x[1], y[1]);
+            w = fitch_or_and(w, x[2], y[2]);
+            w = fitch_or_and(w, x[3], y[3]);
             w = ~w;
-            z[0] |= w & (x[0] | y[0]);
-            z[1] |= w & (x[1] | y[1]);
-            z[2] |= w & (x[2] | y[2]);
-            z[3] |= w & (x[3] | y[3]);
-            score += fast_popcount(w);
+            z[0] = fitch_state(x[0], y[0], w);
+            z[1] = fitch_state(x[1], y[1], w);
+            z[2] = fitch_state(x[2], y[2], w);
+            z[3] = fitch_state(x[3], y[3], w);
+            score += weight[site*VCSIZE] * fast_popcount(w);
         }
         break;
             
     default:
         #ifdef _OPENMP
-        #pragma omp parallel for reduction(+: score) if(nsites>num_threads*10)
+        #pragma omp parallel for reduction(+: score) if(exec==PARS_SITE_PARALLEL && nsites>num_threads*10)
         #endif
         for (int site = 0; site<nsites; ++site) {
             size_t offset = entry_size*site;
@@ -1819,14 +1667,13 @@ double PhyloTree::computePartialParsimonyOutOfTreeSIMD(const UINT* left_partial_
             int i;
             VectorClass w = 0;
             for (i = 0; i < nstates; i++) {
-                z[i] = x[i] & y[i];
-                w |= z[i];
+                w = fitch_or_and(w, x[i], y[i]);
             }
             w = ~w;
             for (i = 0; i < nstates; i++) {
-                z[i] |= w & (x[i] | y[i]);
+                z[i] = fitch_state(x[i], y[i], w);
             }
-            score += fast_popcount(w);
+            score += weight[site*VCSIZE] * fast_popcount(w);
         }
         break;
     }
@@ -1841,7 +1688,7 @@ int PhyloTree::getSubTreeParsimonyFastSIMD(PhyloNeighbor* dad_branch) const {
     //records total subtree parsimony
     const size_t NUM_BITS   = VectorClass::size() * UINT_BITS;
     const size_t nstates    = aln->getMaxNumStates();
-    const size_t nsites     = (aln->num_parsimony_sites+NUM_BITS-1)/NUM_BITS;
+    const size_t nsites     = (aln->num_parsimony_bits+NUM_BITS-1)/NUM_BITS;
     const size_t VCSIZE     = VectorClass::size();
     auto total = nstates*VCSIZE*nsites;
     return dad_branch->partial_pars[total];
@@ -1863,21 +1710,24 @@ int PhyloTree::computeParsimonyBranchFastSIMD(PhyloNeighbor *dad_branch, PhyloNo
     }
     return computeParsimonyOutOfTreeSIMD<VectorClass>(dad_branch->partial_pars,
                                                       node_branch->partial_pars,
-                                                      branch_subst);
+                                                      branch_subst, PARS_SITE_PARALLEL);
 }
 
 template<class VectorClass>
 int PhyloTree::computeParsimonyOutOfTreeSIMD(const UINT* dad_partial_pars,
                                              const UINT* node_partial_pars,
-                                             int* branch_subst) const {
+                                             int* branch_subst,
+                                             ParsimonyExecution exec) const {
     int nstates = aln->getMaxNumStates();
 
 //    VectorClass score = 0;
 //    VectorClass w;
 
     const int NUM_BITS = VectorClass::size() * UINT_BITS;
-    int nsites         = (aln->num_parsimony_sites + NUM_BITS - 1)/NUM_BITS;
-    int entry_size     = nstates * VectorClass::size();
+    const int VCSIZE   = VectorClass::size();
+    int nsites         = (aln->num_parsimony_bits + NUM_BITS - 1)/NUM_BITS;
+    int entry_size     = nstates * VCSIZE;
+    const UINT* weight = aln->pars_word_weight.data();
     
     int  scoreid        = nsites*entry_size;
     UINT sum_end_node  = (dad_partial_pars[scoreid] + node_partial_pars[scoreid]);
@@ -1889,14 +1739,18 @@ int PhyloTree::computeParsimonyOutOfTreeSIMD(const UINT* dad_partial_pars,
     switch (nstates) {
     case 4:
         #ifdef _OPENMP
-        #pragma omp parallel for reduction(+: score) if(nsites>num_threads*10)
+        #pragma omp parallel for reduction(+: score) if(exec==PARS_SITE_PARALLEL && nsites>num_threads*10)
         #endif
-        for (int offset = 0; offset < scoreid; offset+=entry_size) {
+        for (int site = 0; site < nsites; ++site) {
+            int offset = site*entry_size;
             VectorClass* x = (VectorClass*)(dad_partial_pars + offset);
             VectorClass* y = (VectorClass*)(node_partial_pars + offset);
-            VectorClass  w = (x[0] & y[0]) | (x[1] & y[1]) | (x[2] & y[2]) | (x[3] & y[3]);
+            VectorClass  w = x[0] & y[0];
+            w = fitch_or_and(w, x[1], y[1]);
+            w = fitch_or_and(w, x[2], y[2]);
+            w = fitch_or_and(w, x[3], y[3]);
             w = ~w;
-            score += fast_popcount(w);
+            score += weight[site*VCSIZE] * fast_popcount(w);
             #ifndef _OPENMP
             if (score >= lower_bound) 
                 break;
@@ -1905,17 +1759,18 @@ int PhyloTree::computeParsimonyOutOfTreeSIMD(const UINT* dad_partial_pars,
         break;
     default:
         #ifdef _OPENMP
-        #pragma omp parallel for reduction(+: score) if(nsites>num_threads*10)
+        #pragma omp parallel for reduction(+: score) if(exec==PARS_SITE_PARALLEL && nsites>num_threads*10)
         #endif
-        for (int offset = 0; offset < scoreid; offset+=entry_size) {
+        for (int site = 0; site < nsites; ++site) {
+            int offset = site*entry_size;
             VectorClass *x = (VectorClass*)(dad_partial_pars + offset);
             VectorClass *y = (VectorClass*)(node_partial_pars + offset);
             VectorClass w  = x[0] & y[0];
             for (int i = 1; i < nstates; i++) {
-                w |= x[i] & y[i];
+                w = fitch_or_and(w, x[i], y[i]);
             }
             w = ~w;
-            score += fast_popcount(w);
+            score += weight[site*VCSIZE] * fast_popcount(w);
             #ifndef _OPENMP
             if (score >= lower_bound) 
                 break;
@@ -1929,13 +1784,54 @@ int PhyloTree::computeParsimonyOutOfTreeSIMD(const UINT* dad_partial_pars,
     return score;
 }
 
+template<class VectorClass>
+void PhyloTree::computePatternParsimonyFastSIMD(UINT *ptn_pars) {
+    const int NUM_BITS = VectorClass::size() * UINT_BITS;
+    const int VCSIZE   = VectorClass::size();
+    int nstates        = aln->getMaxNumStates();
+    size_t nsites      = (aln->num_parsimony_bits + NUM_BITS - 1)/NUM_BITS;
+    int entry_size     = nstates * VCSIZE;
+
+    PhyloNode*     dad         = getRoot();
+    PhyloNeighbor* dad_branch  = dad->firstNeighbor();
+    PhyloNeighbor* node_branch = dad_branch->getNode()->findNeighbor(dad);
+    computeParsimonyBranch(dad_branch, dad);
+
+    vector<pair<const UINT*, const UINT*> > joins;
+    getParsimonyJoins(dad_branch, dad, joins);
+    joins.push_back(make_pair(dad_branch->partial_pars, node_branch->partial_pars));
+
+    memset(ptn_pars, 0, sizeof(UINT)*aln->ordered_pattern.size());
+    MEM_ALIGN_BEGIN UINT steps[VectorClass::size()] MEM_ALIGN_END;
+    for (auto join = joins.begin(); join != joins.end(); ++join) {
+        for (size_t site = 0; site < nsites; ++site) {
+            size_t offset = site*entry_size;
+            VectorClass *x = (VectorClass*)(join->first  + offset);
+            VectorClass *y = (VectorClass*)(join->second + offset);
+            VectorClass w  = x[0] & y[0];
+            for (int i = 1; i < nstates; i++) {
+                w |= x[i] & y[i];
+            }
+            w = ~w;
+            if (!horizontal_or(w)) {
+                continue;
+            }
+            w.store_a(steps);
+            for (int lane = 0; lane < VCSIZE; ++lane) {
+                addPatternParsimonySteps(steps[lane], site*NUM_BITS + lane*UINT_BITS, ptn_pars);
+            }
+        }
+    }
+}
+
 /****************************************************************************
  Sankoff parsimony function
  ****************************************************************************/
 
 template<class VectorClass>
 void PhyloTree::computePartialParsimonySankoffSIMD(PhyloNeighbor *dad_branch,
-                                                   PhyloNode *dad){
+                                                   PhyloNode *dad,
+                                                   ParsimonyExecution exec){
     // don't recompute the parsimony
     if (dad_branch->isParsimonyComputed()) {
         return;
@@ -1953,7 +1849,7 @@ void PhyloTree::computePartialParsimonySankoffSIMD(PhyloNeighbor *dad_branch,
         PhyloNode* child = nei->getNode();
         if (child->name != ROOT_NAME) {
             if (!child->isLeaf()) {
-                computePartialParsimonySankoffSIMD<VectorClass>(nei, node);
+                computePartialParsimonySankoffSIMD<VectorClass>(nei, node, exec);
             }
             if (!left) {
                 left = nei;
@@ -1981,13 +1877,13 @@ void PhyloTree::computePartialParsimonySankoffSIMD(PhyloNeighbor *dad_branch,
         //      (so it can be parallelized).
         //
         #ifdef _OPENMP
-        #pragma omp parallel for reduction(+:score)
+        #pragma omp parallel for reduction(+:score) if(exec==PARS_SITE_PARALLEL)
         #endif
         for (intptr_t ptn = 0; ptn < ptnCount; ptn+=VectorClass::size()) {
             intptr_t ptn_start_index = ptn*nstates; //JB 22-Dec-2020 intptr_t, to prevent overflow
-            VectorClass *partial_pars_ptr = (VectorClass*)&partial_pars[ptn_start_index];
+            UINT* partial_pars_ptr = &partial_pars[ptn_start_index];
             for (int i = 0; i < VectorClass::size(); i++) {
-                UINT*       tip_buffer_ptr         = ((UINT*)partial_pars_ptr) + i;
+                UINT*       tip_buffer_ptr         = partial_pars_ptr + i;
                 size_t      offset                 = aln->ordered_pattern[ptn+i][node->id]*nstates;
                 const UINT* partial_pars_child_ptr = &tip_partial_pars[offset];
                 for (int j = 0; j < nstates; j++, tip_buffer_ptr += VectorClass::size()) {
@@ -1995,9 +1891,9 @@ void PhyloTree::computePartialParsimonySankoffSIMD(PhyloNeighbor *dad_branch,
                     *tip_buffer_ptr += increment;
                 }
             }
-            VectorClass here = partial_pars_ptr[0];
+            VectorClass here = VectorClass().load_a(partial_pars_ptr);
             for (int i = 1; i < nstates; i++) {
-                here = min(partial_pars_ptr[i],here);
+                here = min(VectorClass().load_a(partial_pars_ptr + i*VectorClass::size()), here);
             }
             score += horizontal_add(here);
         }
@@ -2015,11 +1911,11 @@ void PhyloTree::computePartialParsimonySankoffSIMD(PhyloNeighbor *dad_branch,
     if (node->degree() > 3) {
         // multifurcating node
         #ifdef _OPENMP //Can now be parallelized, because tip buffer no longer used.
-        #pragma omp parallel for reduction(+:score)
+        #pragma omp parallel for reduction(+:score) if(exec==PARS_SITE_PARALLEL)
         #endif
         for (intptr_t ptn = 0; ptn < ptnCount; ptn+=VectorClass::size()) {
             intptr_t ptn_start_index = ptn*nstates; //JB 22-Dec-2020 intptr_t, to prevent overflow
-            VectorClass *partial_pars_ptr = (VectorClass*)&partial_pars[ptn_start_index];
+            UINT* partial_pars_ptr = &partial_pars[ptn_start_index];
             FOR_EACH_PHYLO_NEIGHBOR(node, dad, it, nei) if ((*it)->node->name != ROOT_NAME) {
                 PhyloNode* child = nei->getNode();
                 if (child->isLeaf()) {
@@ -2028,7 +1924,7 @@ void PhyloTree::computePartialParsimonySankoffSIMD(PhyloNeighbor *dad_branch,
                     //       doesn't have to use a tip buffer.
                     for (int i = 0; i < VectorClass::size(); i++) {
                         UINT* partial_pars_child_ptr = &tip_partial_pars[aln->ordered_pattern[ptn+i][child->id]*nstates];
-                        UINT* tip_buffer_ptr         = ((UINT*)partial_pars_ptr) + i;
+                        UINT* tip_buffer_ptr         = partial_pars_ptr + i;
                         for (int j = 0; j < nstates; ++j, tip_buffer_ptr += VectorClass::size()) {
                             UINT increment   = partial_pars_child_ptr[j];
                             *tip_buffer_ptr += increment;
@@ -2036,22 +1932,24 @@ void PhyloTree::computePartialParsimonySankoffSIMD(PhyloNeighbor *dad_branch,
                     }
                 } else {
                     // internal node
-                    VectorClass* partial_pars_child_ptr = (VectorClass*) & nei->partial_pars[ptn_start_index];
-                    UINT*        cost_matrix_ptr        = cost_matrix;
+                    const UINT* partial_pars_child_ptr = &nei->partial_pars[ptn_start_index];
+                    UINT*       cost_matrix_ptr        = cost_matrix;
                     for (int i = 0; i < nstates; ++i){
                         // min(j->i) from child_branch
-                        VectorClass min_child_ptn_pars = partial_pars_child_ptr[0] + cost_matrix_ptr[0];
+                        VectorClass min_child_ptn_pars = VectorClass().load_a(partial_pars_child_ptr) + cost_matrix_ptr[0];
                         for (int j = 1; j < nstates; j++) {
-                            min_child_ptn_pars = min(partial_pars_child_ptr[j] + cost_matrix_ptr[j], min_child_ptn_pars);
+                            VectorClass child = VectorClass().load_a(partial_pars_child_ptr + j*VectorClass::size());
+                            min_child_ptn_pars = min(child + cost_matrix_ptr[j], min_child_ptn_pars);
                         }
-                        partial_pars_ptr[i] += min_child_ptn_pars;
-                        cost_matrix_ptr     += nstates;
+                        UINT* sum_ptr    = partial_pars_ptr + i*VectorClass::size();
+                        (VectorClass().load_a(sum_ptr) + min_child_ptn_pars).store_a(sum_ptr);
+                        cost_matrix_ptr += nstates;
                     }
                 }
             }
-            VectorClass here = partial_pars_ptr[0];
-            for (int i = 0; i < nstates; i++){
-                here = min(partial_pars_ptr[i],here);
+            VectorClass here = VectorClass().load_a(partial_pars_ptr);
+            for (int i = 1; i < nstates; i++){
+                here = min(VectorClass().load_a(partial_pars_ptr + i*VectorClass::size()), here);
             }
             score += horizontal_add(here);
         }
@@ -2064,28 +1962,28 @@ void PhyloTree::computePartialParsimonySankoffSIMD(PhyloNeighbor *dad_branch,
         // Note: James B. Rewrote this 18-Sep-2020, so that it
         //       doesn't use a tip buffer (and can be parallelized).
         #ifdef _OPENMP
-        #pragma omp parallel for reduction(+:score)
+        #pragma omp parallel for reduction(+:score) if(exec==PARS_SITE_PARALLEL)
         #endif
         for (intptr_t ptn = 0; ptn < ptnCount; ptn+=VectorClass::size()){
             // ignore const ptn because it does not affect pars score
             //if (aln->at(ptn).isConst()) continue;
             size_t       ptn_start_index  = ptn*nstates;
-            VectorClass* partial_pars_ptr = (VectorClass*)&partial_pars[ptn_start_index];
+            UINT* partial_pars_ptr = &partial_pars[ptn_start_index];
 
             // load data for tip
             for (int i = 0; i < VectorClass::size(); i++) {
                 UINT* left_ptr             = &tip_partial_pars[aln->ordered_pattern[ptn+i][left->node->id]*nstates];
                 UINT* right_ptr            = &tip_partial_pars[aln->ordered_pattern[ptn+i][right->node->id]*nstates];
-                UINT* tip_buffer_ptr       = ((UINT*)partial_pars_ptr) + i;
+                UINT* tip_buffer_ptr       = partial_pars_ptr + i;
                 for (int j = 0; j < nstates; j++) {
                     UINT increment         = (left_ptr[j] + right_ptr[j]);
                     *tip_buffer_ptr       += increment;
                     tip_buffer_ptr        += VectorClass::size();
                 }
             }
-            VectorClass here = partial_pars_ptr[0];
-            for (int i = 0; i < nstates; i++){
-                here = min(partial_pars_ptr[i],here);
+            VectorClass here = VectorClass().load_a(partial_pars_ptr);
+            for (int i = 1; i < nstates; i++){
+                here = min(VectorClass().load_a(partial_pars_ptr + i*VectorClass::size()), here);
             }
             score += horizontal_add(here);
         }
@@ -2098,45 +1996,45 @@ void PhyloTree::computePartialParsimonySankoffSIMD(PhyloNeighbor *dad_branch,
         // Note: this still needs to use a tip buffer, but that's created inside
         //       the loop, so the loop can be parallelized.
         #ifdef _OPENMP
-        #pragma omp parallel for reduction(+:score)
+        #pragma omp parallel for reduction(+:score) if(exec==PARS_SITE_PARALLEL)
         #endif
         for (intptr_t ptn = 0; ptn < ptnCount; ptn+=VectorClass::size()){
             // ignore const ptn because it does not affect pars score
             //if (aln->at(ptn).isConst()) continue;
             size_t      ptn_start_index = ptn*nstates;
 #ifndef _MSC_VER
-            VectorClass tip_buffer[nstates];
+            alignas(64) UINT tip_buffer[nstates*VectorClass::size()];
 #else            
-            VectorClass* tip_buffer = aligned_alloc<VectorClass>(nstates);
+            UINT* tip_buffer = aligned_alloc<UINT>(nstates*VectorClass::size());
 #endif
             
             for (int i = 0; i < VectorClass::size(); i++) {
                 const UINT *left_ptr = &tip_partial_pars[aln->ordered_pattern[ptn+i][left->node->id]*nstates];
-                UINT *tip_buffer_ptr = (UINT*)&tip_buffer[i];
+                UINT *tip_buffer_ptr = tip_buffer + i;
                 for (int j = 0; j < nstates; j++) {
                     *tip_buffer_ptr = left_ptr[j];
                     tip_buffer_ptr += VectorClass::size();
                 }
             }
             
-            const VectorClass* right_ptr        = (VectorClass*)&right->partial_pars[ptn_start_index];
-            VectorClass*       partial_pars_ptr = (VectorClass*)&partial_pars[ptn_start_index];
-            const UINT*        cost_matrix_ptr  = cost_matrix;
+            const UINT* right_ptr        = &right->partial_pars[ptn_start_index];
+            UINT*       partial_pars_ptr = &partial_pars[ptn_start_index];
+            const UINT* cost_matrix_ptr  = cost_matrix;
             VectorClass right_contrib;
+            VectorClass here;
             
             for(int i = 0; i < nstates; i++){
                 // min(j->i) from child_branch
-                right_contrib = right_ptr[0] + cost_matrix_ptr[0];
+                right_contrib = VectorClass().load_a(right_ptr) + cost_matrix_ptr[0];
                 for(int j = 1; j < nstates; j++) {
-                    right_contrib = min(right_ptr[j] + cost_matrix_ptr[j], right_contrib);
+                    VectorClass right = VectorClass().load_a(right_ptr + j*VectorClass::size());
+                    right_contrib = min(right + cost_matrix_ptr[j], right_contrib);
                 }
-                VectorClass increment = tip_buffer[i] + right_contrib;
-                partial_pars_ptr[i]   = increment;
-                cost_matrix_ptr      += nstates;
-            }
-            VectorClass here = partial_pars_ptr[0];
-            for (int i = 0; i < nstates; i++){
-                here = min(partial_pars_ptr[i],here);
+                VectorClass increment = VectorClass().load_a(tip_buffer + i*VectorClass::size())
+                                      + right_contrib;
+                increment.store_a(partial_pars_ptr + i*VectorClass::size());
+                here             = (i==0) ? increment : min(increment, here);
+                cost_matrix_ptr += nstates;
             }
             score += horizontal_add(here);
 #ifdef _MSC_VER
@@ -2148,45 +2046,44 @@ void PhyloTree::computePartialParsimonySankoffSIMD(PhyloNeighbor *dad_branch,
     }
     // inner-inner case
     computePartialParsimonyOutOfTreeSankoffSIMD<VectorClass>
-        ( left->partial_pars, right->partial_pars, partial_pars );
+        ( left->partial_pars, right->partial_pars, partial_pars, exec );
 }
 
 template<class VectorClass>
 double PhyloTree::computePartialParsimonyOutOfTreeSankoffSIMD
         (const UINT* left_partial_pars, const UINT* right_partial_pars,
-         UINT*       dad_partial_pars) const
+         UINT*       dad_partial_pars, ParsimonyExecution exec) const
 {
     UINT     score    = 0;
     intptr_t ptnCount = aln->ordered_pattern.size();
     size_t   ptnStep  = VectorClass::size();
     size_t   nstates  = aln->num_states;
     #ifdef _OPENMP
-    #pragma omp parallel for reduction(+:score)
+    #pragma omp parallel for reduction(+:score) if(exec==PARS_SITE_PARALLEL)
     #endif
     for (intptr_t ptn = 0; ptn < ptnCount; ptn+=ptnStep){
         // ignore const ptn because it does not affect pars score
         //if (aln->at(ptn).isConst()) continue;
         intptr_t     ptn_start_index  = ptn*nstates; //JB 22-Dec-2020 intptr_t, to prevent overflow
-        VectorClass* left_ptr         = (VectorClass*)&left_partial_pars[ptn_start_index];
-        VectorClass* right_ptr        = (VectorClass*)&right_partial_pars[ptn_start_index];
-        VectorClass* partial_pars_ptr = (VectorClass*)&dad_partial_pars[ptn_start_index];
-        UINT *cost_matrix_ptr         = cost_matrix;
-        VectorClass left_contrib, right_contrib;
+        const UINT* left_ptr         = &left_partial_pars[ptn_start_index];
+        const UINT* right_ptr        = &right_partial_pars[ptn_start_index];
+        UINT*       partial_pars_ptr = &dad_partial_pars[ptn_start_index];
+        UINT*       cost_matrix_ptr  = cost_matrix;
+        VectorClass left_contrib, right_contrib, here;
         
         for (int i = 0; i < nstates; i++){
             // min(j->i) from child_branch
-            left_contrib  =  left_ptr[0] + cost_matrix_ptr[0];
-            right_contrib = right_ptr[0] + cost_matrix_ptr[0];
+            left_contrib  = VectorClass().load_a(left_ptr)  + cost_matrix_ptr[0];
+            right_contrib = VectorClass().load_a(right_ptr) + cost_matrix_ptr[0];
             for (int j = 1; j < nstates; j++) {
-                left_contrib  = min( left_ptr[j] + cost_matrix_ptr[j],  left_contrib);
-                right_contrib = min(right_ptr[j] + cost_matrix_ptr[j], right_contrib);
+                size_t offset = j*ptnStep;
+                left_contrib  = min(VectorClass().load_a(left_ptr  + offset) + cost_matrix_ptr[j],  left_contrib);
+                right_contrib = min(VectorClass().load_a(right_ptr + offset) + cost_matrix_ptr[j], right_contrib);
             }
-            partial_pars_ptr[i] = left_contrib + right_contrib;
-            cost_matrix_ptr    += nstates;
-        }
-        VectorClass here = partial_pars_ptr[0];
-        for (int i = 0; i < nstates; i++){
-            here = min(partial_pars_ptr[i],here);
+            VectorClass sum = left_contrib + right_contrib;
+            sum.store_a(partial_pars_ptr + i*ptnStep);
+            here             = (i==0) ? sum : min(sum, here);
+            cost_matrix_ptr += nstates;
         }
         score += horizontal_add(here);
     }
@@ -2238,7 +2135,7 @@ int PhyloTree::computeParsimonyBranchSankoffSIMD(PhyloNeighbor *dad_branch,
     int nstates = aln->num_states;
     
     if (dad->isLeaf()) {
-        VectorClass* tip_buffer = aligned_alloc<VectorClass>(nstates);
+        UINT*        tip_buffer  = aligned_alloc<UINT>(nstates*VectorClass::size());
         VectorClass  tree_pars   = 0;
         VectorClass  branch_pars = 0;
         // external node
@@ -2247,18 +2144,21 @@ int PhyloTree::computeParsimonyBranchSankoffSIMD(PhyloNeighbor *dad_branch,
             for (int  i = 0; i < VectorClass::size(); i++) {
                 auto state = aln->ordered_pattern[ptn+i][dad->id];
                 UINT *node_branch_ptr = &tip_partial_pars[state*nstates];
-                UINT *tip_buffer_ptr = (UINT*)tip_buffer + i;
+                UINT *tip_buffer_ptr = tip_buffer + i;
                 for (int j = 0; j < nstates; j++, tip_buffer_ptr += VectorClass::size()) {
                     *tip_buffer_ptr = node_branch_ptr[j];
                 }
             }
-            VectorClass* dad_branch_ptr = (VectorClass*)&dad_branch->partial_pars[ptn_start_index];
-            VectorClass  min_ptn_pars   = tip_buffer[0] + dad_branch_ptr[0];
-            VectorClass  br_ptn_pars    = tip_buffer[0];
+            const UINT* dad_branch_ptr = &dad_branch->partial_pars[ptn_start_index];
+            VectorClass tip            = VectorClass().load_a(tip_buffer);
+            VectorClass min_ptn_pars   = tip + VectorClass().load_a(dad_branch_ptr);
+            VectorClass br_ptn_pars    = tip;
             for (int i = 1; i < nstates; i++){
                 // min(j->i) from node_branch
-                VectorClass min_score = tip_buffer[i] + dad_branch_ptr[i];
-                br_ptn_pars  = select(min_score < min_ptn_pars, tip_buffer[i], br_ptn_pars);
+                size_t      offset    = i*VectorClass::size();
+                tip                   = VectorClass().load_a(tip_buffer + offset);
+                VectorClass min_score = tip + VectorClass().load_a(dad_branch_ptr + offset);
+                br_ptn_pars  = select(min_score < min_ptn_pars, tip, br_ptn_pars);
                 min_ptn_pars = min(min_ptn_pars, min_score);
             }
             //_pattern_pars[ptn] = min_ptn_pars;
@@ -2273,14 +2173,16 @@ int PhyloTree::computeParsimonyBranchSankoffSIMD(PhyloNeighbor *dad_branch,
     }  else {
         // internal node
         return computeParsimonyOutOfTreeSankoffSIMD<VectorClass>
-               ( dad_branch->partial_pars, node_branch->partial_pars, branch_subst);
+               ( dad_branch->partial_pars, node_branch->partial_pars,
+                 branch_subst, PARS_SITE_PARALLEL);
     }
 }
 
 template<class VectorClass>
 int PhyloTree::computeParsimonyOutOfTreeSankoffSIMD(const UINT* dad_partial_pars,
                                                     const UINT* node_partial_pars,
-                                                    int*        branch_subst) const {
+                                                    int*        branch_subst,
+                                                    ParsimonyExecution exec) const {
     intptr_t ptnCount    = aln->ordered_pattern.size();
     size_t   ptnStep     = VectorClass::size();
     int      nstates     = aln->num_states;
@@ -2288,25 +2190,25 @@ int PhyloTree::computeParsimonyOutOfTreeSankoffSIMD(const UINT* dad_partial_pars
     UINT     branch_pars = 0; //so that the for-loop can be parallelized.
 
     #ifdef _OPENMP
-    #pragma omp parallel for reduction(+:tree_pars,branch_pars)
+    #pragma omp parallel for reduction(+:tree_pars,branch_pars) if(exec==PARS_SITE_PARALLEL)
     #endif
     for (intptr_t ptn = 0; ptn < ptnCount; ptn += ptnStep){
         intptr_t     ptn_start_index = ptn * nstates; //JB 22-Dec-2020 intptr_t, to prevent overflow
-        VectorClass* node_branch_ptr = (VectorClass*)&node_partial_pars[ptn_start_index];
-        VectorClass* dad_branch_ptr  = (VectorClass*)&dad_partial_pars [ptn_start_index];
+        const UINT*  node_branch_ptr = &node_partial_pars[ptn_start_index];
+        const UINT*  dad_branch_ptr  = &dad_partial_pars [ptn_start_index];
         UINT*        cost_matrix_ptr = cost_matrix;
         VectorClass  min_ptn_pars    = UINT_MAX;
         VectorClass  br_ptn_pars     = UINT_MAX;
         for(int i = 0; i < nstates; ++i){
             // min(j->i) from node_branch
-            VectorClass min_score    = node_branch_ptr[0] + cost_matrix_ptr[0];
+            VectorClass min_score    = VectorClass().load_a(node_branch_ptr) + cost_matrix_ptr[0];
             VectorClass branch_score = cost_matrix_ptr[0];
             for(int j = 1; j < nstates; ++j) {
-                VectorClass value = node_branch_ptr[j] + cost_matrix_ptr[j];
+                VectorClass value = VectorClass().load_a(node_branch_ptr + j*ptnStep) + cost_matrix_ptr[j];
                 branch_score      = select(value < min_score, cost_matrix_ptr[j], branch_score);
                 min_score         = min(value, min_score);
             }
-            min_score       += dad_branch_ptr[i];
+            min_score       += VectorClass().load_a(dad_branch_ptr + i*ptnStep);
             br_ptn_pars      = select(min_score < min_ptn_pars, branch_score, br_ptn_pars);
             min_ptn_pars     = min(min_score, min_ptn_pars);
             cost_matrix_ptr += nstates;
@@ -2321,4 +2223,354 @@ int PhyloTree::computeParsimonyOutOfTreeSankoffSIMD(const UINT* dad_partial_pars
     return tree_pars;
 }
 
+/****************************************************************************
+ Sankoff parsimony function, with 16-bit costs
+ ****************************************************************************/
+
+//
+//The 16-bit Sankoff kernels keep a uint16_t (rather than a UINT) per state
+//per pattern, ShortVectorClass::size() patterns at a time, so vectors are
+//half the size, and each instruction handles twice as many patterns.
+//Additions saturate at USHRT_MAX, so each cost kept is min(cost, USHRT_MAX)
+//(taking minima and saturating additions both commute with the cap), and
+//the cost of a pattern is exact unless it is USHRT_MAX. If a kernel sees
+//one, it sets short_sankoff_overflow, and parsimony is recomputed with the
+//32-bit kernels (see PhyloTree::fallBackFromShortSankoffParsimony).
+//
+
+template<class ShortVectorClass>
+inline void addShortSankoffChildCosts(const ShortVectorClass* child_costs,
+                                      const UINT* cost_matrix, int nstates,
+                                      ShortVectorClass* costs) {
+    const UINT* cost_matrix_ptr = cost_matrix;
+    for (int i = 0; i < nstates; ++i, cost_matrix_ptr += nstates) {
+        // min(j->i) from child_branch
+        ShortVectorClass child_contrib = add_saturated
+            ( child_costs[0], ShortVectorClass(static_cast<uint16_t>(cost_matrix_ptr[0])) );
+        for (int j = 1; j < nstates; ++j) {
+            child_contrib = min( add_saturated
+                ( child_costs[j], ShortVectorClass(static_cast<uint16_t>(cost_matrix_ptr[j])) ),
+                child_contrib );
+        }
+        costs[i] = add_saturated(costs[i], child_contrib);
+    }
+}
+
+template<class ShortVectorClass>
+inline ShortVectorClass minimumShortSankoffCost(const ShortVectorClass* costs,
+                                                int nstates, bool& overflow) {
+    ShortVectorClass here = costs[0];
+    for (int i = 1; i < nstates; ++i) {
+        here = min(costs[i], here);
+    }
+    if (horizontal_or(here == ShortVectorClass(USHRT_MAX))) {
+        overflow = true;
+    }
+    return here;
+}
+
+template<class ShortVectorClass, class VectorClass>
+inline UINT weightShortSankoffCosts(const ShortVectorClass& costs,
+                                    const UINT* ptn_freq, intptr_t ptn,
+                                    intptr_t ptnCount) {
+    //ptnCount is a multiple of VectorClass::size() (but perhaps not
+    //of ShortVectorClass::size()), and the frequencies run out there.
+    const intptr_t half = VectorClass::size();
+    VectorClass weighted = VectorClass(extend_low(costs))
+                         * VectorClass().load_a(&ptn_freq[ptn]);
+    if (ptn + half < ptnCount) {
+        weighted += VectorClass(extend_high(costs))
+                  * VectorClass().load_a(&ptn_freq[ptn + half]);
+    }
+    return horizontal_add(weighted);
+}
+
+template<class ShortVectorClass>
+void PhyloTree::addShortSankoffTipCosts(intptr_t ptn, int taxon_id,
+                                        ShortVectorClass* costs) const {
+    const intptr_t ptnCount = aln->ordered_pattern.size();
+    const int      ptnStep  = ShortVectorClass::size();
+    const int      nstates  = aln->num_states;
+#ifndef _MSC_VER
+    alignas(64) uint16_t tip_buffer[nstates*ptnStep];
+#else
+    uint16_t* tip_buffer = aligned_alloc<uint16_t>(nstates*ptnStep);
+#endif
+    for (int i = 0; i < ptnStep; ++i) {
+        //(patterns past the end are unknown, and cost nothing)
+        int state = (ptn + i < ptnCount)
+                  ? aln->ordered_pattern[ptn+i][taxon_id] : aln->STATE_UNKNOWN;
+        const UINT* tip_costs = &tip_partial_pars[state*nstates];
+        for (int j = 0; j < nstates; ++j) {
+            tip_buffer[j*ptnStep + i] = static_cast<uint16_t>
+                ( min(tip_costs[j], static_cast<UINT>(USHRT_MAX)) );
+        }
+    }
+    for (int j = 0; j < nstates; ++j) {
+        costs[j] = add_saturated(costs[j],
+                                 ShortVectorClass().load_a(tip_buffer + j*ptnStep));
+    }
+#ifdef _MSC_VER
+    aligned_free(tip_buffer);
+#endif
+}
+
+template<class ShortVectorClass, class VectorClass>
+void PhyloTree::computePartialParsimonySankoffShortSIMD(PhyloNeighbor *dad_branch,
+                                                        PhyloNode *dad,
+                                                        ParsimonyExecution exec) {
+    // don't recompute the parsimony
+    if (dad_branch->isParsimonyComputed()) {
+        return;
+    }
+    PhyloNode* node = dad_branch->getNode();
+    ASSERT(dad_branch->partial_pars);
+
+    std::vector<PhyloNeighbor*> children;
+    FOR_EACH_PHYLO_NEIGHBOR(node, dad, it, nei) {
+        PhyloNode* child = nei->getNode();
+        if (child->name != ROOT_NAME) {
+            if (!child->isLeaf()) {
+                computePartialParsimonySankoffShortSIMD<ShortVectorClass, VectorClass>
+                    (nei, node, exec);
+            }
+            children.push_back(nei);
+        }
+    }
+    computeTipPartialParsimony();
+    dad_branch->setParsimonyComputed(true);
+
+    const int      nstates     = aln->num_states;
+    const intptr_t ptnStep     = ShortVectorClass::size();
+    const intptr_t ptnCount    = aln->ordered_pattern.size();
+    const size_t   score_index = (ptnCount + ptnStep - 1) / ptnStep * ptnStep * nstates / 2;
+    //A view toward a taxon (as needed during placement) is its tip costs
+    const bool     at_tip      = children.empty() && node->isLeaf()
+                                 && 0 <= node->id && node->id < aln->getNSeq();
+    uint16_t*      partial_pars = reinterpret_cast<uint16_t*>(dad_branch->partial_pars);
+    UINT           score        = 0;
+    bool           overflow     = false;
+
+    #ifdef _OPENMP
+    #pragma omp parallel for reduction(+:score) reduction(||:overflow) if(exec==PARS_SITE_PARALLEL)
+    #endif
+    for (intptr_t ptn = 0; ptn < ptnCount; ptn += ptnStep) {
+        ShortVectorClass* costs = reinterpret_cast<ShortVectorClass*>
+                                  (partial_pars + ptn*nstates);
+        for (int i = 0; i < nstates; ++i) {
+            costs[i] = 0;
+        }
+        if (at_tip) {
+            addShortSankoffTipCosts(ptn, node->id, costs);
+        }
+        for (PhyloNeighbor* nei : children) {
+            PhyloNode* child = nei->getNode();
+            if (child->isLeaf()) {
+                addShortSankoffTipCosts(ptn, child->id, costs);
+            } else {
+                const uint16_t* child_pars = reinterpret_cast<const uint16_t*>(nei->partial_pars);
+                addShortSankoffChildCosts(reinterpret_cast<const ShortVectorClass*>
+                                          (child_pars + ptn*nstates),
+                                          cost_matrix, nstates, costs);
+            }
+        }
+        bool ptn_overflow = false;
+        score    += horizontal_add_x(minimumShortSankoffCost(costs, nstates, ptn_overflow));
+        overflow  = overflow || ptn_overflow;
+    }
+    dad_branch->partial_pars[score_index] = score;
+    if (overflow) {
+        short_sankoff_overflow = true;
+    }
+}
+
+template<class ShortVectorClass, class VectorClass>
+double PhyloTree::computePartialParsimonyOutOfTreeSankoffShortSIMD
+        (const UINT* left_partial_pars, const UINT* right_partial_pars,
+         UINT*       dad_partial_pars, ParsimonyExecution exec) const
+{
+    const int       nstates     = aln->num_states;
+    const intptr_t  ptnStep     = ShortVectorClass::size();
+    const intptr_t  ptnCount    = aln->ordered_pattern.size();
+    const size_t    score_index = (ptnCount + ptnStep - 1) / ptnStep * ptnStep * nstates / 2;
+    const uint16_t* left_pars   = reinterpret_cast<const uint16_t*>(left_partial_pars);
+    const uint16_t* right_pars  = reinterpret_cast<const uint16_t*>(right_partial_pars);
+    uint16_t*       dad_pars    = reinterpret_cast<uint16_t*>(dad_partial_pars);
+    UINT            score       = 0;
+    bool            overflow    = false;
+
+    #ifdef _OPENMP
+    #pragma omp parallel for reduction(+:score) reduction(||:overflow) if(exec==PARS_SITE_PARALLEL)
+    #endif
+    for (intptr_t ptn = 0; ptn < ptnCount; ptn += ptnStep) {
+        intptr_t          ptn_start_index = ptn*nstates;
+        ShortVectorClass* costs = reinterpret_cast<ShortVectorClass*>
+                                  (dad_pars + ptn_start_index);
+        for (int i = 0; i < nstates; ++i) {
+            costs[i] = 0;
+        }
+        addShortSankoffChildCosts(reinterpret_cast<const ShortVectorClass*>
+                                  (left_pars + ptn_start_index),
+                                  cost_matrix, nstates, costs);
+        addShortSankoffChildCosts(reinterpret_cast<const ShortVectorClass*>
+                                  (right_pars + ptn_start_index),
+                                  cost_matrix, nstates, costs);
+        bool ptn_overflow = false;
+        score    += horizontal_add_x(minimumShortSankoffCost(costs, nstates, ptn_overflow));
+        overflow  = overflow || ptn_overflow;
+    }
+    dad_partial_pars[score_index] = score;
+    if (overflow) {
+        short_sankoff_overflow = true;
+    }
+    return score;
+}
+
+template<class ShortVectorClass, class VectorClass>
+int PhyloTree::getSubTreeParsimonySankoffShortSIMD(PhyloNeighbor* dad_branch) const {
+    if (dad_branch->partial_pars==nullptr) {
+        return 0;
+    }
+    intptr_t ptnStep  = ShortVectorClass::size();
+    intptr_t ptnCount = aln->ordered_pattern.size();
+    size_t   nstates  = aln->num_states;
+    return dad_branch->partial_pars[(ptnCount + ptnStep - 1) / ptnStep * ptnStep * nstates / 2];
+}
+
+template<class ShortVectorClass, class VectorClass>
+int PhyloTree::computeParsimonyBranchSankoffShortSIMD(PhyloNeighbor *dad_branch,
+                                                      PhyloNode *dad, int *branch_subst) {
+    if ((tip_partial_lh_computed & 2) == 0) {
+        computeTipPartialParsimony();
+    }
+    PhyloNode*     node        = dad_branch->getNode();
+    PhyloNeighbor* node_branch = node->findNeighbor(dad);
+    ASSERT(node_branch);
+
+    if (!central_partial_pars) {
+        initializeAllPartialPars();
+    }
+
+    // swap node and dad if dad is a leaf
+    if (node->isLeaf()) {
+        std::swap(dad, node);
+        std::swap(dad_branch, node_branch);
+    }
+
+    if (!dad_branch->isParsimonyComputed() && !node->isLeaf()) {
+        computePartialParsimonySankoffShortSIMD<ShortVectorClass, VectorClass>(dad_branch, dad);
+    }
+
+    if (!node_branch->isParsimonyComputed() && !dad->isLeaf()) {
+        computePartialParsimonySankoffShortSIMD<ShortVectorClass, VectorClass>(node_branch, node);
+    }
+
+    if (!dad->isLeaf()) {
+        // internal node
+        return computeParsimonyOutOfTreeSankoffShortSIMD<ShortVectorClass, VectorClass>
+               ( dad_branch->partial_pars, node_branch->partial_pars,
+                 branch_subst, PARS_SITE_PARALLEL);
+    }
+
+    // external node
+    const int       nstates   = aln->num_states;
+    const intptr_t  ptnStep   = ShortVectorClass::size();
+    const intptr_t  ptnCount  = aln->ordered_pattern.size();
+    const uint16_t* dad_pars  = reinterpret_cast<const uint16_t*>(dad_branch->partial_pars);
+    ShortVectorClass* tip_buffer = aligned_alloc<ShortVectorClass>(nstates);
+    UINT            tree_pars   = 0;
+    UINT            branch_pars = 0;
+    bool            overflow    = false;
+    for (intptr_t ptn = 0; ptn < ptnCount; ptn += ptnStep) {
+        for (int i = 0; i < nstates; ++i) {
+            tip_buffer[i] = 0;
+        }
+        addShortSankoffTipCosts(ptn, dad->id, tip_buffer);
+        const ShortVectorClass* dad_branch_ptr = reinterpret_cast<const ShortVectorClass*>
+                                                 (dad_pars + ptn*nstates);
+        ShortVectorClass min_ptn_pars = add_saturated(tip_buffer[0], dad_branch_ptr[0]);
+        ShortVectorClass br_ptn_pars  = tip_buffer[0];
+        for (int i = 1; i < nstates; ++i) {
+            // min(j->i) from node_branch
+            ShortVectorClass min_score = add_saturated(tip_buffer[i], dad_branch_ptr[i]);
+            br_ptn_pars  = select(min_score < min_ptn_pars, tip_buffer[i], br_ptn_pars);
+            min_ptn_pars = min(min_ptn_pars, min_score);
+        }
+        if (horizontal_or(min_ptn_pars == ShortVectorClass(USHRT_MAX))) {
+            overflow = true;
+        }
+        tree_pars   += weightShortSankoffCosts<ShortVectorClass, VectorClass>
+                       (min_ptn_pars, ptn_freq_pars, ptn, ptnCount);
+        branch_pars += weightShortSankoffCosts<ShortVectorClass, VectorClass>
+                       (br_ptn_pars,  ptn_freq_pars, ptn, ptnCount);
+    }
+    aligned_free(tip_buffer);
+    if (overflow) {
+        short_sankoff_overflow = true;
+    }
+    if (branch_subst != nullptr) {
+        *branch_subst = branch_pars;
+    }
+    return tree_pars;
+}
+
+template<class ShortVectorClass, class VectorClass>
+int PhyloTree::computeParsimonyOutOfTreeSankoffShortSIMD(const UINT* dad_partial_pars,
+                                                         const UINT* node_partial_pars,
+                                                         int*        branch_subst,
+                                                         ParsimonyExecution exec) const {
+    const int       nstates   = aln->num_states;
+    const intptr_t  ptnStep   = ShortVectorClass::size();
+    const intptr_t  ptnCount  = aln->ordered_pattern.size();
+    const uint16_t* dad_pars  = reinterpret_cast<const uint16_t*>(dad_partial_pars);
+    const uint16_t* node_pars = reinterpret_cast<const uint16_t*>(node_partial_pars);
+    UINT            tree_pars   = 0;
+    UINT            branch_pars = 0;
+    bool            overflow    = false;
+
+    #ifdef _OPENMP
+    #pragma omp parallel for reduction(+:tree_pars,branch_pars) reduction(||:overflow) if(exec==PARS_SITE_PARALLEL)
+    #endif
+    for (intptr_t ptn = 0; ptn < ptnCount; ptn += ptnStep) {
+        intptr_t                ptn_start_index = ptn * nstates;
+        const ShortVectorClass* node_branch_ptr = reinterpret_cast<const ShortVectorClass*>
+                                                  (node_pars + ptn_start_index);
+        const ShortVectorClass* dad_branch_ptr  = reinterpret_cast<const ShortVectorClass*>
+                                                  (dad_pars + ptn_start_index);
+        const UINT*      cost_matrix_ptr = cost_matrix;
+        ShortVectorClass min_ptn_pars    = USHRT_MAX;
+        ShortVectorClass br_ptn_pars     = USHRT_MAX;
+        for (int i = 0; i < nstates; ++i) {
+            // min(j->i) from node_branch
+            ShortVectorClass cost         = static_cast<uint16_t>(cost_matrix_ptr[0]);
+            ShortVectorClass min_score    = add_saturated(node_branch_ptr[0], cost);
+            ShortVectorClass branch_score = cost;
+            for (int j = 1; j < nstates; ++j) {
+                cost = static_cast<uint16_t>(cost_matrix_ptr[j]);
+                ShortVectorClass value = add_saturated(node_branch_ptr[j], cost);
+                branch_score = select(value < min_score, cost, branch_score);
+                min_score    = min(value, min_score);
+            }
+            min_score        = add_saturated(min_score, dad_branch_ptr[i]);
+            br_ptn_pars      = select(min_score < min_ptn_pars, branch_score, br_ptn_pars);
+            min_ptn_pars     = min(min_score, min_ptn_pars);
+            cost_matrix_ptr += nstates;
+        }
+        if (horizontal_or(min_ptn_pars == ShortVectorClass(USHRT_MAX))) {
+            overflow = true;
+        }
+        tree_pars   += weightShortSankoffCosts<ShortVectorClass, VectorClass>
+                       (min_ptn_pars, ptn_freq_pars, ptn, ptnCount);
+        branch_pars += weightShortSankoffCosts<ShortVectorClass, VectorClass>
+                       (br_ptn_pars,  ptn_freq_pars, ptn, ptnCount);
+    }
+    if (overflow) {
+        short_sankoff_overflow = true;
+    }
+    if (branch_subst != nullptr) {
+        *branch_subst = branch_pars;
+    }
+    return tree_pars;
+}
+
 #endif /* PHYLOKERNEL_H_ */
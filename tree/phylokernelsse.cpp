@@ -30,12 +30,24 @@
 #endif
 
 void PhyloTree::setParsimonyKernelSSE() {
+    if (isUsingSankoffParsimony() && canUseShortSankoffParsimony()) {
+        setShortSankoffParsimony(true);
+        computeParsimonyBranchPointer           = &PhyloTree::computeParsimonyBranchSankoffShortSIMD<Vec8us, Vec4ui>;
+        computeParsimonyOutOfTreePointer        = &PhyloTree::computeParsimonyOutOfTreeSankoffShortSIMD<Vec8us, Vec4ui>;
+        computePartialParsimonyPointer          = &PhyloTree::computePartialParsimonySankoffShortSIMD<Vec8us, Vec4ui>;
+        computePartialParsimonyOutOfTreePointer = &PhyloTree::computePartialParsimonyOutOfTreeSankoffShortSIMD<Vec8us, Vec4ui>;
+        getSubTreeParsimonyPointer              = &PhyloTree::getSubTreeParsimonySankoffShortSIMD<Vec8us, Vec4ui>;
+        computePatternParsimonyPointer          = nullptr;
+        return;
+    }
     if (isUsingSankoffParsimony()) {
+        setShortSankoffParsimony(false);
         computeParsimonyBranchPointer           = &PhyloTree::computeParsimonyBranchSankoffSIMD<Vec4ui>;
         computeParsimonyOutOfTreePointer        = &PhyloTree::computeParsimonyOutOfTreeSankoffSIMD<Vec4ui>;
         computePartialParsimonyPointer          = &PhyloTree::computePartialParsimonySankoffSIMD<Vec4ui>;
         computePartialParsimonyOutOfTreePointer = &PhyloTree::computePartialParsimonyOutOfTreeSankoffSIMD<Vec4ui>;
         getSubTreeParsimonyPointer              = &PhyloTree::getSubTreeParsimonySankoffSIMD<Vec4ui>;
+        computePatternParsimonyPointer          = nullptr;
         return;
     }
     // Fitch kernel
@@ -44,6 +56,7 @@ void PhyloTree::setParsimonyKernelSSE() {
     computePartialParsimonyPointer          = &PhyloTree::computePartialParsimonyFastSIMD<Vec4ui>;
     computePartialParsimonyOutOfTreePointer = &PhyloTree::computePartialParsimonyOutOfTreeSIMD<Vec4ui>;
     getSubTreeParsimonyPointer              = &PhyloTree::getSubTreeParsimonyFastSIMD<Vec4ui>;
+    computePatternParsimonyPointer          = &PhyloTree::computePatternParsimonyFastSIMD<Vec4ui>;
 }
 
 void PhyloTree::setDotProductSSE() {
@@ -185,6 +185,7 @@ class PhyloNeighbor : public Neighbor {
     friend class PhyloSuperTree;
     friend class PhyloTreeMixlen;
     friend class MemSlotVector;
+    friend class ParsimonySlotVector;
     friend class ParsTree;
     friend class BlockAllocator;
     friend class TaxonToPlace;
@@ -65,6 +65,7 @@ void PhyloTree::init() {
     aln = NULL;
     model = NULL;
     site_rate = NULL;
+    computePatternParsimonyPointer  = nullptr;
     optimize_by_newton              = true;
     central_partial_lh              = nullptr;
     lh_block_size                   = 0; //will be set, later, by determineBlockSizes()
@@ -82,8 +83,12 @@ void PhyloTree::init() {
     pars_block_size                 = 0;       //will be set, later, by determineBlockSizes()
     tip_partial_pars                = nullptr; //points to the last part of central_partial_pars
                                                //(and is set when central_partial_pars is).
+    leaf_partial_pars               = nullptr; //built on demand, by getLeafPartialParsimony()
+    leaf_partial_pars_vector_size   = 0;
     
     cost_matrix = NULL;
+    short_sankoff_kernel   = false;
+    short_sankoff_overflow = false;
     model_factory = NULL;
     discard_saturated_site = true;
     _pattern_lh_cat_state = NULL;
@@ -207,6 +212,7 @@ PhyloTree::~PhyloTree() {
     aligned_free(central_partial_lh);
     aligned_free(central_scale_num);
     aligned_free(central_partial_pars);
+    aligned_free(leaf_partial_pars);
     aligned_free(cost_matrix);
 
     delete model_factory;
@@ -352,6 +358,7 @@ void PhyloTree::copyPhyloTreeMixlen(PhyloTree *tree, int mix, bool borrowSummary
 #define FAST_NAME_CHECK 1
 void PhyloTree::setAlignment(Alignment *alignment) {
     aln = alignment;
+    deleteLeafPartialParsimony();
     //double checkStart = getRealTime();
     int nseq = aln->getNSeq32();
     bool err = false;
@@ -526,7 +533,8 @@ void PhyloTree::prepareForPlacement() {
     }
     if (aln!=nullptr) {
         if ( aln->ordered_pattern.empty() ) {
-            aln->orderPatternByNumChars(PAT_VARIANT);
+            aln->orderPatternByNumChars(using_sankoff
+                                        ? PAT_VARIANT : PAT_INFORMATIVE);
         }
     }
     configureLikelihoodKernel(*params, true);
@@ -1070,11 +1078,10 @@ void PhyloTree::setRootNode(const char *my_root, bool multi_taxa) {
 }
 
 void PhyloTree::readTreeString(const string &tree_string) {
-    stringstream str(tree_string);
     freeNode();
     
     // bug fix 2016-04-14: in case taxon name happens to be ID
-    MTree::readTree(str, rooted);
+    MTree::readTreeBuffer(tree_string.c_str(), tree_string.length(), rooted);
 
     assignLeafNames();
     setRootNode(Params::getInstance().root);
@@ -1093,6 +1100,24 @@ void PhyloTree::readTreeString(const string &tree_string) {
     current_it = current_it_back = NULL;
 }
 
+void PhyloTree::readCandidateTree(const CandidateTree &candidate) {
+    if (isSuperTree() || isMixlen() || Params::getInstance().pll ||
+        candidate.topology.leafNum != static_cast<int>(aln->getNSeq()) + rooted) {
+        readTreeString(candidate.tree);
+        return;
+    }
+    freeNode();
+    candidate.topology.decode(this, aln, rooted);
+    initializeTree();
+    setRootNode(Params::getInstance().root);
+    resetCurScore();
+    if (Params::getInstance().fixStableSplits ||
+        Params::getInstance().adaptPertubation) {
+        buildNodeSplit();
+    }
+    current_it = current_it_back = NULL;
+}
+
 void PhyloTree::readTreeStringSeqName(const string &tree_string) {
     stringstream str(tree_string);
     freeNode();
@@ -1272,6 +1297,7 @@ void PhyloTree::clearAllPartialLH(bool set_to_null) {
 }
 
 void PhyloTree::clearAllPartialParsimony(bool set_to_null) {
+    dirty_parsimony_views.clear();
     if (!root) {
         return;
     }
@@ -1421,14 +1447,22 @@ int PhyloTree::initializeAllPartialPars() {
 }
 
 void PhyloTree::ensureCentralPartialParsimonyIsAllocated(size_t extra_vector_count) {
+    if (isUsingParsimonySlots()) {
+        //Whoever wants vectors for every view, gets them
+        deleteAllPartialParsimony();
+    }
     if (central_partial_pars != nullptr) {
         return;
     }
     determineBlockSizes();
-    uint64_t tip_partial_pars_size = get_safe_upper_limit_float(aln->num_states * (aln->STATE_UNKNOWN+1));
-    uint64_t vector_count          = aln->getNSeq() * 4 - 2 + extra_vector_count;
+    uint64_t vector_count = aln->getNSeq() * 4 - 2 + extra_vector_count;
     //2N-3 branches in an unrooted tree, 2N-1 in a rooted tree, and each branch needs
     //two vectors, so allocate 4N-2, just in case the tree is rooted.
+    allocateCentralPartialParsimony(vector_count);
+}
+
+void PhyloTree::allocateCentralPartialParsimony(uint64_t vector_count) {
+    uint64_t tip_partial_pars_size = get_safe_upper_limit_float(aln->num_states * (aln->STATE_UNKNOWN+1));
     total_parsimony_mem_size       = vector_count * pars_block_size + tip_partial_pars_size;
 
     LOG_LINE(VB_DEBUG, "Allocating " << total_parsimony_mem_size * sizeof(UINT)
@@ -1455,6 +1489,50 @@ void PhyloTree::ensureCentralPartialParsimonyIsAllocated(size_t extra_vector_cou
     return;
 }
 
+void PhyloTree::initializeParsimonySlots() {
+    if (central_partial_pars != nullptr) {
+        deleteAllPartialParsimony();
+    } else {
+        clearAllPartialParsimony(true);
+    }
+    if (!ptn_freq_pars) {
+        ptn_freq_pars = aligned_alloc<UINT>(get_safe_upper_limit_float(getAlnNPattern()));
+    }
+    determineBlockSizes();
+    int64_t full_count = aln->getNSeq() * 4 - 2;
+    //Computing a view (see lockParsimonyView) holds on to at most
+    //one vector per level of (a balanced version of) the tree, and
+    //three more at the top. Plus one for the other end of a branch.
+    int64_t min_count  = 5;
+    for (int64_t n = aln->getNSeq(); 1 < n; n = (n+1) / 2) {
+        ++min_count;
+    }
+    int64_t slot_count;
+    if (params->parsimony_max_mem_is_in_bytes) {
+        uint64_t tip_size = get_safe_upper_limit_float(aln->num_states * (aln->STATE_UNKNOWN+1));
+        double   budget   = params->parsimony_max_mem_size / sizeof(UINT) - (double)tip_size;
+        slot_count        = (budget <= 0) ? 0 : static_cast<int64_t>(floor(budget / pars_block_size));
+    } else {
+        slot_count = static_cast<int64_t>(floor(params->parsimony_max_mem_size * full_count));
+    }
+    if (slot_count < min_count) {
+        LOG_LINE(VB_MIN, "Parsimony memory budget allows for only " << slot_count
+                 << " partial parsimony vectors; using " << min_count << " instead");
+        slot_count = min_count;
+    }
+    if (full_count < slot_count) {
+        slot_count = full_count;
+    }
+    LOG_LINE(VB_MED, "Using " << slot_count << " (of " << full_count << ")"
+             << " partial parsimony vectors");
+    allocateCentralPartialParsimony(slot_count);
+    pars_slots.init(this, static_cast<int>(slot_count));
+}
+
+bool PhyloTree::isUsingParsimonySlots() const {
+    return !pars_slots.empty();
+}
+
 void PhyloTree::initializeAllPartialPars(int &index, PhyloNode *node, PhyloNode *dad) {
     if (!node) {
         ensureCentralPartialParsimonyIsAllocated(0);
@@ -1483,8 +1561,14 @@ UINT *PhyloTree::newBitsBlock() {
     return aligned_alloc<UINT>(pars_block_size);
 }
 
-void PhyloTree::computePartialParsimony(PhyloNeighbor *dad_branch, PhyloNode *dad) {
-    (this->*computePartialParsimonyPointer)(dad_branch, dad);
+void PhyloTree::computePartialParsimony(PhyloNeighbor *dad_branch, PhyloNode *dad,
+                                        ParsimonyExecution exec) {
+    if (isUsingParsimonySlots()) {
+        lockParsimonyView(dad_branch, dad);
+        unlockParsimonyView(dad_branch);
+        return;
+    }
+    (this->*computePartialParsimonyPointer)(dad_branch, dad, exec);
 }
 
 int PhyloTree::getSubTreeParsimony(PhyloNeighbor* dad_branch) const {
@@ -1503,9 +1587,10 @@ int PhyloTree::computeMarginalParsimony(PhyloNeighbor* dad_branch, PhyloNode* da
 
 double PhyloTree::computePartialParsimonyOutOfTree(const UINT* left_partial_pars,
                                       const UINT* right_partial_pars,
-                                                 UINT* dad_partial_pars) const {
+                                                 UINT* dad_partial_pars,
+                                                 ParsimonyExecution exec) const {
     return (this->*computePartialParsimonyOutOfTreePointer)
-        ( left_partial_pars, right_partial_pars, dad_partial_pars );
+        ( left_partial_pars, right_partial_pars, dad_partial_pars, exec );
 }
 
 void PhyloTree::computePartialInfoDouble(TraversalInfo &info, double* buffer) {
@@ -1523,34 +1608,127 @@ void PhyloTree::computeReversePartialParsimony(PhyloNode *node, PhyloNode *dad)
 
 int PhyloTree::computeParsimonyBranch(PhyloNeighbor* dad_branch,
                                       PhyloNode* dad, int* branch_subst) {
-    return (this->*computeParsimonyBranchPointer)(dad_branch, dad, branch_subst);
+    int score;
+    if (isUsingParsimonySlots()) {
+        //Both views are locked, so the kernel finds them computed
+        PhyloNode*     node        = dad_branch->getNode();
+        PhyloNeighbor* node_branch = node->findNeighbor(dad);
+        lockParsimonyView(dad_branch,  dad);
+        lockParsimonyView(node_branch, node);
+        score = (this->*computeParsimonyBranchPointer)(dad_branch, dad, branch_subst);
+        unlockParsimonyView(node_branch);
+        unlockParsimonyView(dad_branch);
+    } else {
+        score = (this->*computeParsimonyBranchPointer)(dad_branch, dad, branch_subst);
+    }
+    if (fallBackFromShortSankoffParsimony()) {
+        return computeParsimonyBranch(dad_branch, dad, branch_subst);
+    }
+    return score;
+}
+
+void PhyloTree::computePatternParsimony(UINT *ptn_pars) {
+    if (!computePatternParsimonyPointer) {
+        outError("Pattern parsimony scores are only available with Fitch parsimony");
+    }
+    (this->*computePatternParsimonyPointer)(ptn_pars);
 }
 
 int PhyloTree::computeParsimonyOutOfTree(const UINT* dad_partial_pars,
                                          const UINT* node_partial_pars,
-                                         int* branch_subst) const {
+                                         int* branch_subst,
+                                         ParsimonyExecution exec) const {
     return (this->*computeParsimonyOutOfTreePointer)
-           (dad_partial_pars, node_partial_pars, branch_subst);
+           (dad_partial_pars, node_partial_pars, branch_subst, exec);
 }
 
 int PhyloTree::computeParsimony(const char* taskDescription,
                                 bool bidirectional, bool countProgress,
                                 PhyloNeighbor* neighbor,
                                 PhyloNode* starting_node) {
+    if (isUsingParsimonySlots() && bidirectional) {
+        //Bidirectional scoring leaves every view computed,
+        //so every view needs a vector of its own.
+        deleteAllPartialParsimony();
+    }
     if (central_partial_pars == nullptr) {
-        initializeAllPartialPars();
+        if (params != nullptr && 0 < params->parsimony_max_mem_size && !bidirectional) {
+            initializeParsimonySlots();
+        } else {
+            initializeAllPartialPars();
+        }
     }
     PhyloNode*     r   = (starting_node!=nullptr) ? starting_node : getRoot();
     PhyloNeighbor* nei = (neighbor!=nullptr)      ? neighbor : r->firstNeighbor();
+    if (isUsingParsimonySlots()) {
+        //Views may have been relinked (or deleted) since they were
+        //last given slots, so start afresh (rather than trusting them).
+        clearAllPartialParsimony(true);
+        pars_slots.reset();
+        return computeParsimonyBranch(nei, r);
+    }
     if (taskDescription==nullptr || taskDescription[0]=='\0') {
         return computeParsimonyBranch(r->firstNeighbor(), r);
     }
     ParallelParsimonyCalculator calculator(*this, countProgress);
-    if (bidirectional) {
-        return calculator.computeAllParsimony(nei, r);
+    int score = bidirectional
+              ? calculator.computeAllParsimony(nei, r)
+              : calculator.computeParsimonyBranch( nei, r, taskDescription );
+    if (fallBackFromShortSankoffParsimony()) {
+        return computeParsimony(taskDescription, bidirectional, countProgress,
+                                neighbor, starting_node);
+    }
+    return score;
+}
+
+void PhyloTree::invalidateBranchParsimony(PhyloNode* first, PhyloNode* second) {
+    //Both views are recorded, even if they were already out of date,
+    //since the PhyloNeighbor instances may have been relinked since
+    //they were marked (and recorded, under their old node pairs).
+    first->findNeighbor(second)->setParsimonyComputed(false);
+    second->findNeighbor(first)->setParsimonyComputed(false);
+    dirty_parsimony_views.emplace_back(first, second);
+    dirty_parsimony_views.emplace_back(second, first);
+}
+
+void PhyloTree::invalidateReverseParsimony(PhyloNode* first, PhyloNode* second) {
+    PhyloBranchVector stack;
+    stack.emplace_back(first, second);
+    stack.emplace_back(second, first);
+    while (!stack.empty()) {
+        PhyloBranch branch = stack.back();
+        stack.pop_back();
+        FOR_EACH_ADJACENT_PHYLO_NODE(branch.first, branch.second, it, node) {
+            PhyloNeighbor* reverseNei = node->findNeighbor(branch.first);
+            if (reverseNei->isParsimonyComputed()) {
+                reverseNei->setParsimonyComputed(false);
+                dirty_parsimony_views.emplace_back(node, branch.first);
+            }
+            stack.emplace_back(node, branch.first);
+        }
     }
-    return calculator.computeParsimonyBranch
-           ( nei, r, taskDescription );
+}
+
+int PhyloTree::computeDirtyParsimony(PhyloNeighbor* neighbor,
+                                     PhyloNode* starting_node) {
+    PhyloNode*     r   = (starting_node!=nullptr) ? starting_node : getRoot();
+    PhyloNeighbor* nei = (neighbor!=nullptr)      ? neighbor : r->firstNeighbor();
+    ParallelParsimonyCalculator calculator(*this, false);
+    //Each view is calculated (along with any out of date views it depends
+    //on) separately, so that no view is ever scheduled twice in one batch.
+    //Views that were computed as a side effect of an earlier view
+    //(or are no longer views at all, because the nodes are no longer
+    //adjacent) are skipped.
+    for (const PhyloBranch& view : dirty_parsimony_views) {
+        if (!view.first->hasNeighbor(view.second)) {
+            continue;
+        }
+        if (calculator.schedulePartialParsimony(view)) {
+            calculator.calculate();
+        }
+    }
+    dirty_parsimony_views.clear();
+    return calculator.computeParsimonyBranch(nei, r);
 }
 
 /****************************************************************************
@@ -1645,8 +1823,10 @@ void PhyloTree::initializeAllPartialLh() {
 }
 
 void PhyloTree::deleteAllPartialParsimony() {
+    pars_slots.clear();
     aligned_free(central_partial_pars);
     tip_partial_pars        = nullptr;
+    deleteLeafPartialParsimony();
     clearAllPartialParsimony(true);
     tip_partial_lh_computed &= ~2;
 }
@@ -1822,7 +2002,14 @@ void PhyloTree::determineBlockSizes() {
 
     // reserve the last entry for parsimony score
     // no longer: pars_block_size = (aln->num_states * aln->size() + UINT_BITS - 1) / UINT_BITS + 1;
-    if (isUsingSankoffParsimony()) {
+    if (isUsingShortSankoffParsimony()) {
+        //16-bit Sankoff kernels track a uint16_t for each state for each
+        //site, in blocks of (up to) 32 sites (and an additional UINT for
+        //a total score)
+        intptr_t ptnCount = (aln->ordered_pattern.size() + 31) / 32 * 32;
+        size_t nstates  = aln->num_states;
+        pars_block_size = ptnCount * nstates / 2 + 1;
+    } else if (isUsingSankoffParsimony()) {
         //Sankoff parsimony tracks a number (a UINT) for each state for each site
         //(and should have 1 additional UINT for a total score)
         intptr_t ptnCount = aln->ordered_pattern.size();
@@ -1831,7 +2018,7 @@ void PhyloTree::determineBlockSizes() {
     } else {
         //Otherwise, parsimony tracks a bit per site per state
         //(and should have 1 additional UINTs for a total score)
-        size_t bits_per_state  = max(aln->size(), (size_t)aln->num_variant_sites);
+        size_t bits_per_state  = aln->getMaxNumParsimonyBits();
         size_t uints_per_state = (bits_per_state + SIMD_BITS - 1) / UINT_BITS;
         pars_block_size = aln->getMaxNumStates() * uints_per_state + 1;
     }
@@ -3977,28 +4164,185 @@ double PhyloTree::correctDist(double *dist_mat) {
     return longest_dist;
 }
 
+namespace {
+    //Distance matrices are calculated a tile (a block of rows by a
+    //block of columns, of the upper triangle) at a time, so that the
+    //sequences for the rows and the columns of a tile stay in cache
+    //while the tile is being calculated.
+    const size_t DISTANCE_TILE_CACHE_BYTES = 256 * 1024;
+
+    intptr_t getDistanceTileWidth(size_t bytes_per_sequence) {
+        size_t width = DISTANCE_TILE_CACHE_BYTES
+                     / (2 * std::max(bytes_per_sequence, static_cast<size_t>(1)));
+        return static_cast<intptr_t>(std::min(std::max(width, static_cast<size_t>(16)),
+                                              static_cast<size_t>(1024)));
+    }
+
+    /**
+     Calculate the upper triangle of an nseqs by nseqs distance matrix,
+     tile by tile (tiles are handed out to threads dynamically), copying
+     each distance into the lower triangle as it is calculated, and
+     writing zeroes to the diagonal.
+     @param distance functor; distance(seq1, seq2, d) returns the distance
+            between seq1 and seq2, given d, the distance the upper triangle
+            of the matrix already has for them
+     @param nseqs the number of sequences
+     @param tile_width the number of rows (and columns) in each tile
+     @param dist_mat the distance matrix (nseqs rows of nseqs columns)
+     @param progress where progress (in pairs of sequences) is to be reported
+     @return the longest distance
+     */
+    template <class D> double computeDistanceTiles
+        ( D& distance, intptr_t nseqs, intptr_t tile_width
+        , double* dist_mat, progress_display_ptr progress ) {
+        intptr_t tiles_per_side = (nseqs + tile_width - 1) / tile_width;
+        std::vector< std::pair<intptr_t, intptr_t> > tiles;
+        tiles.reserve(tiles_per_side * (tiles_per_side + 1) / 2);
+        for (intptr_t row_tile = 0; row_tile < tiles_per_side; ++row_tile) {
+            for (intptr_t col_tile = row_tile; col_tile < tiles_per_side; ++col_tile) {
+                tiles.emplace_back(row_tile * tile_width, col_tile * tile_width);
+            }
+        }
+        intptr_t tile_count = static_cast<intptr_t>(tiles.size());
+        DoubleVector tile_longest(tile_count, 0.0);
+        #ifdef _OPENMP
+        #pragma omp parallel for schedule(dynamic)
+        #endif
+        for (intptr_t t = 0; t < tile_count; ++t) {
+            intptr_t row_start = tiles[t].first;
+            intptr_t row_stop  = std::min(row_start + tile_width, nseqs);
+            intptr_t col_start = tiles[t].second;
+            intptr_t col_stop  = std::min(col_start + tile_width, nseqs);
+            double   longest   = 0.0;
+            double   pairs     = 0.0;
+            for (intptr_t seq1 = row_start; seq1 < row_stop; ++seq1) {
+                double*  dist_row = dist_mat + seq1 * nseqs;
+                double*  dist_col = dist_mat + seq1;
+                intptr_t seq2     = std::max(col_start, seq1 + 1);
+                if (row_start == col_start) {
+                    dist_row[seq1] = 0.0;
+                }
+                for (; seq2 < col_stop; ++seq2) {
+                    double d = distance(seq1, seq2, dist_row[seq2]);
+                    dist_row[seq2]         = d;
+                    dist_col[seq2 * nseqs] = d;
+                    if (longest < d) {
+                        longest = d;
+                    }
+                    ++pairs;
+                }
+            }
+            tile_longest[t] = longest;
+            if (progress!=nullptr) {
+                (*progress) += pairs;
+            }
+        }
+        double longest_dist = 0.0;
+        for (intptr_t t = 0; t < tile_count; ++t) {
+            if (longest_dist < tile_longest[t]) {
+                longest_dist = tile_longest[t];
+            }
+        }
+        return longest_dist;
+    }
+
+    /** frequency-weighted Hamming distances, between the rows of a
+        sequence matrix (see computeDistanceMatrix, below) */
+    template <class L, class F> class HammingDistanceFunctor {
+    protected:
+        L                         unknown;
+        const L*                  sequenceMatrix;
+        size_t                    seqLen;
+        double                    denominator;
+        const F*                  frequencyVector;
+        bool                      uncorrected;
+        double                    z;
+        bool                      count_unknown_as_different;
+        const BitSlicedSequences* slices;
+    public:
+        HammingDistanceFunctor(L unknown_state, const L* sequences, size_t length,
+                               double denom, const F* frequencies,
+                               bool uncorrected_dist, double num_states,
+                               const BitSlicedSequences* bit_slices)
+            : unknown(unknown_state), sequenceMatrix(sequences), seqLen(length)
+            , denominator(denom), frequencyVector(frequencies)
+            , uncorrected(uncorrected_dist), z(num_states / (num_states - 1.0))
+            , count_unknown_as_different(Params::getInstance().count_unknown_as_different)
+            , slices(bit_slices) {
+        }
+        double operator() (intptr_t seq1, intptr_t seq2, double distance) const {
+            if ( 0.0 != distance ) {
+                return distance;
+            }
+            double unknownFreq = 0;
+            double hamming = (slices!=nullptr)
+                ? slices->hammingDistance ( seq1, seq2, unknownFreq )
+                : hammingDistance ( unknown, sequenceMatrix + seq1 * seqLen
+                                  , sequenceMatrix + seq2 * seqLen
+                                  , seqLen, frequencyVector, unknownFreq );
+            if (count_unknown_as_different) {
+                //Unknown counts as 75% different.
+                distance = ( hamming + unknownFreq * 0.75 ) / denominator;
+                if (0<distance && !uncorrected) {
+                    double x      = (1.0 - z * distance);
+                    distance      = (x<=0) ? MAX_GENETIC_DIST : ( -log(x) / z );
+                }
+            } else if (0<hamming && unknownFreq < denominator) {
+                distance = hamming / (denominator - unknownFreq);
+                if (!uncorrected) {
+                    double x      = (1.0 - z * distance);
+                    distance      = (x<=0) ? MAX_GENETIC_DIST : ( -log(x) / z );
+                }
+            }
+            return distance;
+        }
+    };
+
+    /** distances between sequences, as calculated by the
+        AlignmentPairwise processors (one per thread) of a PhyloTree */
+    class PairwiseDistanceFunctor {
+    protected:
+        std::vector<AlignmentPairwise*>& processors;
+    public:
+        explicit PairwiseDistanceFunctor(std::vector<AlignmentPairwise*>& distance_processors)
+            : processors(distance_processors) {
+        }
+        double operator() (intptr_t seq1, intptr_t seq2, double distance) const {
+            #ifdef _OPENMP
+                int threadNum = omp_get_thread_num();
+            #else
+                int threadNum = 0;
+            #endif
+            double d2l = 0;
+            return processors[threadNum]->recomputeDist(static_cast<int>(seq1),
+                                                        static_cast<int>(seq2),
+                                                        distance, d2l);
+        }
+    };
+}
+
 template <class L, class F> double computeDistanceMatrix
     ( LEAST_SQUARE_VAR vartype
     , L unknown, const L* sequenceMatrix, intptr_t nseqs, size_t seqLen
     , double denominator, const F* frequencyVector
     , bool uncorrected, double num_states
-    , double *dist_mat)
+    , double *dist_mat, const BitSlicedSequences* slices = nullptr)
 {
     //
     //L is the character type
     //sequenceMatrix is nseqs rows of seqLen characters
     //dist_mat is as in computeDist
     //F is the frequency count type
+    //slices, if supplied, is sequenceMatrix (and frequencyVector)
+    //       in bit-sliced form (Hamming distances are then calculated
+    //       with popcounts rather than character by character).
     //
-    
-    DoubleVector rowMaxDistance;
-    rowMaxDistance.resize(nseqs, 0.0);
-    double z = num_states / (num_states - 1.0);
-    //Compute the upper-triangle of the distance matrix
-    //(and write the row maximum onto the firt cell in the row)
-    
-    bool count_unknown_as_different = Params::getInstance().count_unknown_as_different;
-        //Unknown counts as 50% different.
+    HammingDistanceFunctor<L, F> distance
+        ( unknown, sequenceMatrix, seqLen, denominator, frequencyVector
+        , uncorrected, num_states, slices );
+    size_t bytes_per_sequence = (slices!=nullptr)
+                              ? slices->getBytesPerSequence()
+                              : seqLen * sizeof(L);
     
     #if USE_PROGRESS_DISPLAY
     progress_display progress(nseqs*(nseqs-1)/2, "Calculating observed distances");
@@ -4006,101 +4350,12 @@ template <class L, class F> double computeDistanceMatrix
     double progress = 0;
     #endif
     
-    #ifdef _OPENMP
-    #pragma omp parallel for schedule(dynamic)
-    #endif
-    for (intptr_t seq1 = 0; seq1<nseqs; ++seq1 ) {
-        //Scanning is from bottom to top so that if "uneven execution"
-        //results in the last few rows being allocated to some worker thread
-        //just before the others finish... it won't be running
-        //"all by itsef" for as long.
-        size_t   rowOffset     = nseqs * seq1;
-        double*  distRow       = dist_mat       + rowOffset;
-        const L* thisSequence  = sequenceMatrix + seq1 * seqLen;
-        const L* otherSequence = thisSequence   + seqLen;
-        double maxDistanceInRow = 0.0;
-        for (intptr_t seq2 = seq1 + 1; seq2 < nseqs; ++seq2) {
-            double distance = distRow[seq2];
-            if ( 0.0 == distance ) {
-                double unknownFreq = 0;
-                double hamming =
-                    hammingDistance ( unknown, thisSequence, otherSequence
-                                    , seqLen, frequencyVector, unknownFreq );
-                if (count_unknown_as_different) {
-                    distance = ( hamming + unknownFreq * 0.75 ) / denominator;
-                    if (0<distance && !uncorrected) {
-                        double x      = (1.0 - z * distance);
-                        distance      = (x<=0) ? MAX_GENETIC_DIST : ( -log(x) / z );
-                    }
-                } else if (0<hamming && unknownFreq < denominator) {
-                    distance = hamming / (denominator - unknownFreq);
-                    if (!uncorrected) {
-                        double x      = (1.0 - z * distance);
-                        distance      = (x<=0) ? MAX_GENETIC_DIST : ( -log(x) / z );
-                    }
-                }
-                distRow[seq2] = distance;
-            }
-            if ( maxDistanceInRow < distance )
-            {
-                maxDistanceInRow = distance;
-            }
-            otherSequence += seqLen;
-        }
-        rowMaxDistance[seq1] = maxDistanceInRow;
-        progress += (nseqs - 1 - seq1);
-    }
-    #if USE_PROGRESS_DISPLAY
-    progress.done();
-    #endif
-    
-    //
-    //Determine the longest distance
-    //Todo: Decide if it is worth figuring this out by
-    //      compare-exchange first half, second half,
-    //      (and shrink by half) repeatedly.
-    //      Because each compare-exchange cycle can have
-    //      its own #pragma omp parallel for.
-    //Note: I don't think it is worth it.  Lots of tricky
-    //      code for an O(n) step in an O(L.N^2) problem.
-    //
-    double longest_dist = 0.0;
-    for ( intptr_t seq1 = 0; seq1 < nseqs; ++seq1  ) {
-        if ( longest_dist < rowMaxDistance[seq1] ) {
-            longest_dist = rowMaxDistance[seq1];
-        }
-    }
+    double longest_dist = computeDistanceTiles
+        ( distance, nseqs, getDistanceTileWidth(bytes_per_sequence)
+        , dist_mat, &progress );
 
-    //
-    //Copy upper-triangle into lower-triangle and write
-    //zeroes to the diagonal.
-    //
-    
-    #if USE_PROGRESS_DISPLAY
-    const char* taskReflect = "Determining distance matrix lower triangle from upper";
-    if (verbose_mode<VB_MED) taskReflect="";
-    double work_to_do = (double)nseqs * ((double)nseqs - 1.0) * 0.5;
-    progress_display progress2(work_to_do, taskReflect);
-    #else
-    double progress2 = 0.0;
-    #endif
-    
-    #ifdef _OPENMP
-    #pragma omp parallel for schedule(dynamic)
-    #endif
-    for ( intptr_t back_seq = 0; back_seq < nseqs; ++back_seq ) {
-        intptr_t seq1      = nseqs - 1 - back_seq;
-        intptr_t rowOffset = nseqs * seq1;
-        double*  distRow   = dist_mat + rowOffset;
-        double*  distCol   = dist_mat + seq1; //current entries in the columns
-        for ( intptr_t seq2 = 0; seq2 < seq1; ++seq2, distCol+=nseqs ) {
-            distRow [ seq2 ] = *distCol;
-        }
-        distRow [ seq1 ] = 0.0;
-        progress2 += seq1;
-    }
     #if USE_PROGRESS_DISPLAY
-    progress2.done();
+    progress.done();
     #endif
     return longest_dist;
 }
@@ -4185,13 +4440,25 @@ double PhyloTree::computeDistanceMatrix_Experimental() {
         << " at " << s.getSequenceLength() << " varying sites"
         << " for " << s.getSequenceCount() << " sequences");
     s.constructSequenceMatrix(true);
-    EX_TRACE("Determining distance matrix");
     const int* frequencies = s.getSiteFrequencies().data();
+    BitSlicedSequences* slices = nullptr;
+    if (aln->num_states <= 4) {
+        //For DNA (and binary) alignments, a bit-plane per state (and one
+        //for unknown states) takes less memory than a byte per site,
+        //and pairwise distances can be calculated 64 sites at a time.
+        EX_TRACE("Constructing bit-sliced sequences");
+        slices = new BitSlicedSequences
+            ( static_cast<char>(aln->STATE_UNKNOWN), aln->num_states
+             , s.getSequenceMatrix(), s.getSequenceCount()
+             , s.getSequenceLength(), frequencies );
+    }
+    EX_TRACE("Determining distance matrix");
     double longest = ::computeDistanceMatrix
         ( params->ls_var_type, static_cast<char>(aln->STATE_UNKNOWN)
          , s.getSequenceMatrix(), s.getSequenceCount(), s.getSequenceLength()
          , denominator, frequencies, aln->num_states
-         , uncorrected, dist_matrix);
+         , uncorrected, dist_matrix, slices);
+    delete slices;
     EX_TRACE("Longest distance was " << longest);
     return longest;
 }
@@ -4210,52 +4477,15 @@ double PhyloTree::computeDistanceMatrix() {
         double progress = 0.0;
     #endif
     
-    //compute the upper-triangle of distance matrix
-    #ifdef _OPENMP
-    #pragma omp parallel for schedule(dynamic)
-    #endif
-    for (int seq1 = 0; seq1 < nseqs; ++seq1) {
-        #ifdef _OPENMP
-            int threadNum = omp_get_thread_num();
-        #else
-            int threadNum = 0;
-        #endif
-        AlignmentPairwise* processor = distanceProcessors[threadNum];
-        size_t rowStartPos = seq1 * nseqs;
-        for (int seq2=seq1+1; seq2 < nseqs; ++seq2) {
-            size_t sym_pos = rowStartPos + seq2;
-            double d2l = 0;
-            dist_matrix[sym_pos] = processor->recomputeDist(seq1, seq2, dist_matrix[sym_pos], d2l);
-        }
-        progress += static_cast<double>(nseqs - seq1 - 1);
-    }
+    //compute the upper-triangle of distance matrix (copying it
+    //into the lower-triangle, as it goes)
+    PairwiseDistanceFunctor distance(distanceProcessors);
+    size_t bytes_per_sequence = aln->getNPattern() * sizeof(StateType);
+    longest_dist = computeDistanceTiles
+        ( distance, nseqs, getDistanceTileWidth(bytes_per_sequence)
+        , dist_matrix, &progress );
     #if USE_PROGRESS_DISPLAY
     progress.done();
-    const char* taskReflect = "Determining distance matrix lower triangle from upper";
-    if (verbose_mode<VB_MED) taskReflect="";    
-    progress_display progress2(work_estimate, taskReflect);
-    #else
-    double progress2 = 0.0;
-    #endif
-
-    //cout << (getRealTime()-baseTime) << "s Copying to lower triangle" << endl;
-    //copy upper-triangle into lower-triangle and set diagonal = 0
-    for (size_t seq1 = 1; seq1 < nseqs; ++seq1) {
-        size_t rowStartPos = seq1 * nseqs;
-        size_t rowStopPos  = rowStartPos + seq1;
-        size_t colPos = seq1;
-        for (size_t rowPos = rowStartPos; rowPos<rowStopPos; ++rowPos, colPos+=nseqs) {
-            auto d = dist_matrix[colPos];
-            dist_matrix [ rowPos ] = d;
-            if (d > longest_dist) {
-                longest_dist = d;
-            }
-        }
-        dist_matrix [ rowStopPos] = 0.0;
-        progress2 += seq1;
-    }
-    #if USE_PROGRESS_DISPLAY
-    progress2.done();
     #endif
     doneComputingDistances();
 
@@ -4587,7 +4817,7 @@ void PhyloTree::doOneRandomNNI(Branch branch) {
 }
 */
     
-NNIMove PhyloTree::getRandomNNI(Branch &branch) {
+NNIMove PhyloTree::getRandomNNI(Branch &branch, int* rstream) {
     ASSERT(isInnerBranch(branch.first, branch.second));
     // for rooted tree
     if (((PhyloNeighbor*)branch.first->findNeighbor(branch.second))->direction == TOWARD_ROOT) {
@@ -4603,7 +4833,7 @@ NNIMove PhyloTree::getRandomNNI(Branch &branch) {
             nni.node1Nei_it = node1NeiIt;
             break;
         }
-    int randInt = random_int(static_cast<int>(branch.second->neighbors.size())-1);
+    int randInt = random_int(static_cast<int>(branch.second->neighbors.size())-1, rstream);
     int cnt = 0;
     FOR_NEIGHBOR_IT(branch.second, branch.first, node2NeiIt) {
         // if this loop, is it sure that direction is away from root because node1->node2 is away from root
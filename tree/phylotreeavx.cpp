@@ -30,12 +30,24 @@
 #endif
 
 void PhyloTree::setParsimonyKernelAVX() {
+    if (isUsingSankoffParsimony() && canUseShortSankoffParsimony()) {
+        setShortSankoffParsimony(true);
+        computeParsimonyBranchPointer           = &PhyloTree::computeParsimonyBranchSankoffShortSIMD<Vec16us, Vec8ui>;
+        computeParsimonyOutOfTreePointer        = &PhyloTree::computeParsimonyOutOfTreeSankoffShortSIMD<Vec16us, Vec8ui>;
+        computePartialParsimonyPointer          = &PhyloTree::computePartialParsimonySankoffShortSIMD<Vec16us, Vec8ui>;
+        computePartialParsimonyOutOfTreePointer = &PhyloTree::computePartialParsimonyOutOfTreeSankoffShortSIMD<Vec16us, Vec8ui>;
+        getSubTreeParsimonyPointer              = &PhyloTree::getSubTreeParsimonySankoffShortSIMD<Vec16us, Vec8ui>;
+        computePatternParsimonyPointer          = nullptr;
+        return;
+    }
     if (isUsingSankoffParsimony()) {
+        setShortSankoffParsimony(false);
         computeParsimonyBranchPointer           = &PhyloTree::computeParsimonyBranchSankoffSIMD<Vec8ui>;
         computeParsimonyOutOfTreePointer        = &PhyloTree::computeParsimonyOutOfTreeSankoffSIMD<Vec8ui>;
         computePartialParsimonyPointer          = &PhyloTree::computePartialParsimonySankoffSIMD<Vec8ui>;
         computePartialParsimonyOutOfTreePointer = &PhyloTree::computePartialParsimonyOutOfTreeSankoffSIMD<Vec8ui>;
         getSubTreeParsimonyPointer              = &PhyloTree::getSubTreeParsimonySankoffSIMD<Vec8ui>;
+        computePatternParsimonyPointer          = nullptr;
         return;
     }
     // Fitch kernel
@@ -44,6 +56,7 @@ void PhyloTree::setParsimonyKernelAVX() {
     computePartialParsimonyPointer          = &PhyloTree::computePartialParsimonyFastSIMD<Vec8ui>;
     computePartialParsimonyOutOfTreePointer = &PhyloTree::computePartialParsimonyOutOfTreeSIMD<Vec8ui>;
     getSubTreeParsimonyPointer              = &PhyloTree::getSubTreeParsimonyFastSIMD<Vec8ui>;
+    computePatternParsimonyPointer          = &PhyloTree::computePatternParsimonyFastSIMD<Vec8ui>;
 }
 
 void PhyloTree::setDotProductAVX() {
@@ -0,0 +1,48 @@
+/*
+ * phylotreeavx512.cpp
+ *
+ * AVX-512 parsimony kernels. These are built (with VPOPCNTDQ enabled)
+ * whenever the compiler supports it, and are chosen at run time, by
+ * PhyloTree::setParsimonyKernel, only if the CPU has VPOPCNTDQ.
+ *
+ */
+
+#if defined(_MSC_VER) && !defined(_CRT_SECURE_NO_WARNINGS)
+ //Turn off (4) warnings about sprintf calls in ncl\nxsstring.h
+#define _CRT_SECURE_NO_WARNINGS (1)
+#endif
+
+#define MAX_VECTOR_SIZE 512 // for VectorClass
+
+#include "vectorclass/vectorclass.h"
+#include "phylokernel.h"
+
+#if !defined ( __AVX512F__ ) || !defined ( __AVX512VPOPCNTDQ__ )
+#error "You must compile this file with AVX512F and AVX512VPOPCNTDQ enabled!"
+#endif
+
+void PhyloTree::setParsimonyKernelAVX512() {
+    if (isUsingSankoffParsimony() && canUseShortSankoffParsimony()) {
+        //Without AVX512BW there are no 16-bit AVX-512 vectors, and the
+        //16-bit AVX kernels handle as many patterns per instruction.
+        setParsimonyKernelAVX();
+        return;
+    }
+    if (isUsingSankoffParsimony()) {
+        setShortSankoffParsimony(false);
+        computeParsimonyBranchPointer           = &PhyloTree::computeParsimonyBranchSankoffSIMD<Vec16ui>;
+        computeParsimonyOutOfTreePointer        = &PhyloTree::computeParsimonyOutOfTreeSankoffSIMD<Vec16ui>;
+        computePartialParsimonyPointer          = &PhyloTree::computePartialParsimonySankoffSIMD<Vec16ui>;
+        computePartialParsimonyOutOfTreePointer = &PhyloTree::computePartialParsimonyOutOfTreeSankoffSIMD<Vec16ui>;
+        getSubTreeParsimonyPointer              = &PhyloTree::getSubTreeParsimonySankoffSIMD<Vec16ui>;
+        computePatternParsimonyPointer          = nullptr;
+        return;
+    }
+    // Fitch kernel
+    computeParsimonyBranchPointer           = &PhyloTree::computeParsimonyBranchFastSIMD<Vec16ui>;
+    computeParsimonyOutOfTreePointer        = &PhyloTree::computeParsimonyOutOfTreeSIMD<Vec16ui>;
+    computePartialParsimonyPointer          = &PhyloTree::computePartialParsimonyFastSIMD<Vec16ui>;
+    computePartialParsimonyOutOfTreePointer = &PhyloTree::computePartialParsimonyOutOfTreeSIMD<Vec16ui>;
+    getSubTreeParsimonyPointer              = &PhyloTree::getSubTreeParsimonyFastSIMD<Vec16ui>;
+    computePatternParsimonyPointer          = &PhyloTree::computePatternParsimonyFastSIMD<Vec16ui>;
+}
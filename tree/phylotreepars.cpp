@@ -41,163 +41,31 @@ static inline uint32_t vml_popcnt (uint32_t a) {
 /****** optimized version of parsimony kernel **************/
 /***********************************************************/
 
-void PhyloTree::computePartialParsimonyFast(PhyloNeighbor *dad_branch, PhyloNode *dad) {
+void PhyloTree::computePartialParsimonyFast(PhyloNeighbor *dad_branch, PhyloNode *dad,
+                                            ParsimonyExecution exec) {
     if (dad_branch->isParsimonyComputed()) {
         return;
     }
     PhyloNode* node    = dad_branch->getNode();
     int        nstates = aln->getMaxNumStates();
-    int        site    = 0;
 
     dad_branch->setParsimonyComputed(true);
 
-    vector<Alignment*> *partitions = NULL;
-    if (aln->isSuperAlignment())
-        partitions = &((SuperAlignment*)aln)->partitions;
-    else {
-        partitions = new vector<Alignment*>;
-        partitions->push_back(aln);
-    }
-
     if (node->name == ROOT_NAME) {
         ASSERT(dad);
         memset(dad_branch->partial_pars, 255, pars_block_size*sizeof(UINT));
-        size_t bits_per_state  = max(aln->size(), (size_t)aln->num_variant_sites);
+        size_t bits_per_state  = aln->getMaxNumParsimonyBits();
         size_t uints_per_state = (bits_per_state + SIMD_BITS - 1) / UINT_BITS;
         size_t total           = aln->getMaxNumStates() * uints_per_state;
         dad_branch->partial_pars[total]=0; //Todo: don't we want to count
     } else if (node->isLeaf() && dad) {
         // external node
-        int leafid = node->id;
-        memset(dad_branch->partial_pars, 0, pars_block_size*sizeof(UINT));
-        int max_sites = ((aln->num_parsimony_sites+UINT_BITS-1)/UINT_BITS)*UINT_BITS;
-        int ambi_aa[] = {2, 3, 5, 6, 9, 10}; // {4+8, 32+64, 512+1024};
-//        if (aln->ordered_pattern.empty())
-//            aln->orderPatternByNumChars();
-        ASSERT(!aln->ordered_pattern.empty());
-        int start_pos = 0;
-        for (vector<Alignment*>::iterator alnit = partitions->begin(); alnit != partitions->end(); alnit++) {
-            int end_pos = start_pos + static_cast<int>((*alnit)->ordered_pattern.size());
-            switch ((*alnit)->seq_type) {
-            case SEQ_DNA:
-                for (int patid = start_pos; patid != end_pos; patid++) {
-                    Alignment::iterator pat = aln->ordered_pattern.begin()+ patid;
-                    int state = pat->at(leafid);
-                    int freq = pat->frequency;
-                    if (state < 4) {
-                        for (int j = 0; j < freq; j++, site++) {
-                            dad_branch->partial_pars[(site/UINT_BITS)*nstates+state] |= (1 << (site % UINT_BITS));
-                        }
-                    } else if (state == (*alnit)->STATE_UNKNOWN) {
-                        for (int j = 0; j < freq; j++, site++) {
-                            UINT *p = dad_branch->partial_pars+((site/UINT_BITS)*nstates);
-                            UINT bit1 = (1 << (site%UINT_BITS));
-                            p[0] |= bit1;
-                            p[1] |= bit1;
-                            p[2] |= bit1;
-                            p[3] |= bit1;
-                        }
-                    } else {
-                        state -= 3;
-                        ASSERT(state < 15);
-                        for (int j = 0; j < freq; j++, site++) {
-                            UINT *p = dad_branch->partial_pars+((site/UINT_BITS)*nstates);
-                            UINT bit1 = (1 << (site%UINT_BITS));
-                            for (int i = 0; i < 4; i++)
-                                if (state & (1<<i))
-                                    p[i] |= bit1;
-                        }
-                    }
-                }
-                //assert(site == aln->num_informative_sites);
-                // add dummy states
-                //if (site < max_sites)
-                //    dad_branch->partial_pars[(site/UINT_BITS)*4] |= ~((1<<(site%UINT_BITS)) - 1);
-                break;
-            case SEQ_PROTEIN:
-                for (int patid = start_pos; patid != end_pos; patid++) {
-                    Alignment::iterator pat = aln->ordered_pattern.begin()+ patid;
-                    int state = pat->at(leafid);
-                    int freq = pat->frequency;
-                    if (state < 20) {
-                        for (int j = 0; j < freq; j++, site++) {
-                            dad_branch->partial_pars[(site/UINT_BITS)*nstates+state] |= (1 << (site % UINT_BITS));
-                        }
-                    } else if (state == (*alnit)->STATE_UNKNOWN) {
-                        for (int j = 0; j < freq; j++, site++) {
-                            UINT *p = dad_branch->partial_pars+((site/UINT_BITS)*nstates);
-                            UINT bit1 = (1 << (site%UINT_BITS));
-                            for (int i = 0; i < 20; i++)
-                                    p[i] |= bit1;
-                        }
-                    } else {
-                        ASSERT(state < 23);
-                        state = (state-20)*2;
-                        for (int j = 0; j < freq; j++, site++) {
-                            UINT *p = dad_branch->partial_pars+((site/UINT_BITS)*nstates);
-                            UINT bit1 = (1 << (site%UINT_BITS));
-                            p[ambi_aa[state]] |= bit1;
-                            p[ambi_aa[state+1]] |= bit1;
-                        }
-                    }
-                }
-                //assert(site == aln->num_informative_sites);
-                // add dummy states
-                //if (site < max_sites)
-                //    dad_branch->partial_pars[(site/UINT_BITS)*20] |= ~((1<<(site%UINT_BITS)) - 1);
-                break;
-            default:
-                for (int patid = start_pos; patid != end_pos; patid++) {
-                    Alignment::iterator pat = aln->ordered_pattern.begin()+ patid;
-                    int state = pat->at(leafid);
-                    int freq = pat->frequency;
-                    if (aln->seq_type == SEQ_POMO && state >= static_cast<int>((*alnit)->num_states) 
-                        && state < static_cast<int>((*alnit)->STATE_UNKNOWN)) {
-                        state = (*alnit)->convertPomoState(state);
-                    }
-                     if (state < (*alnit)->num_states) {
-                        for (int j = 0; j < freq; j++, site++) {
-                            dad_branch->partial_pars[(site/UINT_BITS)*nstates+state] |= (1 << (site % UINT_BITS));
-                        }
-                    } else if (state == (*alnit)->STATE_UNKNOWN) {
-                        for (int j = 0; j < freq; j++, site++) {
-                            UINT *p = dad_branch->partial_pars+((site/UINT_BITS)*nstates);
-                            UINT bit1 = (1 << (site%UINT_BITS));
-                            for (int i = 0; i < (*alnit)->num_states; i++)
-                                    p[i] |= bit1;
-                        }
-                    } else {
-                        ASSERT(0);
-                    }
-                }
-                break;
-            } // end of switch
-            
-            start_pos = end_pos;
-        } // FOR LOOP
-
-        ASSERT(site == aln->num_parsimony_sites);
-        // add dummy states
-        if (site < max_sites) {
-            dad_branch->partial_pars[(site/UINT_BITS)*nstates] |= ~((1<<(site%UINT_BITS)) - 1);
-        }
-        {
-            //Count sites where the taxon, indicated by leafid, is the
-            //taxon that has a "singleton" state (is the only one in the
-            //pattern with this state, when all of the others that have
-            //known states have the one known state).
-            //
-            //(Such sites are parsimony-uninformative but tracking how
-            // many of them there are, per taxon, potentially makes
-            // parsimony branch lengths more accurate).
-            //
-            size_t bits_per_state  = max(aln->size(), (size_t)aln->num_variant_sites);
-            size_t uints_per_state = (bits_per_state + SIMD_BITS - 1) / UINT_BITS;
-            size_t total           = aln->getMaxNumStates() * uints_per_state;
-            if ( 0 <= leafid && leafid < aln->singleton_parsimony_states.size() ) {
-                dad_branch->partial_pars[total] = aln->singleton_parsimony_states[leafid];
-            }
-        }
+        size_t bits_per_state  = aln->getMaxNumParsimonyBits();
+        size_t uints_per_state = (bits_per_state + SIMD_BITS - 1) / UINT_BITS;
+        size_t total           = aln->getMaxNumStates() * uints_per_state;
+        memcpy(dad_branch->partial_pars,
+               getLeafPartialParsimony(node->id, 1, total),
+               pars_block_size*sizeof(UINT));
     } else {
         // internal node
         ASSERT(node->degree() == 3 || (dad==nullptr && 1<node->degree())  );  // it works only for strictly bifurcating tree
@@ -245,12 +113,12 @@ void PhyloTree::computePartialParsimonyFast(PhyloNeighbor *dad_branch, PhyloNode
                 intptr_t start_index = layers[layer_no];
                 intptr_t stop_index  = layers[layer_no+1];
                 #ifdef _OPENMP
-                #pragma omp parallel for
+                #pragma omp parallel for if(exec==PARS_SITE_PARALLEL)
                 #endif
                 for (intptr_t i=start_index; i<stop_index; ++i) {
                     PhyloNeighbor* stack_nei  = things_to_do[i].first;
                     PhyloNode*     stack_node = things_to_do[i].second;
-                    computePartialParsimonyFast(stack_nei, stack_node);
+                    computePartialParsimonyFast(stack_nei, stack_node, PARS_BRANCH_PARALLEL);
                     //LOG_LINE(VB_MIN, "To do " << i
                     //         << " set score " << getSubTreeParsimonyFast(stack_nei));
                 }
@@ -261,28 +129,27 @@ void PhyloTree::computePartialParsimonyFast(PhyloNeighbor *dad_branch, PhyloNode
         if (left!=nullptr && right!=nullptr) {
             computePartialParsimonyOutOfTreeFast(left->partial_pars,
                                                  right->partial_pars,
-                                                 dad_branch->partial_pars);
+                                                 dad_branch->partial_pars, exec);
         }
     }
-    if (!aln->isSuperAlignment()) {
-        delete partitions;
-    }
 }
 
 double PhyloTree::computePartialParsimonyOutOfTreeFast(const UINT* left_partial_pars,
                                                     const UINT* right_partial_pars,
-                                                    UINT* dad_partial_pars) const {
+                                                    UINT* dad_partial_pars,
+                                                    ParsimonyExecution exec) const {
 
     int  nstates = aln->getMaxNumStates();
     UINT score   = 0;
-    int  nsites  = aln->num_parsimony_sites;
+    int  nsites  = aln->num_parsimony_bits;
+    const UINT* weight = aln->pars_word_weight.data();
     
     nsites = (nsites+UINT_BITS-1)/UINT_BITS;
 
     switch (nstates) {
     case 4:
         #ifdef _OPENMP
-        #pragma omp parallel for reduction(+: score) if(nsites>200)
+        #pragma omp parallel for reduction(+: score) if(exec==PARS_SITE_PARALLEL && nsites>200)
         #endif
         for (int site = 0; site<nsites; ++site) {
             UINT w;
@@ -296,7 +163,7 @@ double PhyloTree::computePartialParsimonyOutOfTreeFast(const UINT* left_partial_
             z[3] = x[3] & y[3];
             w = z[0] | z[1] | z[2] | z[3];
             w = ~w;
-            score += __builtin_popcount(w);
+            score += weight[site] * __builtin_popcount(w);
             z[0] |= w & (x[0] | y[0]);
             z[1] |= w & (x[1] | y[1]);
             z[2] |= w & (x[2] | y[2]);
@@ -305,7 +172,7 @@ double PhyloTree::computePartialParsimonyOutOfTreeFast(const UINT* left_partial_
         break;
     default:
         #ifdef _OPENMP
-        #pragma omp parallel for reduction(+: score) if(nsites > 800/nstates)
+        #pragma omp parallel for reduction(+: score) if(exec==PARS_SITE_PARALLEL && nsites > 800/nstates)
         #endif
         for (int site = 0; site<nsites; ++site) {
             UINT   w = 0;
@@ -319,14 +186,14 @@ double PhyloTree::computePartialParsimonyOutOfTreeFast(const UINT* left_partial_
                 w |= z[i];
             }
             w = ~w;
-            score += vml_popcnt(w);
+            score += weight[site] * vml_popcnt(w);
             for (int i = 0; i < nstates; i++) {
                 z[i] |= w & (x[i] | y[i]);
             }
         }
         break;
     }
-    size_t bits_per_state   = max(aln->size(), (size_t)aln->num_variant_sites);
+    size_t bits_per_state   = aln->getMaxNumParsimonyBits();
     size_t uints_per_state  = (bits_per_state + SIMD_BITS - 1) / UINT_BITS;
     size_t total            = aln->getMaxNumStates() * uints_per_state;
     dad_partial_pars[total] = score + left_partial_pars[total] + right_partial_pars[total];
@@ -336,12 +203,145 @@ double PhyloTree::computePartialParsimonyOutOfTreeFast(const UINT* left_partial_
 int PhyloTree::getSubTreeParsimonyFast(PhyloNeighbor* dad_branch) const {
     //Must agree with how computePartialParsimonyOutOfTreeFast
     //records total subtree parsimony
-    size_t bits_per_state  = max(aln->size(), (size_t)aln->num_variant_sites);
+    size_t bits_per_state  = aln->getMaxNumParsimonyBits();
     size_t uints_per_state = (bits_per_state + SIMD_BITS - 1) / UINT_BITS;
     size_t total           = aln->getMaxNumStates() * uints_per_state;
     return dad_branch->partial_pars[total];
 }
 
+namespace {
+    /** a view (directed branch) that PhyloTree::lockParsimonyView
+        is to make sure is computed, and how far it has got with it */
+    struct ParsimonyViewLoad {
+        PhyloNeighbor*              nei;
+        PhyloNode*                  dad;
+        bool                        started;
+        std::vector<PhyloNeighbor*> inputs; //views it is computed from
+        size_t                      next_input;
+        ParsimonyViewLoad(PhyloNeighbor* view, PhyloNode* from)
+            : nei(view), dad(from), started(false), next_input(0) {}
+    };
+
+    /** the views that the partial parsimony of a view is computed from
+        (for Sankoff parsimony, views of leaves are not needed, since
+        the kernels read the tip vectors directly) */
+    void getParsimonyViewInputs(PhyloNeighbor* dad_branch, PhyloNode* dad,
+                                bool sankoff, std::vector<PhyloNeighbor*>& inputs) {
+        PhyloNode* node = dad_branch->getNode();
+        inputs.clear();
+        FOR_EACH_PHYLO_NEIGHBOR(node, dad, it, nei) {
+            if (sankoff && (nei->node->isLeaf() || nei->node->name == ROOT_NAME)) {
+                continue;
+            }
+            inputs.push_back(nei);
+        }
+    }
+}
+
+/**
+ * Counts how many views (in the subtree that dad_branch leads to)
+ * must be computed before dad_branch can be (stopping at views
+ * that are already computed, and have slots), and records the
+ * count for each of them in costs (iteratively, since trees can be deep).
+ */
+void PhyloTree::countParsimonyViewsToCompute(PhyloNeighbor* dad_branch, PhyloNode* dad,
+                                             unordered_map<PhyloNeighbor*, intptr_t>& costs) {
+    bool sankoff = isUsingSankoffParsimony();
+    std::vector<ParsimonyViewLoad> stack;
+    std::vector<PhyloNeighbor*>    inputs;
+    stack.emplace_back(dad_branch, dad);
+    while (!stack.empty()) {
+        PhyloNeighbor* nei = stack.back().nei;
+        PhyloNode*     from = stack.back().dad;
+        if (nei->isParsimonyComputed() && 0 <= pars_slots.findNei(nei)) {
+            costs[nei] = 0;
+            stack.pop_back();
+            continue;
+        }
+        getParsimonyViewInputs(nei, from, sankoff, inputs);
+        if (!stack.back().started) {
+            stack.back().started = true;
+            for (PhyloNeighbor* input : inputs) {
+                stack.emplace_back(input, nei->getNode());
+            }
+            continue;
+        }
+        intptr_t cost = 1;
+        for (PhyloNeighbor* input : inputs) {
+            cost += costs[input];
+        }
+        costs[nei] = cost;
+        stack.pop_back();
+    }
+}
+
+UINT* PhyloTree::lockParsimonyView(PhyloNeighbor* dad_branch, PhyloNode* dad) {
+    ASSERT(isUsingParsimonySlots());
+    if (dad_branch->isParsimonyComputed() && pars_slots.lock(dad_branch)) {
+        return dad_branch->partial_pars;
+    }
+    //
+    //Views are computed (and locked) depth-first, without recursion.
+    //The inputs of each view are loaded in decreasing order of the
+    //number of views that must be computed for them, so that the
+    //number of views locked at once grows only with the logarithm
+    //of the number of taxa (each view that is locked while a sibling
+    //is being loaded, required at least as much work as that sibling).
+    //
+    bool sankoff = isUsingSankoffParsimony();
+    unordered_map<PhyloNeighbor*, intptr_t> costs;
+    std::vector<std::pair<intptr_t, int> >       order;
+    std::vector<PhyloNeighbor*>                  inputs;
+    std::vector<ParsimonyViewLoad>               stack;
+    stack.emplace_back(dad_branch, dad);
+    while (!stack.empty()) {
+        ParsimonyViewLoad& load = stack.back();
+        if (!load.started) {
+            if (load.nei->isParsimonyComputed() && pars_slots.lock(load.nei)) {
+                stack.pop_back();
+                continue;
+            }
+            auto found = costs.find(load.nei);
+            if (found == costs.end() || found->second == 0) {
+                //Not seen before, or evicted since it was counted
+                countParsimonyViewsToCompute(load.nei, load.dad, costs);
+            }
+            getParsimonyViewInputs(load.nei, load.dad, sankoff, inputs);
+            order.clear();
+            for (size_t i = 0; i < inputs.size(); ++i) {
+                order.emplace_back(-costs[inputs[i]], static_cast<int>(i));
+            }
+            std::sort(order.begin(), order.end());
+            for (size_t i = 0; i < order.size(); ++i) {
+                load.inputs.push_back(inputs[order[i].second]);
+            }
+            load.started = true;
+        }
+        if (load.next_input < load.inputs.size()) {
+            PhyloNeighbor* input = load.inputs[load.next_input++];
+            PhyloNode*     node  = load.nei->getNode();
+            stack.emplace_back(input, node); //(load is now invalid)
+            continue;
+        }
+        //All of the inputs are computed, and locked
+        if (pars_slots.allocate(load.nei) < 0) {
+            outError("Too little memory for partial parsimony vectors;"
+                     " increase -pars-mem");
+        }
+        pars_slots.lock(load.nei);
+        (this->*computePartialParsimonyPointer)(load.nei, load.dad, PARS_SITE_PARALLEL);
+        for (PhyloNeighbor* input : load.inputs) {
+            pars_slots.unlock(input);
+        }
+        stack.pop_back();
+    }
+    return dad_branch->partial_pars;
+}
+
+void PhyloTree::unlockParsimonyView(PhyloNeighbor* dad_branch) {
+    pars_slots.unlock(dad_branch);
+}
+
 int PhyloTree::computeParsimonyBranchFast(PhyloNeighbor *dad_branch,
                                           PhyloNode *dad, int *branch_subst) {
     PhyloNode*     node        = dad_branch->getNode();
@@ -358,16 +358,18 @@ int PhyloTree::computeParsimonyBranchFast(PhyloNeighbor *dad_branch,
     }
     return computeParsimonyOutOfTreeFast(dad_branch->partial_pars,
                                          node_branch->partial_pars,
-                                         branch_subst );
+                                         branch_subst, PARS_SITE_PARALLEL );
 }
 
 int PhyloTree::computeParsimonyOutOfTreeFast(const UINT* dad_partial_pars,
                                              const UINT* node_partial_pars,
-                                             int*        branch_subst) const {
-    int nsites = (aln->num_parsimony_sites + UINT_BITS-1) / UINT_BITS;
+                                             int*        branch_subst,
+                                             ParsimonyExecution exec) const {
+    int nsites = (aln->num_parsimony_bits + UINT_BITS-1) / UINT_BITS;
     int nstates = aln->getMaxNumStates();
+    const UINT* weight = aln->pars_word_weight.data();
 
-    size_t bits_per_state  = max(aln->size(), (size_t)aln->num_variant_sites);
+    size_t bits_per_state  = aln->getMaxNumParsimonyBits();
     size_t uints_per_state = (bits_per_state + SIMD_BITS - 1) / UINT_BITS;
     size_t total           = aln->getMaxNumStates() * uints_per_state;
     
@@ -381,7 +383,7 @@ int PhyloTree::computeParsimonyOutOfTreeFast(const UINT* dad_partial_pars,
     switch (nstates) {
     case 4:
         #ifdef _OPENMP
-        #pragma omp parallel for reduction(+: score) if(nsites>200)
+        #pragma omp parallel for reduction(+: score) if(exec==PARS_SITE_PARALLEL && nsites>200)
         #endif
         for (int site = 0; site < nsites; ++site) {
             size_t offset = 4*site;
@@ -389,7 +391,7 @@ int PhyloTree::computeParsimonyOutOfTreeFast(const UINT* dad_partial_pars,
             const UINT *y = node_partial_pars + offset;
             UINT w = (x[0] & y[0]) | (x[1] & y[1]) | (x[2] & y[2]) | (x[3] & y[3]);
             w = ~w;
-            score += vml_popcnt(w);
+            score += weight[site] * vml_popcnt(w);
 //            #ifndef _OPENMP
 //            if (score >= lower_bound)
 //                break;
@@ -398,7 +400,7 @@ int PhyloTree::computeParsimonyOutOfTreeFast(const UINT* dad_partial_pars,
         break;
     default:
         #ifdef _OPENMP
-        #pragma omp parallel for reduction(+: score) if(nsites > 800/nstates)
+        #pragma omp parallel for reduction(+: score) if(exec==PARS_SITE_PARALLEL && nsites > 800/nstates)
         #endif
         for (int site = 0; site < nsites; ++site) {
             size_t offset = nstates * site;
@@ -410,7 +412,7 @@ int PhyloTree::computeParsimonyOutOfTreeFast(const UINT* dad_partial_pars,
                 w |= x[i] & y[i];
             }
             w = ~w;
-            score += vml_popcnt(w);
+            score += weight[site] * vml_popcnt(w);
 //            #ifndef _OPENMP
 //            if (score >= lower_bound)
 //                break;
@@ -426,6 +428,48 @@ int PhyloTree::computeParsimonyOutOfTreeFast(const UINT* dad_partial_pars,
 }
 
 
+void PhyloTree::getParsimonyJoins(PhyloNeighbor *dad_branch, PhyloNode *dad,
+                                  vector<pair<const UINT*, const UINT*> > &joins) {
+    PhyloNode* node = dad_branch->getNode();
+    if (node->isLeaf()) {
+        return;
+    }
+    PhyloNeighbor *left = NULL, *right = NULL;
+    FOR_EACH_PHYLO_NEIGHBOR(node, dad, it, pit) {
+        getParsimonyJoins(pit, node, joins);
+        if (!left) left = pit; else right = pit;
+    }
+    ASSERT(right);
+    joins.push_back(make_pair(left->partial_pars, right->partial_pars));
+}
+
+void PhyloTree::computePatternParsimonyFast(UINT *ptn_pars) {
+    int    nstates = aln->getMaxNumStates();
+    size_t nwords  = (aln->num_parsimony_bits + UINT_BITS - 1) / UINT_BITS;
+
+    PhyloNode*     dad         = getRoot();
+    PhyloNeighbor* dad_branch  = dad->firstNeighbor();
+    PhyloNeighbor* node_branch = dad_branch->getNode()->findNeighbor(dad);
+    computeParsimonyBranch(dad_branch, dad);
+
+    vector<pair<const UINT*, const UINT*> > joins;
+    getParsimonyJoins(dad_branch, dad, joins);
+    joins.push_back(make_pair(dad_branch->partial_pars, node_branch->partial_pars));
+
+    memset(ptn_pars, 0, sizeof(UINT)*aln->ordered_pattern.size());
+    for (auto join = joins.begin(); join != joins.end(); ++join) {
+        for (size_t word = 0; word < nwords; ++word) {
+            const UINT* x = join->first  + word*nstates;
+            const UINT* y = join->second + word*nstates;
+            UINT w = 0;
+            for (int i = 0; i < nstates; i++) {
+                w |= x[i] & y[i];
+            }
+            addPatternParsimonySteps(~w, word*UINT_BITS, ptn_pars);
+        }
+    }
+}
+
 void PhyloTree::computeAllPartialPars(PhyloNode *node, PhyloNode *dad) {
 	if (!node) node = getRoot();
     FOR_EACH_PHYLO_NEIGHBOR(node, dad, it, nei) {
@@ -481,11 +525,12 @@ int PhyloTree::setParsimonyBranchLengths() {
     // determine state of the root
     int branch_subst = 0;
     int pars_score   = computeParsimonyBranchFast(dad_branch, dad, &branch_subst);
-    int nsites       = (aln->num_parsimony_sites + UINT_BITS-1) / UINT_BITS;
+    int nsites       = (aln->num_parsimony_bits + UINT_BITS-1) / UINT_BITS;
     int nstates      = aln->getMaxNumStates();
+    const UINT* weight = aln->pars_word_weight.data();
 
     vector<vector<StateType> > sequences;
-    sequences.resize(nodeNum, vector<StateType>(aln->num_parsimony_sites, aln->STATE_UNKNOWN));
+    sequences.resize(nodeNum, vector<StateType>(aln->num_parsimony_bits, aln->STATE_UNKNOWN));
     BoolVector done(nodeNum, false);
     done[node->id] = done[dad->id]  = true;
 
@@ -503,7 +548,7 @@ int PhyloTree::setParsimonyBranchLengths() {
         StateType* dadSeq  = sequences[dad->id].data();
         StateType* nodeSeq = sequences[node->id].data();
 
-        for (int s = 0; s < UINT_BITS && real_site < aln->num_parsimony_sites;
+        for (int s = 0; s < UINT_BITS && real_site < aln->num_parsimony_bits;
              s++, bit = bit << 1, real_site++)
         if (w & bit) {
             // intersection is non-empty
@@ -516,7 +561,7 @@ int PhyloTree::setParsimonyBranchLengths() {
             }
         } else {
             // intersection is empty
-            subst++;
+            subst += weight[site];
             for (int state = 0; state < nstates; state++) {
                 if (x[state] & bit) {
                     // assign the first admissible state
@@ -534,6 +579,12 @@ int PhyloTree::setParsimonyBranchLengths() {
         }
     }
     ASSERT(subst == branch_subst);
+    if (dad->isLeaf() && dad->id < aln->singleton_parsimony_states.size()) {
+        subst += aln->singleton_parsimony_states[dad->id];
+    }
+    if (node->isLeaf() && node->id < aln->singleton_parsimony_states.size()) {
+        subst += aln->singleton_parsimony_states[node->id];
+    }
     sum_score += subst;
     double branch_length = correctBranchLengthF81(subst*persite, alpha);
     if (branch_length <= 0.0) {
@@ -563,7 +614,7 @@ int PhyloTree::setParsimonyBranchLengths() {
             size_t offset = nstates*site;
             UINT*  x      = dad_branch->partial_pars + offset;
             UINT   bit    = 1;
-            for (int s = 0; s < UINT_BITS && real_site < aln->num_parsimony_sites;
+            for (int s = 0; s < UINT_BITS && real_site < aln->num_parsimony_bits;
                  s++, bit = bit << 1, real_site++) {
                 StateType dad_state = dadSeq[real_site];
                 ASSERT(static_cast<int>(dad_state) < nstates);
@@ -572,7 +623,7 @@ int PhyloTree::setParsimonyBranchLengths() {
                     nodeSeq[real_site] = dad_state;
                 } else {
                     // different state from dad
-                    subst++;
+                    subst += weight[site];
                     for (int state = 0; state < nstates; state++) {
                         if (x[state] & bit) {
                             // assign the first admissible state
@@ -617,6 +668,42 @@ bool PhyloTree::isUsingSankoffParsimony() const {
     return cost_matrix != nullptr;
 }
 
+bool PhyloTree::isUsingShortSankoffParsimony() const {
+    return isUsingSankoffParsimony() && short_sankoff_kernel;
+}
+
+bool PhyloTree::canUseShortSankoffParsimony() const {
+    if (!isUsingSankoffParsimony() || short_sankoff_overflow || aln == nullptr) {
+        return false;
+    }
+    //Assigning the same state to every interior node of a subtree
+    //costs at most the largest cost per taxon, and the cost
+    //of a pattern (in that subtree) can be no more than that.
+    int  nstates  = aln->num_states;
+    UINT max_cost = 0;
+    for (int i = 0; i < nstates * nstates; ++i) {
+        max_cost = max(max_cost, cost_matrix[i]);
+    }
+    return static_cast<uint64_t>(max_cost) * aln->getNSeq() < USHRT_MAX;
+}
+
+void PhyloTree::setShortSankoffParsimony(bool use_short) {
+    if (short_sankoff_kernel != use_short) {
+        deleteAllPartialParsimony();
+        short_sankoff_kernel = use_short;
+    }
+}
+
+bool PhyloTree::fallBackFromShortSankoffParsimony() {
+    if (!short_sankoff_overflow || !isUsingShortSankoffParsimony()) {
+        return false;
+    }
+    LOG_LINE(VB_MED, "Parsimony costs did not fit in 16 bits;"
+             << " switching to 32-bit Sankoff parsimony");
+    setParsimonyKernel(params->SSE); //(short_sankoff_overflow rules out 16 bits)
+    return true;
+}
+
 void PhyloTree::stopUsingSankoffParsimony() {
     if (isUsingSankoffParsimony()) {
         deleteAllPartialParsimony();
@@ -631,6 +718,7 @@ void PhyloTree::initCostMatrix(CostMatrixType cost_type) {
         cost_matrix = nullptr; //(though... aligned_free set it to null already).
     }
     ASSERT(aln);
+    short_sankoff_overflow = false;
     int cost_nstates = aln->num_states;
     // allocate memory for cost_matrix
     cost_matrix = aligned_alloc<unsigned int>(cost_nstates * cost_nstates);
@@ -650,14 +738,18 @@ void PhyloTree::initCostMatrix(CostMatrixType cost_type) {
             break;
     }
     clearAllPartialLH();
-    clearAllPartialParsimony(false);
+    deleteAllPartialParsimony(); //(see loadCostMatrixFile)
 }
 
 void PhyloTree::loadCostMatrixFile(char * file_name){
+    //Sankoff partial parsimony vectors are laid out differently
+    //(and may be larger), so any that were allocated must go.
+    deleteAllPartialParsimony();
     if(cost_matrix){
         aligned_free(cost_matrix);
         cost_matrix = NULL;
     }
+    short_sankoff_overflow = false;
     //    if(strcmp(file_name, "fitch") == 0)
     ////    if(file_name == NULL)
     //        cost_matrix = new SankoffCostMatrix(aln->num_states);
@@ -806,13 +898,180 @@ void PhyloTree::computeTipPartialParsimony() {
             break;
     }
 }
+namespace {
+    /** the Fitch states (indexes into the per-state bit vectors)
+        that a taxon's state, at a pattern of an alignment, allows */
+    void getFitchStates(Alignment* aln, Alignment* part, int state,
+                        bool resolve_pomo_by_weight,
+                        std::vector<int>& states) {
+        static const int ambi_aa[] = {2, 3, 5, 6, 9, 10}; // {4+8, 32+64, 512+1024};
+        states.clear();
+        switch (part->seq_type) {
+            case SEQ_DNA:
+                if (state < 4) {
+                    states.push_back(state);
+                } else if (state == part->STATE_UNKNOWN) {
+                    for (int i = 0; i < 4; ++i) {
+                        states.push_back(i);
+                    }
+                } else {
+                    state -= 3;
+                    ASSERT(state < 15);
+                    for (int i = 0; i < 4; ++i) {
+                        if (state & (1<<i)) {
+                            states.push_back(i);
+                        }
+                    }
+                }
+                return;
+            case SEQ_PROTEIN:
+                if (state < 20) {
+                    states.push_back(state);
+                } else if (state == part->STATE_UNKNOWN) {
+                    for (int i = 0; i < 20; ++i) {
+                        states.push_back(i);
+                    }
+                } else {
+                    ASSERT(state < 23);
+                    state = (state-20)*2;
+                    states.push_back(ambi_aa[state]);
+                    states.push_back(ambi_aa[state+1]);
+                }
+                return;
+            default:
+                break;
+        }
+        if (aln->seq_type == SEQ_POMO && state >= static_cast<int>(part->num_states)
+            && state < static_cast<int>(part->STATE_UNKNOWN)) {
+            if (resolve_pomo_by_weight) {
+                // 2016-09-30: resolving polymorphic states to fixed states
+                state -= aln->getMaxNumStates();
+                ASSERT(state < aln->pomo_sampled_states.size());
+                int id1 = aln->pomo_sampled_states[state] & 3;
+                int id2 = (aln->pomo_sampled_states[state] >> 16) & 3;
+                int value1 = (aln->pomo_sampled_states[state] >> 2) & 16383;
+                int value2 = aln->pomo_sampled_states[state] >> 18;
+                double weight1 = ((double)value1)/(value1+value2);
+                if (weight1 < 1.0/4) {
+                    state = id2;
+                } else if (weight1 > 3.0/4) {
+                    state = id1;
+                } else {
+                    state = part->STATE_UNKNOWN;
+                }
+            } else {
+                state = part->convertPomoState(state);
+            }
+        }
+        if (state < static_cast<int>(part->num_states)) {
+            states.push_back(state);
+        } else if (state == part->STATE_UNKNOWN) {
+            for (int i = 0; i < static_cast<int>(part->num_states); ++i) {
+                states.push_back(i);
+            }
+        } else {
+            ASSERT(0);
+        }
+    }
+}
+
+void PhyloTree::computeLeafPartialParsimony(int vector_size, size_t score_index) {
+    //Sites are laid out, as the Fitch kernels lay them out, in blocks
+    //of vector_size words per state.  Runs of consecutive bits (most
+    //patterns have a run of bits, one for each site) are set a word
+    //at a time.
+    const size_t nseq         = aln->getNSeq();
+    const size_t nstates      = aln->getMaxNumStates();
+    const size_t stride       = nstates * vector_size;
+    const size_t block_bits   = vector_size * UINT_BITS;
+    const size_t nblocks      = (aln->num_parsimony_bits + block_bits - 1) / block_bits;
+    const size_t nwords       = aln->pars_word_padding.size();
+    const int*   pattern_bits = aln->pars_pattern_bits.data();
+    
+    deleteLeafPartialParsimony();
+    UINT* vectors = aligned_alloc<UINT>(nseq * pars_block_size);
+    memset(vectors, 0, nseq * pars_block_size * sizeof(UINT));
+
+    vector<Alignment*>  just_aln(1, aln);
+    vector<Alignment*>& partitions = aln->isSuperAlignment()
+                                   ? ((SuperAlignment*)aln)->partitions
+                                   : just_aln;
+    std::vector<int> states;
+    for (size_t leafid = 0; leafid < nseq; ++leafid) {
+        UINT*    x         = vectors + leafid * pars_block_size;
+        intptr_t start_pos = 0;
+        for (auto part : partitions) {
+            intptr_t end_pos = start_pos + part->ordered_pattern.size();
+            for (intptr_t patid = start_pos; patid != end_pos; ++patid) {
+                getFitchStates(aln, part, aln->ordered_pattern[patid][leafid],
+                               1 < vector_size, states);
+                int bit_end = aln->pars_pattern_bit_start[patid+1];
+                for (int j = aln->pars_pattern_bit_start[patid]; j < bit_end; ) {
+                    int run_start = pattern_bits[j];
+                    int run_stop  = run_start + 1;
+                    for (++j; j < bit_end && pattern_bits[j] == run_stop; ++j) {
+                        ++run_stop;
+                    }
+                    for (int w = run_start / UINT_BITS; w * UINT_BITS < run_stop; ++w) {
+                        int  lo   = max(run_start - w * UINT_BITS, 0);
+                        int  hi   = min(run_stop  - w * UINT_BITS, UINT_BITS);
+                        UINT mask = ((hi < UINT_BITS) ? ((1U << hi) - 1) : ~(UINT)0)
+                                  & ~((1U << lo) - 1);
+                        UINT* word = x + (w / vector_size) * stride + (w % vector_size);
+                        for (int state : states) {
+                            word[state * vector_size] |= mask;
+                        }
+                    }
+                }
+            }
+            start_pos = end_pos;
+        }
+        ASSERT(start_pos == aln->ordered_pattern.size());
+        // add dummy states
+        for (size_t w = 0; w < nblocks * vector_size; ++w) {
+            x[(w / vector_size) * stride + (w % vector_size)]
+                |= (w < nwords) ? aln->pars_word_padding[w] : ~(UINT)0;
+        }
+        //Count sites where the taxon, indicated by leafid, is the
+        //taxon that has a "singleton" state (see the Fitch kernels).
+        if (leafid < aln->singleton_parsimony_states.size()) {
+            x[score_index] = aln->singleton_parsimony_states[leafid];
+        }
+    }
+    leaf_partial_pars = vectors;
+#ifdef _OPENMP
+    #pragma omp flush
+#endif
+    leaf_partial_pars_vector_size = vector_size;
+}
+
+const UINT* PhyloTree::getLeafPartialParsimony(int leaf_id, int vector_size,
+                                               size_t score_index) {
+    if (leaf_partial_pars_vector_size != vector_size) {
+#ifdef _OPENMP
+        #pragma omp critical (leaf_partial_pars)
+#endif
+        if (leaf_partial_pars_vector_size != vector_size) {
+            computeLeafPartialParsimony(vector_size, score_index);
+        }
+    }
+    ASSERT(0 <= leaf_id && leaf_id < static_cast<int>(aln->getNSeq()));
+    return leaf_partial_pars + static_cast<size_t>(leaf_id) * pars_block_size;
+}
+
+void PhyloTree::deleteLeafPartialParsimony() {
+    leaf_partial_pars_vector_size = 0;
+    aligned_free(leaf_partial_pars);
+}
+
 /**
  compute partial parsimony score of the subtree rooted at dad
  @param dad_branch the branch leading to the subtree
  @param dad its dad, used to direct the traversal
  */
 void PhyloTree::computePartialParsimonySankoff(PhyloNeighbor *dad_branch,
-                                               PhyloNode *dad){
+                                               PhyloNode *dad,
+                                               ParsimonyExecution exec){
     // don't recompute the parsimony
     if (dad_branch->isParsimonyComputed()) {
         return;
@@ -833,7 +1092,7 @@ void PhyloTree::computePartialParsimonySankoff(PhyloNeighbor *dad_branch,
     FOR_EACH_PHYLO_NEIGHBOR(node, dad, it, nei) {
         if (nei->node->name != ROOT_NAME) {
             if (!nei->node->isLeaf())
-                computePartialParsimonySankoff(nei, node);
+                computePartialParsimonySankoff(nei, node, exec);
             if (!left) {
                 left = nei;
             }
@@ -852,7 +1111,7 @@ void PhyloTree::computePartialParsimonySankoff(PhyloNeighbor *dad_branch,
         //         for new_interior->findNeighbor(new_leaf).
         //
         #ifdef _OPENMP
-        #pragma omp parallel for reduction(+:score)
+        #pragma omp parallel for reduction(+:score) if(exec==PARS_SITE_PARALLEL)
         #endif
         for (intptr_t ptn = 0; ptn < ptnCount; ++ptn){
             // ignore const ptn because it does not affect pars score
@@ -879,7 +1138,7 @@ void PhyloTree::computePartialParsimonySankoff(PhyloNeighbor *dad_branch,
         memset(partial_pars, 0, sizeof(UINT)*pars_block_size);
         // multifurcating node
         #ifdef _OPENMP //James B. This for-loop parallelized, 18-Sep-2020.
-        #pragma omp parallel for reduction(+:score)
+        #pragma omp parallel for reduction(+:score) if(exec==PARS_SITE_PARALLEL)
         #endif
         for (intptr_t ptn = 0; ptn < ptnCount; ptn++) {
             intptr_t ptn_start_index  = ptn*nstates;
@@ -933,7 +1192,7 @@ void PhyloTree::computePartialParsimonySankoff(PhyloNeighbor *dad_branch,
     if (left->node->isLeaf() && right->node->isLeaf()) {
         // tip-tip case
         #ifdef _OPENMP //James B. This for-loop parallelized, 18-Sep-2020.
-        #pragma omp parallel for reduction(+:score)
+        #pragma omp parallel for reduction(+:score) if(exec==PARS_SITE_PARALLEL)
         #endif
         for (intptr_t ptn = 0; ptn < ptnCount; ++ptn){
             intptr_t    ptn_start_index  = ptn*nstates;
@@ -965,7 +1224,7 @@ void PhyloTree::computePartialParsimonySankoff(PhyloNeighbor *dad_branch,
         //   &some_partial_pars[ptn_start_index].
         
         #ifdef _OPENMP //James B. This for-loop parallelized, 18-Sep-2020.
-        #pragma omp parallel for reduction(+:score)
+        #pragma omp parallel for reduction(+:score) if(exec==PARS_SITE_PARALLEL)
         #endif
         for (intptr_t ptn = 0; ptn < ptnCount; ptn++){
             intptr_t    ptn_start_index  = ptn*nstates;
@@ -996,17 +1255,18 @@ void PhyloTree::computePartialParsimonySankoff(PhyloNeighbor *dad_branch,
         return;
     }
     // inner-inner case
-    computePartialParsimonyOutOfTreeSankoff(left->partial_pars, right->partial_pars, partial_pars );
+    computePartialParsimonyOutOfTreeSankoff(left->partial_pars, right->partial_pars, partial_pars, exec );
 }
 
 double PhyloTree::computePartialParsimonyOutOfTreeSankoff(const UINT* left_partial_pars,
                                                           const UINT* right_partial_pars,
-                                                          UINT* dad_partial_pars) const {
+                                                          UINT* dad_partial_pars,
+                                                          ParsimonyExecution exec) const {
     int      nstates  = aln->num_states;
     intptr_t ptnCount = aln->ordered_pattern.size();
     UINT     score    = 0;
     #ifdef _OPENMP //James B. This for-loop parallelized, 18-Sep-2020.
-    #pragma omp parallel for reduction(+:score)
+    #pragma omp parallel for reduction(+:score) if(exec==PARS_SITE_PARALLEL)
     #endif
     for (intptr_t ptn = 0; ptn < ptnCount; ++ptn){
         // ignore const ptn because it does not affect pars score
@@ -1117,19 +1377,20 @@ int PhyloTree::computeParsimonyBranchSankoff(PhyloNeighbor *dad_branch,
         // internal node
         return computeParsimonyOutOfTreeSankoff(dad_branch->partial_pars,
                                                 node_branch->partial_pars,
-                                                branch_subst);
+                                                branch_subst, PARS_SITE_PARALLEL);
     }
 }
 
 int PhyloTree::computeParsimonyOutOfTreeSankoff(const UINT* dad_partial_pars,
                                                 const UINT* node_partial_pars,
-                                                int* branch_subst) const {
+                                                int* branch_subst,
+                                                ParsimonyExecution exec) const {
     int    nstates     = aln->num_states;
     intptr_t ptnCount    = aln->ordered_pattern.size();
     UINT   tree_pars   = 0;
     UINT   branch_pars = 0;
     #ifdef _OPENMP
-    #pragma omp parallel for reduction(+:tree_pars,branch_pars)
+    #pragma omp parallel for reduction(+:tree_pars,branch_pars) if(exec==PARS_SITE_PARALLEL)
     #endif
     for (intptr_t ptn = 0; ptn < ptnCount; ptn++){
         intptr_t    ptn_start_index = ptn * nstates;
@@ -1471,9 +1732,11 @@ int PhyloTree::computeParsimonyTreeNew(const char *out_prefix,
             PhyloNeighbor* nei2 = b.getRightNeighbor();
             double link = computePartialParsimonyOutOfTree(nei1->partial_pars,
                                                            nei2->partial_pars,
-                                                           buffer[t]);
+                                                           buffer[t],
+                                                           PARS_BRANCH_PARALLEL);
             int branch = 0;
-            computeParsimonyOutOfTree(pars, buffer[t], &branch);
+            computeParsimonyOutOfTree(pars, buffer[t], &branch,
+                                      PARS_BRANCH_PARALLEL);
             scores[j] = static_cast<int>(link + branch); 
                 //cost to link anything there
                 //plus cost to link this there
@@ -68,14 +68,28 @@ void PhyloTree::setNumThreads(int threadCount) {
 
 void PhyloTree::setParsimonyKernel(LikelihoodKernel lk) {    
     if (isUsingSankoffParsimony()) {
+        if (aln != nullptr && aln->hasFoldedUninformativePatterns()) {
+            //Under a cost matrix, what uninformative patterns cost
+            //can depend on the tree, so the Sankoff kernels need them.
+            deleteAllPartialParsimony();
+            aln->orderPatternByNumChars(PAT_VARIANT);
+        }
         if (lk < LK_SSE2) {
+            setShortSankoffParsimony(false);
             computeParsimonyBranchPointer           = &PhyloTree::computeParsimonyBranchSankoff;
             computeParsimonyOutOfTreePointer        = &PhyloTree::computeParsimonyOutOfTreeSankoff;
             computePartialParsimonyPointer          = &PhyloTree::computePartialParsimonySankoff;
             computePartialParsimonyOutOfTreePointer = &PhyloTree::computePartialParsimonyOutOfTreeSankoff;
             getSubTreeParsimonyPointer              = &PhyloTree::getSubTreeParsimonySankoff;
+            computePatternParsimonyPointer          = nullptr;
+            return;
+        }
+#ifdef __AVX512PARS
+        if (lk >= LK_AVX512 && hasAVX512VPOPCNTDQ()) {
+            setParsimonyKernelAVX512();
             return;
         }
+#endif
         if (lk >= LK_AVX) {
             setParsimonyKernelAVX();
             return;
@@ -94,8 +108,16 @@ void PhyloTree::setParsimonyKernel(LikelihoodKernel lk) {
         computePartialParsimonyPointer          = &PhyloTree::computePartialParsimonyFast;
         computePartialParsimonyOutOfTreePointer = &PhyloTree::computePartialParsimonyOutOfTreeFast;
         getSubTreeParsimonyPointer              = &PhyloTree::getSubTreeParsimonyFast;
+        computePatternParsimonyPointer          = &PhyloTree::computePatternParsimonyFast;
     	return;
     }
+#ifdef __AVX512PARS
+    //AVX-512 hosts without VPOPCNTDQ (e.g. Skylake-SP) use the AVX kernels
+    if (lk >= LK_AVX512 && hasAVX512VPOPCNTDQ()) {
+        setParsimonyKernelAVX512();
+        return;
+    }
+#endif
     if (lk >= LK_AVX) {
         setParsimonyKernelAVX();
         return;
@@ -11,7 +11,8 @@
 PhyloTreeThreadingContext::PhyloTreeThreadingContext(PhyloTree& phylo_tree,
                                                      bool force_use_of_all_threads)
 : tree(phylo_tree), old_num_threads(phylo_tree.num_threads)
-, old_thread_count(0), was_omp_thread_count_set(false) {
+, old_thread_count(0), was_omp_thread_count_set(false)
+, phase(PARS_SITE_PARALLEL) {
 #ifdef _OPENMP
     old_thread_count = omp_get_num_threads();
     auto max_cores   = omp_get_num_procs();
@@ -68,6 +69,21 @@ int PhyloTreeThreadingContext::getThreadCount() const {
     return tree.num_threads;
 }
 
+void PhyloTreeThreadingContext::setPhase(ParsimonyExecution level) {
+    phase = level;
+}
+
+ParsimonyExecution PhyloTreeThreadingContext::getPhase() const {
+    return phase;
+}
+
+int PhyloTreeThreadingContext::getBranchThreadCount() const {
+    if (phase != PARS_BRANCH_PARALLEL || tree.num_threads < 1) {
+        return 1;
+    }
+    return tree.num_threads;
+}
+
 /*static*/ int PhyloTreeThreadingContext::getMaximumThreadCount() {
     #ifdef _OPENMP
         return omp_get_max_threads();
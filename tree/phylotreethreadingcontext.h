@@ -16,12 +16,21 @@ public:
     int  old_num_threads;
     int  old_thread_count;         //OMP's thread count
     bool was_omp_thread_count_set; //True if it was adjusted upward
+    ParsimonyExecution phase;      //Which level (sites or branches) is run
+                                   //in parallel, in the current phase
     
     PhyloTreeThreadingContext(PhyloTree& tree, bool force_use_of_all_threads);
     int getThreadNumber() const;
     int getThreadCount()  const;
     static int getMaximumThreadCount();
 
+    //Per-phase thread budget: the whole budget goes to one level
+    //of parallelism (kernels called in the phase are passed getPhase()),
+    //and the other level is run serially.
+    void setPhase(ParsimonyExecution level);
+    ParsimonyExecution getPhase() const;
+    int getBranchThreadCount() const; //threads across branches (or moves)
+
     ~PhyloTreeThreadingContext();
 };
 
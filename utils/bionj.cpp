@@ -869,6 +869,12 @@ public:
          , const std::string & newickTreeFilePath) {
             return false;
     }
+    virtual bool constructTreeInMemory
+        ( const std::vector<std::string> &sequenceNames
+         , const TriangularMatrix<double> &distanceMatrix
+         , const std::string & newickTreeFilePath) {
+            return false;
+    }
     virtual void setZippedOutput(bool zipIt) {
         if (zipIt) {
             std::cerr << "Warning: BIONJ2009 does not support gzip output (or input)" << std::endl;
@@ -29,6 +29,7 @@
 #include "flatmatrix.h"      //for FlatMatrix
 #include "distancematrix.h"  //for loadDistanceMatrixInto
 #include "hammingdistance.h" //for hammingDistance
+#include "mappedfile.h"      //for MappedFile::setScratchDirectory
 #if USE_GZSTREAM
 #include "gzstream.h"
 #endif
@@ -71,6 +72,7 @@ void showUsage() {
     std::cout << "Usage: decenttree (-fasta [fastapath] (-uncorrected)\n";
     std::cout << "       (-alphabet [states]) (-unknown [chars]) (-not-dna))\n";
     std::cout << "       -in [mldist] (-c [level]) (-f [prec]) -out [newick] -t [algorithm]\n";
+    std::cout << "       (-dist-out [mldist] (-dist-format [dformat])) (-scratch [dir])\n";
     std::cout << "       (-nt [threads]) (-gz) (-no-banner) (-q)\n";
     std::cout << "Arguments in parentheses () are optional.\n";
     std::cout << "[fastapath]  is the path of a .fasta format file specifying genetic sequences\n";
@@ -79,6 +81,10 @@ void showUsage() {
     std::cout << "[states]     are the characters for each site\n";
     std::cout << "[chars]      are the characters that indicate a site has an unknown character.\n";
     std::cout << "[mldist]     is the path of a distance matrix file (which may be in .gz format)\n";
+    std::cout << "             (or of a binary distance file, written with -dist-format binary)\n";
+    std::cout << "[dformat]    is square, lower, upper, or binary (binary files are memory-mapped when read)\n";
+    std::cout << "[dir]        is a directory, for scratch files that will back distance matrices\n";
+    std::cout << "             (so that the operating system can page them in and out of memory)\n";
     std::cout << "[newick]     is the path to write the newick tree file to (if it ends in .gz it will be compressed)\n";
     std::cout << "[threads]    is the number of threads, which should be between 1 and the number of CPUs.\n";
     std::cout << "-q           asks for quiet (less progress reporting).\n";
@@ -345,7 +351,6 @@ bool loadSequenceDistancesIntoMatrix(Sequences& sequences,
                         sequences[zap].markAsProblematic();
                     }
                 }
-                m.cell(row, col) = distance;
                 m.cell(col, row) = distance;
             }
             progress += (rank-row);
@@ -554,7 +559,7 @@ void removeProblematicSequences(Sequences& sequences,
     
     double startTime = getRealTime();
     std::swap(sequences, old_sequences);
-    std::swap(old_matrix, m);
+    old_matrix.swap(m);
     m.setSize(old_sequences.size() - count_problem_sequences);
     size_t rNew = 0;
     for (size_t r=0; r<old_sequences.size(); ++r) {
@@ -562,7 +567,7 @@ void removeProblematicSequences(Sequences& sequences,
             sequences.emplace_back(old_sequences[r].getName());
             m.sequenceName(rNew) = old_sequences[r].getName();
             size_t cNew = 0;
-            for (size_t c=0; c<old_sequences.size(); ++c) {
+            for (size_t c=0; c<r; ++c) {
                 if (!old_sequences[c].isProblematic()) {
                     m.cell(rNew, cNew) = old_matrix.cell(r, c);
                     ++cNew;
@@ -577,7 +582,6 @@ void removeProblematicSequences(Sequences& sequences,
 }
 
 bool prepInput(const std::string& alignmentInputFilePath,
-               const std::string& matrixInputFilePath,
                bool  reportProgress,
                const std::string& distanceOutputFilePath,
                Sequences& sequences, FlatMatrix& m) {
@@ -602,13 +606,9 @@ bool prepInput(const std::string& alignmentInputFilePath,
         if (!distanceOutputFilePath.empty()) {
             writeDistanceMatrixToFile(m, distanceOutputFilePath);
         }
-    } else if (!matrixInputFilePath.empty()) {
-        if (!loadDistanceMatrixInto(matrixInputFilePath,
-                                    reportProgress, m)) {
-            return false;
-        }
-    }
-    else {
+    } else {
+        //A distance matrix file (if one was supplied) is
+        //loaded directly by the tree builder (see main).
         return false;
     }
     return true;
@@ -679,6 +679,21 @@ int main(int argc, char* argv[]) {
             distanceOutputFilePath = nextArg;
             ++argNum;
         }
+        else if (arg=="-dist-format") {
+            if (nextArg!="square" && nextArg!="lower" &&
+                nextArg!="upper"  && nextArg!="binary") {
+                PROBLEM(arg + " should be followed by square, lower, upper, or binary");
+            }
+            format = nextArg;
+            ++argNum;
+        }
+        else if (arg=="-scratch") {
+            if (nextArg.empty()) {
+                PROBLEM(arg + " should be followed by a directory path");
+            }
+            MappedFile::setScratchDirectory(nextArg, 0);
+            ++argNum;
+        }
         else if (arg=="-t") {
             if (START_TREE_RECOGNIZED(nextArg)) {
                 algorithmName = nextArg;
@@ -813,7 +828,7 @@ int main(int argc, char* argv[]) {
     algorithm->setPrecision(precision);
     Sequences  sequences;
     FlatMatrix m;
-    bool succeeded = prepInput(alignmentFilePath, inputFilePath,
+    bool succeeded = prepInput(alignmentFilePath,
                                !algorithm->isBenchmark(),
                                distanceOutputFilePath,
                                sequences, m);
@@ -1,7 +1,7 @@
 //
-//  distancematrix.h - Template classes, Matrix and SquareMatrix,
-//                     used in distance matrix tree construction
-//                     algorithms.
+//  distancematrix.h - Template classes, TriangularMatrix, Matrix and
+//                     SquareMatrix, used in distance matrix tree
+//                     construction algorithms.
 //  Copyright James Barbetti (2020)
 //
 //  LICENSE:
@@ -35,6 +35,7 @@
 #endif
 #include "safe_io.h"   //for safeGetTrimmedLineAsStream
 #include "progress.h"  //for progress_display
+#include "mappedfile.h" //for MappedFile and BinaryDistanceMatrixFile
 
 #define MATRIX_ALIGNMENT 64
     //MUST be a power of 2 (else x & MATRIX_ALIGNMENT_MASK
@@ -60,6 +61,74 @@ template <class P> inline P* matrixAlign(P* p) {
     }
 }
 
+template <class T=float> class TriangularMatrix
+{
+    //A symmetric matrix, with zeroes on its diagonal, of which only
+    //the cells below the diagonal are stored (row r has r cells,
+    //for columns 0 through r-1, and they start at offset r*(r-1)/2).
+    //That is less than half the memory a square matrix would need,
+    //and there is no need to copy each distance into the other
+    //triangle, when calculating distances.
+protected:
+    intptr_t       rank;
+    std::vector<T> cells;
+    MappedFile*    backing; //if cells are in a memory-mapped scratch file
+    T*             data;    //points into cells, or into backing
+    TriangularMatrix(const TriangularMatrix& rhs);            //not implemented
+    TriangularMatrix& operator=(const TriangularMatrix& rhs); //ditto
+public:
+    typedef T cell_type;
+    TriangularMatrix(): rank(0), backing(nullptr), data(nullptr) {
+    }
+    ~TriangularMatrix() {
+        delete backing;
+    }
+    void setSize(size_t size) {
+        rank = static_cast<intptr_t>(size);
+        cells.clear();
+        delete backing;
+        backing = nullptr;
+        data    = nullptr;
+        size_t cell_count = size * (size==0 ? 0 : size - 1) / 2;
+        if (MappedFile::isScratchWanted(cell_count * sizeof(T))) {
+            //New scratch files are zero-filled, and paged on demand
+            backing = MappedFile::createScratch(cell_count * sizeof(T));
+            if (backing!=nullptr) {
+                data = reinterpret_cast<T*>(backing->getData());
+            }
+        }
+        if (data==nullptr) {
+            cells.resize(cell_count, (T)0);
+            data = cells.data();
+        }
+    }
+    void swap(TriangularMatrix& rhs) {
+        std::swap(rank,    rhs.rank);
+        std::swap(backing, rhs.backing);
+        std::swap(data,    rhs.data);
+        cells.swap(rhs.cells); //(vector swap keeps data pointers valid)
+    }
+    size_t getSize() const {
+        return rank;
+    }
+    const T* getRow(size_t r) const {
+        return data + r * (r - 1) / 2;
+    }
+    T* getRow(size_t r) {
+        return data + r * (r - 1) / 2;
+    }
+    T cell(size_t r, size_t c) const {
+        if (r==c) {
+            return (T)0;
+        }
+        return (c<r) ? getRow(r)[c] : getRow(c)[r];
+    }
+    T& cell(size_t r, size_t c) {
+        //Assumes: r!=c (diagonal cells are not stored)
+        return (c<r) ? getRow(r)[c] : getRow(c)[r];
+    }
+};
+
 template <class T=double> class Matrix
 {
 protected:
@@ -70,12 +139,18 @@ public:
     typedef T cell_type;
     T*     data;
     T**    rows;
+    MappedFile* backing; //if data is in a memory-mapped scratch file
     
     Matrix() : row_count(0), column_count(0), shrink_r(0)
-             , data(nullptr), rows(nullptr) {
+             , data(nullptr), rows(nullptr), backing(nullptr) {
     }
     virtual void clear() {
-        delete [] data;
+        if (backing!=nullptr) {
+            delete backing;
+            backing = nullptr;
+        } else {
+            delete [] data;
+        }
         delete [] rows;
         data         = nullptr;
         rows         = nullptr;
@@ -116,7 +191,18 @@ public:
             if (shrink_r<100) {
                 shrink_r=0;
             }
-            data        = new T[ r * w + MATRIX_ALIGNMENT/sizeof(T)];
+            size_t cell_count = r * w + MATRIX_ALIGNMENT/sizeof(T);
+            if (MappedFile::isScratchWanted(cell_count * sizeof(T))) {
+                //Let the operating system page rows in and out
+                //(falling back to the heap, if that can't be done).
+                backing = MappedFile::createScratch(cell_count * sizeof(T));
+                if (backing!=nullptr) {
+                    data = reinterpret_cast<T*>(backing->getData());
+                }
+            }
+            if (data==nullptr) {
+                data    = new T[ cell_count ];
+            }
             rows        = new T*[r];
             T *rowStart = matrixAlign(data);
             for (intptr_t row=0; row<row_count; ++row) {
@@ -221,6 +307,21 @@ public:
             if (shrink_r<100) shrink_r=0;
         }
     }
+    template <class F> void loadDistancesFromTriangle(const TriangularMatrix<F>& matrix) {
+        //Assumes: the matrix has been sized to match (and zeroed).
+        #ifdef _OPENMP
+        #pragma omp parallel for
+        #endif
+        for (intptr_t row=0; row<row_count; ++row) {
+            const F* source = matrix.getRow(row);
+            T*       dest   = rows[row];
+            for (intptr_t col=0; col<row; ++col) {
+                T d            = (T) source[col];
+                dest[col]      = d;
+                rows[col][row] = d; //U-R
+            }
+        }
+    }
     virtual void loadDistancesFromFlatArray(const double* matrix) {
         #ifdef _OPENMP
         #pragma omp parallel for
@@ -456,8 +557,44 @@ template <class F=std::stringstream, class M> void loadDistanceMatrixFromOpenFil
     }
 }
 
+template <class M> void loadDistanceMatrixFromBinaryFile
+    (const BinaryDistanceMatrixFile& in, bool reportProgress, M& matrix) {
+    //Rows are copied straight out of the memory-mapped file
+    //(see mappedfile.h for the format); there is nothing to parse.
+    size_t rank = in.getRank();
+    matrix.setSize(rank);
+    const std::vector<std::string>& names = in.getSequenceNames();
+#if USE_PROGRESS_DISPLAY
+    const char* taskDescription = reportProgress ? "Loading distance matrix" : "";
+    progress_display progress(rank, taskDescription, "loaded", "row");
+#else
+    double progress = 0.0;
+#endif
+    for (size_t r = 0; r < rank; ++r) {
+        matrix.addCluster(names[r]);
+        const float* row = in.getRow(r);
+        for (size_t c = 0; c < r; ++c) {
+            typename M::cell_type v = (typename M::cell_type)row[c];
+            matrix.cell(r, c) = v;
+            matrix.cell(c, r) = v;
+        }
+        matrix.cell(r, r) = 0;
+        ++progress;
+    }
+}
+
 template <class M> bool loadDistanceMatrixInto
     (const std::string distanceMatrixFilePath, bool reportProgress, M& matrix) {        
+    if (BinaryDistanceMatrixFile::isBinaryDistanceMatrixFile(distanceMatrixFilePath)) {
+        BinaryDistanceMatrixFile binary;
+        if (!binary.openForReading(distanceMatrixFilePath)) {
+            std::cerr << "Load matrix failed: could not map"
+                << " binary distance file: " << distanceMatrixFilePath << std::endl;
+            return false;
+        }
+        loadDistanceMatrixFromBinaryFile(binary, reportProgress, matrix);
+        return true;
+    }
     #if USE_GZSTREAM
     igzstream     in;
     #else
@@ -29,6 +29,7 @@
 //
 
 #include "flatmatrix.h"
+#include "mappedfile.h" //for BinaryDistanceMatrixFile
 #include <math.h>       //for log10
 #include <iostream>     //for std::fstream
 #include <sstream>      //for std::stringstream
@@ -38,20 +39,7 @@
 #include <fstream>      //for std::ofstream
 #endif
 
-FlatMatrix::FlatMatrix(): rowCount(0), distanceMatrix(nullptr), borrowed(false) {
-}
-
-FlatMatrix::FlatMatrix(const std::vector<std::string>& sequence_names,
-                       double* distance_data)
-    : sequenceNames(sequence_names), rowCount(sequence_names.size()),
-      distanceMatrix(distance_data), borrowed(true){
-}
-
-FlatMatrix::~FlatMatrix() {
-    if (!borrowed) {
-        delete [] distanceMatrix;
-    }
-    distanceMatrix = nullptr;
+FlatMatrix::FlatMatrix() {
 }
 
 const std::vector<std::string>& FlatMatrix::getSequenceNames() const {
@@ -67,30 +55,29 @@ std::string& FlatMatrix::sequenceName(size_t i) {
 }
 
 
+void FlatMatrix::swap(FlatMatrix& rhs) {
+    sequenceNames.swap(rhs.sequenceNames);
+    distances.swap(rhs.distances);
+}
+
 void FlatMatrix::setSize(size_t rows) {
-    if (!borrowed) {
-        delete [] distanceMatrix;
-    }
-    borrowed = false;
-    rowCount = rows;
-    distanceMatrix = new double [ rowCount * rowCount ];
-    memset(distanceMatrix, 0, rowCount*rowCount*sizeof(double));
+    distances.setSize(rows);
 }
 
-size_t FlatMatrix::getSize() {
-    return rowCount;
+size_t FlatMatrix::getSize() const {
+    return distances.getSize();
 }
 
-const double* FlatMatrix::getDistanceMatrix() const {
-    return distanceMatrix;
+const TriangularMatrix<double>& FlatMatrix::getDistanceMatrix() const {
+    return distances;
 }
 
 double FlatMatrix::cell(size_t r, size_t c) const {
-    return distanceMatrix[r * rowCount + c];
+    return distances.cell(r, c);
 }
 
 double& FlatMatrix::cell(size_t r, size_t c) {
-    return distanceMatrix[r * rowCount + c];
+    return distances.cell(r, c);
 }
 
 void FlatMatrix::addCluster(const std::string& clusterName) {
@@ -101,6 +88,9 @@ bool FlatMatrix::writeToDistanceFile(const std::string& format,
                                      int precision,
                                      int compression_level,
                                      const std::string& file_name) const {
+    if (format == "binary") {
+        return writeToBinaryDistanceFile(file_name);
+    }
     try {
         if (file_name.find(".gz") == std::string::npos) {
             std::ofstream out;
@@ -130,6 +120,26 @@ bool FlatMatrix::writeToDistanceFile(const std::string& format,
     return true;
 }
 
+bool FlatMatrix::writeToBinaryDistanceFile(const std::string& file_name) const {
+    BinaryDistanceMatrixFile out;
+    if (!out.create(file_name, sequenceNames)) {
+        return false;
+    }
+    intptr_t nseqs = static_cast<intptr_t>(sequenceNames.size());
+    #ifdef _OPENMP
+    #pragma omp parallel for
+    #endif
+    for (intptr_t seq1 = 1; seq1 < nseqs; ++seq1) {
+        float*        writeRow = out.getRow(seq1);
+        const double* readRow  = distances.getRow(seq1);
+        for (intptr_t seq2 = 0; seq2 < seq1; ++seq2) {
+            writeRow[seq2] = static_cast<float>(readRow[seq2]);
+        }
+    }
+    out.close();
+    return true;
+}
+
 template <class S>
 void FlatMatrix::writeDistancesToOpenFile(const std::string& format,
                                           int precision, S &out) const {
@@ -147,12 +157,12 @@ void FlatMatrix::writeDistancesToOpenFile(const std::string& format,
         line.precision(precision);
         size_t rowStart = upper ? (seq1+1) : 0;
         size_t rowStop  = lower ? (seq1)   : nseqs;
-        size_t pos      = seq1 * nseqs + rowStart;
-        for (size_t seq2 = rowStart; seq2 < rowStop; ++seq2, ++pos) {
-            if (distanceMatrix[pos] <= 0) {
+        for (size_t seq2 = rowStart; seq2 < rowStop; ++seq2) {
+            double distance = distances.cell(seq1, seq2);
+            if (distance <= 0) {
                 line << " 0";
             } else {
-                line << " " << distanceMatrix[pos];
+                line << " " << distance;
             }
         }
         line << "\n";
@@ -1,7 +1,7 @@
 //
 // flatmatrix.h
 // Defines FlatMatrix (a distance matrix of double precision
-// distances, stored sequentially in row-major order).
+// distances, of which only the lower triangle is stored).
 // Copyright (C) 2020, James Barbetti.
 //
 //  LICENSE:
@@ -26,34 +26,32 @@
 #include <stdlib.h> //for size_t
 #include <vector>   //for std::vector
 #include <string>   //for std::string
+#include "distancematrix.h" //for TriangularMatrix
 
 class FlatMatrix {
 private:
     std::vector<std::string> sequenceNames;
-    size_t                   rowCount;
-    double*                  distanceMatrix;
-    bool                     borrowed;
+    TriangularMatrix<double> distances;
 public:
     typedef double cell_type;
     FlatMatrix();
-    FlatMatrix(const std::vector<std::string>& sequence_names,
-               double* distance_data);
-    virtual ~FlatMatrix();
     
     const std::vector<std::string>& getSequenceNames() const;
     size_t             getMaxSeqNameLength()    const;
     const std::string& sequenceName(size_t i)   const;
     std::string&       sequenceName(size_t i);
+    void               swap(FlatMatrix& rhs);
     void               setSize(size_t rows);
-    size_t             getSize();
-    const double*      getDistanceMatrix()      const;
+    size_t             getSize()                const;
+    const TriangularMatrix<double>& getDistanceMatrix() const;
     double             cell(size_t r, size_t c) const;
-    double&            cell(size_t r, size_t c);
+    double&            cell(size_t r, size_t c); //r!=c
     void               addCluster(const std::string& clusterName);
     bool               writeToDistanceFile(const std::string& format,
                                            int precision,
                                            int compression_level,
                                            const std::string& file_name) const;
+    bool               writeToBinaryDistanceFile(const std::string& file_name) const;
     template <class S>
     void          writeDistancesToOpenFile(const std::string& format,
                                            int precision, S &out) const;
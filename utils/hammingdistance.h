@@ -21,6 +21,9 @@
 #ifndef hammingdistance_h
 #define hammingdistance_h
 
+#include <vector>
+#include <stdint.h>
+
 #ifdef USE_VECTORCLASS_LIBRARY
 #define  HAMMING_VECTOR (1)
 #include <vectorclass/vectorclass.h> //For Vec32c and Vec32cb classes
@@ -335,4 +338,119 @@ inline size_t countBitsSetIn(uint64_t* a, size_t count) {
     return countBitsSetInEither(a,a,count);
 }
 
+inline int countBitsSetInWord(uint64_t word) {
+    #if (defined (__GNUC__) || defined(__clang__)) && !defined(CLANG_UNDER_VS)
+        return __builtin_popcountll(word);
+    #else
+        return static_cast<int>(_mm_popcnt_u64(word));
+    #endif
+}
+
+//
+//BitSlicedSequences holds a sequence matrix (as constructed by
+//AlignmentSummary::constructSequenceMatrix(true), where every state is
+//either less than the state count, or unknown) as bit-planes:
+//for each 64-site word, one word per state, and one more word in which
+//bits are set for sites where the state is unknown.
+//
+//Sites are grouped by frequency class, the way weighted parsimony
+//patterns are (see Alignment::orderPatternByNumChars): a site appears in
+//the kth class if bit k of its frequency is set, and every word in
+//the kth class has weight 2^k. So the frequency-weighted Hamming
+//distance between two sequences is a weighted sum of the
+//popcounts of ANDs and ORs of their words.
+//
+//Note: Padding bits are given state 0 in every sequence (so they never
+//      differ, and are never unknown).
+//
+class BitSlicedSequences {
+protected:
+    int                   state_count;
+    intptr_t              word_count;     //per sequence, per plane
+    size_t                stride;         //uint64_ts per sequence
+    std::vector<uint64_t> bits;
+    std::vector<uint64_t> word_weights;
+
+public:
+    BitSlicedSequences(char unknown, int stateCount,
+                       const char* sequenceMatrix, intptr_t nseqs,
+                       size_t seqLen, const int* frequencyVector)
+        : state_count(stateCount), word_count(0), stride(0) {
+        //Work out where, in each frequency class, each site's bits go
+        std::vector<intptr_t> class_count;
+        for (size_t pos = 0; pos < seqLen; ++pos) {
+            unsigned int freq = static_cast<unsigned int>(frequencyVector[pos]);
+            for (size_t k = 0; freq != 0; ++k, freq >>= 1) {
+                if (class_count.size() <= k) {
+                    class_count.resize(k+1, 0);
+                }
+                class_count[k] += (freq & 1);
+            }
+        }
+        std::vector<intptr_t> class_start(class_count.size()+1, 0);
+        for (size_t k = 0; k < class_count.size(); ++k) {
+            intptr_t words = (class_count[k] + 63) / 64;
+            class_start[k+1] = class_start[k] + words * 64;
+            word_weights.resize(class_start[k+1] / 64, static_cast<uint64_t>(1) << k);
+        }
+        word_count = class_start.back() / 64;
+        stride     = static_cast<size_t>(word_count) * (state_count + 1);
+        std::vector<std::pair<intptr_t, intptr_t>> site_bits; //(site, bit)
+        std::vector<intptr_t> next_bit(class_start.begin(), class_start.end()-1);
+        for (size_t pos = 0; pos < seqLen; ++pos) {
+            unsigned int freq = static_cast<unsigned int>(frequencyVector[pos]);
+            for (size_t k = 0; freq != 0; ++k, freq >>= 1) {
+                if (freq & 1) {
+                    site_bits.emplace_back(pos, next_bit[k]++);
+                }
+            }
+        }
+        bits.resize(stride * nseqs, 0);
+        #ifdef _OPENMP
+        #pragma omp parallel for
+        #endif
+        for (intptr_t seq = 0; seq < nseqs; ++seq) {
+            const char* sequence = sequenceMatrix + seq * seqLen;
+            uint64_t*   planes   = bits.data() + seq * stride;
+            for (auto sb : site_bits) {
+                char     state = sequence[sb.first];
+                int      plane = (state == unknown || state < 0 || state_count <= state)
+                               ? state_count : state;
+                uint64_t* word = planes + (sb.second / 64) * (state_count + 1);
+                word[plane] |= static_cast<uint64_t>(1) << (sb.second % 64);
+            }
+            for (size_t k = 0; k+1 < class_start.size(); ++k) {
+                intptr_t pad = class_start[k] + class_count[k];
+                for (; pad < class_start[k+1]; ++pad) {
+                    planes[(pad / 64) * (state_count + 1)]
+                        |= static_cast<uint64_t>(1) << (pad % 64);
+                }
+            }
+        }
+    }
+    size_t getBytesPerSequence() const {
+        return stride * sizeof(uint64_t);
+    }
+    double hammingDistance(intptr_t seqA, intptr_t seqB,
+                           double& frequencyOfUnknowns) const {
+        const uint64_t* a          = bits.data() + seqA * stride;
+        const uint64_t* b          = bits.data() + seqB * stride;
+        uint64_t        distance   = 0;
+        uint64_t        freqUnknown = 0;
+        for (intptr_t w = 0; w < word_count; ++w) {
+            uint64_t same = 0;
+            for (int s = 0; s < state_count; ++s) {
+                same |= a[s] & b[s];
+            }
+            uint64_t unknowns = a[state_count] | b[state_count];
+            distance    += word_weights[w] * countBitsSetInWord(~(same | unknowns));
+            freqUnknown += word_weights[w] * countBitsSetInWord(unknowns);
+            a += state_count + 1;
+            b += state_count + 1;
+        }
+        frequencyOfUnknowns = static_cast<double>(freqUnknown);
+        return static_cast<double>(distance);
+    }
+};
+
 #endif /* hammingdistance_h */
@@ -0,0 +1,355 @@
+//
+//  mappedfile.cpp
+//  Implementation of MappedFile and BinaryDistanceMatrixFile
+//  (see mappedfile.h).
+//
+//  LICENSE:
+//* This program is free software; you can redistribute it and/or modify
+//* it under the terms of the GNU General Public License as published by
+//* the Free Software Foundation; either version 2 of the License, or
+//* (at your option) any later version.
+//*
+//* This program is distributed in the hope that it will be useful,
+//* but WITHOUT ANY WARRANTY; without even the implied warranty of
+//* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//* GNU General Public License for more details.
+//*
+//* You should have received a copy of the GNU General Public License
+//* along with this program; if not, write to the
+//* Free Software Foundation, Inc.,
+//* 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+//
+
+#include "mappedfile.h"
+#include <stdio.h>  //for remove
+#include <string.h> //for memcmp, memcpy, memset
+#include <fstream>  //for std::ifstream
+#include <sstream>  //for std::stringstream
+#if defined(WIN32) || defined(WIN64)
+    #include <windows.h>
+#else
+    #include <fcntl.h>    //for open
+    #include <sys/mman.h> //for mmap, munmap, madvise
+    #include <sys/stat.h> //for fstat
+    #include <unistd.h>   //for ftruncate, close, getpid
+#endif
+
+std::string MappedFile::scratchDirectory;
+size_t      MappedFile::scratchThreshold = 0;
+
+MappedFile::MappedFile(): address(nullptr), size(0), deleteWhenClosed(false)
+#if defined(WIN32) || defined(WIN64)
+    , fileHandle(INVALID_HANDLE_VALUE), mappingHandle(nullptr)
+#else
+    , fileDescriptor(-1)
+#endif
+{
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::openForReading(const std::string& file_path) {
+    close();
+    path = file_path;
+#if defined(WIN32) || defined(WIN64)
+    fileHandle = CreateFileA(file_path.c_str(), GENERIC_READ,
+                             FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                             FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(fileHandle, &file_size) || file_size.QuadPart==0) {
+        close();
+        return false;
+    }
+    size = static_cast<size_t>(file_size.QuadPart);
+    mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY,
+                                       0, 0, nullptr);
+    if (mappingHandle == nullptr) {
+        close();
+        return false;
+    }
+    address = static_cast<char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ,
+                                               0, 0, 0));
+#else
+    fileDescriptor = open(file_path.c_str(), O_RDONLY);
+    if (fileDescriptor < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fileDescriptor, &info)!=0 || info.st_size==0) {
+        close();
+        return false;
+    }
+    size = static_cast<size_t>(info.st_size);
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_SHARED,
+                        fileDescriptor, 0);
+    address = (mapped == MAP_FAILED) ? nullptr : static_cast<char*>(mapped);
+#endif
+    if (address==nullptr) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool MappedFile::create(const std::string& file_path, size_t file_size,
+                        bool delete_when_closed) {
+    close();
+    path             = file_path;
+    deleteWhenClosed = delete_when_closed;
+#if defined(WIN32) || defined(WIN64)
+    DWORD flags = FILE_ATTRIBUTE_NORMAL;
+    if (delete_when_closed) {
+        flags = FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE;
+        deleteWhenClosed = false; //Windows will do it
+    }
+    fileHandle = CreateFileA(file_path.c_str(), GENERIC_READ | GENERIC_WRITE,
+                             0, nullptr, CREATE_ALWAYS, flags, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    size = file_size;
+    LARGE_INTEGER wanted;
+    wanted.QuadPart = static_cast<LONGLONG>(file_size);
+    mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READWRITE,
+                                       wanted.HighPart, wanted.LowPart,
+                                       nullptr);
+    if (mappingHandle == nullptr) {
+        close();
+        return false;
+    }
+    address = static_cast<char*>(MapViewOfFile(mappingHandle,
+                                               FILE_MAP_ALL_ACCESS,
+                                               0, 0, 0));
+#else
+    fileDescriptor = open(file_path.c_str(), O_RDWR | O_CREAT | O_TRUNC,
+                          0644);
+    if (fileDescriptor < 0) {
+        return false;
+    }
+    if (delete_when_closed) {
+        //The file's contents will live as long as the mapping does,
+        //but its name goes now (so it can't be left lying around).
+        unlink(file_path.c_str());
+        deleteWhenClosed = false;
+    }
+    if (ftruncate(fileDescriptor, static_cast<off_t>(file_size))!=0) {
+        close();
+        return false;
+    }
+    size = file_size;
+    void* mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                        fileDescriptor, 0);
+    address = (mapped == MAP_FAILED) ? nullptr : static_cast<char*>(mapped);
+#endif
+    if (address==nullptr) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::close() {
+#if defined(WIN32) || defined(WIN64)
+    if (address!=nullptr) {
+        UnmapViewOfFile(address);
+    }
+    if (mappingHandle!=nullptr) {
+        CloseHandle(mappingHandle);
+        mappingHandle = nullptr;
+    }
+    if (fileHandle!=INVALID_HANDLE_VALUE) {
+        CloseHandle(fileHandle);
+        fileHandle = INVALID_HANDLE_VALUE;
+    }
+#else
+    if (address!=nullptr) {
+        munmap(address, size);
+    }
+    if (0<=fileDescriptor) {
+        ::close(fileDescriptor);
+        fileDescriptor = -1;
+    }
+#endif
+    if (deleteWhenClosed && !path.empty()) {
+        remove(path.c_str());
+    }
+    address          = nullptr;
+    size             = 0;
+    deleteWhenClosed = false;
+    path.clear();
+}
+
+bool MappedFile::isOpen() const {
+    return address!=nullptr;
+}
+
+char* MappedFile::getData() const {
+    return address;
+}
+
+size_t MappedFile::getSize() const {
+    return size;
+}
+
+void MappedFile::setScratchDirectory(const std::string& directory,
+                                     size_t threshold) {
+    scratchDirectory = directory;
+    scratchThreshold = threshold;
+}
+
+bool MappedFile::isScratchWanted(size_t allocation_size) {
+    return !scratchDirectory.empty() && scratchThreshold <= allocation_size;
+}
+
+MappedFile* MappedFile::createScratch(size_t allocation_size) {
+    static size_t scratchCount = 0;
+    std::stringstream name;
+    name << scratchDirectory;
+    if (scratchDirectory.back()!='/' && scratchDirectory.back()!='\\') {
+        name << "/";
+    }
+#if defined(WIN32) || defined(WIN64)
+    name << "scratch_" << GetCurrentProcessId();
+#else
+    name << "scratch_" << getpid();
+#endif
+    #ifdef _OPENMP
+    #pragma omp critical (scratch_file)
+    #endif
+    name << "_" << (scratchCount++) << ".tmp";
+    MappedFile* file = new MappedFile();
+    if (!file->create(name.str(), allocation_size, true)) {
+        delete file;
+        return nullptr;
+    }
+    return file;
+}
+
+namespace {
+    const char   BINARY_DISTANCE_MAGIC[8] = { 'I', 'Q', 'D', 'I',
+                                              'S', 'T', 'B', '1' };
+    const size_t BINARY_DISTANCE_HEADER   = 8 + 2 * sizeof(uint64_t);
+
+    size_t getTriangleCellCount(uint64_t rank) {
+        return static_cast<size_t>(rank) *
+               static_cast<size_t>(rank==0 ? 0 : rank-1) / 2;
+    }
+};
+
+BinaryDistanceMatrixFile::BinaryDistanceMatrixFile()
+    : rank(0), cells(nullptr) {
+}
+
+bool BinaryDistanceMatrixFile::isBinaryDistanceMatrixFile
+        (const std::string& file_path) {
+    std::ifstream in(file_path.c_str(), std::ios::binary);
+    char magic[sizeof(BINARY_DISTANCE_MAGIC)];
+    if (!in.read(magic, sizeof(magic))) {
+        return false;
+    }
+    return memcmp(magic, BINARY_DISTANCE_MAGIC, sizeof(magic))==0;
+}
+
+bool BinaryDistanceMatrixFile::openForReading(const std::string& file_path) {
+    close();
+    if (!file.openForReading(file_path)) {
+        return false;
+    }
+    const char* data = file.getData();
+    size_t      size = file.getSize();
+    uint64_t    name_bytes;
+    if (size < BINARY_DISTANCE_HEADER ||
+        memcmp(data, BINARY_DISTANCE_MAGIC, 8)!=0) {
+        close();
+        return false;
+    }
+    memcpy(&rank,       data + 8, sizeof(uint64_t));
+    memcpy(&name_bytes, data + 8 + sizeof(uint64_t), sizeof(uint64_t));
+    size_t cell_offset = BINARY_DISTANCE_HEADER + name_bytes;
+    if (size < cell_offset ||
+        (size - cell_offset) / sizeof(float) < getTriangleCellCount(rank)) {
+        close();
+        return false;
+    }
+    const char* name      = data + BINARY_DISTANCE_HEADER;
+    const char* names_end = name + name_bytes;
+    for (uint64_t r=0; r<rank; ++r) {
+        const char* stop = static_cast<const char*>
+                           (memchr(name, '\0', names_end - name));
+        if (stop==nullptr) {
+            close();
+            return false;
+        }
+        sequenceNames.emplace_back(name, stop);
+        name = stop + 1;
+    }
+    cells = reinterpret_cast<float*>(file.getData() + cell_offset);
+    return true;
+}
+
+bool BinaryDistanceMatrixFile::create(const std::string& file_path,
+                                      const std::vector<std::string>& names) {
+    close();
+    size_t name_bytes = 0;
+    for (const std::string& name : names) {
+        name_bytes += name.length() + 1;
+    }
+    name_bytes = (name_bytes + 7) & ~static_cast<size_t>(7);
+    rank = names.size();
+    size_t cell_offset = BINARY_DISTANCE_HEADER + name_bytes;
+    size_t file_size   = cell_offset
+                       + getTriangleCellCount(rank) * sizeof(float);
+    if (!file.create(file_path, file_size, false)) {
+        return false;
+    }
+    char*    data    = file.getData();
+    uint64_t written = name_bytes;
+    memcpy(data, BINARY_DISTANCE_MAGIC, 8);
+    memcpy(data + 8, &rank, sizeof(uint64_t));
+    memcpy(data + 8 + sizeof(uint64_t), &written, sizeof(uint64_t));
+    char* name = data + BINARY_DISTANCE_HEADER;
+    memset(name, 0, name_bytes);
+    for (const std::string& seq_name : names) {
+        memcpy(name, seq_name.c_str(), seq_name.length());
+        name += seq_name.length() + 1;
+    }
+    sequenceNames = names;
+    cells = reinterpret_cast<float*>(data + cell_offset);
+    return true;
+}
+
+void BinaryDistanceMatrixFile::close() {
+    file.close();
+    rank  = 0;
+    cells = nullptr;
+    sequenceNames.clear();
+}
+
+size_t BinaryDistanceMatrixFile::getRank() const {
+    return static_cast<size_t>(rank);
+}
+
+const std::vector<std::string>&
+    BinaryDistanceMatrixFile::getSequenceNames() const {
+    return sequenceNames;
+}
+
+const float* BinaryDistanceMatrixFile::getRow(size_t r) const {
+    return cells + getTriangleCellCount(r);
+}
+
+float* BinaryDistanceMatrixFile::getRow(size_t r) {
+    return cells + getTriangleCellCount(r);
+}
+
+float BinaryDistanceMatrixFile::cell(size_t r, size_t c) const {
+    if (r==c) {
+        return 0;
+    }
+    return (r<c) ? getRow(c)[r] : getRow(r)[c];
+}
@@ -0,0 +1,105 @@
+//
+//  mappedfile.h
+//  Defines MappedFile (a file, mapped into memory, so that the operating
+//  system pages its contents in, and out, on demand) and
+//  BinaryDistanceMatrixFile (a binary, memory-mapped, distance matrix
+//  file format, that can be read without parsing).
+//
+//  LICENSE:
+//* This program is free software; you can redistribute it and/or modify
+//* it under the terms of the GNU General Public License as published by
+//* the Free Software Foundation; either version 2 of the License, or
+//* (at your option) any later version.
+//*
+//* This program is distributed in the hope that it will be useful,
+//* but WITHOUT ANY WARRANTY; without even the implied warranty of
+//* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//* GNU General Public License for more details.
+//*
+//* You should have received a copy of the GNU General Public License
+//* along with this program; if not, write to the
+//* Free Software Foundation, Inc.,
+//* 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+//
+
+#ifndef mappedfile_h
+#define mappedfile_h
+
+#include <stddef.h> //for size_t
+#include <stdint.h> //for uint64_t
+#include <string>   //for std::string
+#include <vector>   //for std::vector
+
+class MappedFile {
+private:
+    std::string path;
+    char*       address;
+    size_t      size;
+    bool        deleteWhenClosed;
+#if defined(WIN32) || defined(WIN64)
+    void*       fileHandle;
+    void*       mappingHandle;
+#else
+    int         fileDescriptor;
+#endif
+    MappedFile(const MappedFile& rhs);            //not implemented
+    MappedFile& operator=(const MappedFile& rhs); //ditto
+
+    static std::string scratchDirectory;
+    static size_t      scratchThreshold;
+
+public:
+    MappedFile();
+    ~MappedFile();
+    bool   openForReading(const std::string& file_path);
+    bool   create(const std::string& file_path, size_t file_size,
+                  bool delete_when_closed);
+    void   close();
+    bool   isOpen() const;
+    char*  getData() const;
+    size_t getSize() const;
+
+    //Scratch files back (very) large in-memory matrices (see
+    //Matrix::setDimensions, in distancematrix.h), so that they
+    //need not fit in RAM.  They are only used if a scratch
+    //directory has been set, and only for allocations of at
+    //least threshold bytes.
+    static void        setScratchDirectory(const std::string& directory,
+                                           size_t threshold);
+    static bool        isScratchWanted(size_t allocation_size);
+    static MappedFile* createScratch(size_t allocation_size);
+};
+
+//
+//A binary distance matrix file is:
+//  8 bytes  "IQDISTB1"
+//  8 bytes  rank (the number of sequences), n
+//  8 bytes  b, the number of bytes of sequence names that follow
+//  b bytes  the n sequence names, each terminated by a NUL
+//           (padded, with NULs, to a multiple of 8 bytes)
+//  then     the lower triangle of the matrix, as floats: row r
+//           (for columns 0 through r-1) starts at cell r*(r-1)/2.
+//All integers are in native byte order.
+//
+class BinaryDistanceMatrixFile {
+private:
+    MappedFile               file;
+    uint64_t                 rank;
+    std::vector<std::string> sequenceNames;
+    float*                   cells;
+public:
+    typedef float cell_type;
+    BinaryDistanceMatrixFile();
+    static bool isBinaryDistanceMatrixFile(const std::string& file_path);
+    bool openForReading(const std::string& file_path);
+    bool create(const std::string& file_path,
+                const std::vector<std::string>& names);
+    void close();
+    size_t getRank() const;
+    const std::vector<std::string>& getSequenceNames() const;
+    const float* getRow(size_t r) const;
+    float*       getRow(size_t r);
+    float        cell(size_t r, size_t c) const;
+};
+
+#endif /* mappedfile_h */
@@ -314,6 +314,12 @@ public:
         variance = *this;
         return rc;
     }
+    virtual bool loadMatrix(const std::vector<std::string>& names,
+                            const TriangularMatrix<double>& matrix) {
+        bool rc = super::loadMatrix(names, matrix);
+        variance = *this;
+        return rc;
+    }
     inline T chooseLambda(intptr_t a, intptr_t b, T Vab) {
         //Assumed 0<=a<b<n
         T lambda = 0;
@@ -176,9 +176,9 @@ namespace {
     }
 }
 
-bool BenchmarkingTreeBuilder::constructTreeInMemory
+template <class M> bool BenchmarkingTreeBuilder::benchmarkInMemory
 ( const std::vector<std::string> &sequenceNames
-, const double *distanceMatrix
+, const M& distanceMatrix
 , const std::string & newickTreeFilePath) {
     bool ok = false;
     #ifdef _OPENMP
@@ -226,5 +226,19 @@ bool BenchmarkingTreeBuilder::constructTreeInMemory
     }
     return true;
 }
+
+bool BenchmarkingTreeBuilder::constructTreeInMemory
+( const std::vector<std::string> &sequenceNames
+, const double *distanceMatrix
+, const std::string & newickTreeFilePath) {
+    return benchmarkInMemory(sequenceNames, distanceMatrix, newickTreeFilePath);
+}
+
+bool BenchmarkingTreeBuilder::constructTreeInMemory
+( const std::vector<std::string> &sequenceNames
+, const TriangularMatrix<double> &distanceMatrix
+, const std::string & newickTreeFilePath) {
+    return benchmarkInMemory(sequenceNames, distanceMatrix, newickTreeFilePath);
+}
 };
 
@@ -27,6 +27,8 @@
 #include <vector>
 #include "timeutil.h"       //for getRealTime()
 
+template <class T> class TriangularMatrix; //see distancematrix.h
+
 namespace StartTree
 {
     class BuilderInterface
@@ -43,6 +45,10 @@ namespace StartTree
             ( const std::vector<std::string> &sequenceNames
              , const double *distanceMatrix
              , const std::string & newickTreeFilePath) = 0;
+        virtual bool constructTreeInMemory
+            ( const std::vector<std::string> &sequenceNames
+             , const TriangularMatrix<double> &distanceMatrix
+             , const std::string & newickTreeFilePath) = 0;
         virtual const std::string& getName() = 0;
         virtual const std::string& getDescription() = 0;
         virtual void beSilent() = 0;
@@ -164,6 +170,24 @@ namespace StartTree
             }
             return builder.writeTreeFile(precision, newickTreeFilePath);
         }
+        virtual bool constructTreeInMemory
+            ( const std::vector<std::string> &sequenceNames
+            , const TriangularMatrix<double> &distanceMatrix
+            , const std::string & newickTreeFilePath) {
+            B builder;
+            if (silent) {
+                builder.beSilent();
+            }
+            if (!builder.loadMatrix(sequenceNames, distanceMatrix)) {
+                return false;
+            }
+            constructTreeWith(builder);
+            builder.setZippedOutput(isOutputToBeZipped);
+            if (newickTreeFilePath.empty()) {
+                return true;
+            }
+            return builder.writeTreeFile(precision, newickTreeFilePath);
+        }
         virtual void setPrecision(int precision_to_use) {
             precision = precision_to_use;
         }
@@ -172,6 +196,10 @@ namespace StartTree
     class BenchmarkingTreeBuilder: public BuilderInterface
     {
     protected:
+        template <class M> bool benchmarkInMemory
+            ( const std::vector<std::string> &sequenceNames
+            , const M& distanceMatrix
+            , const std::string& newickTreeFilePath);
         const std::string name;
         const std::string description;
         std::vector<BuilderInterface*> builders;
@@ -190,6 +218,10 @@ namespace StartTree
             ( const std::vector<std::string> &sequenceNames
             , const double *distanceMatrix
             , const std::string& newickTreeFilePath);
+        virtual bool constructTreeInMemory
+            ( const std::vector<std::string> &sequenceNames
+            , const TriangularMatrix<double> &distanceMatrix
+            , const std::string& newickTreeFilePath);
         virtual void setZippedOutput(bool zipIt);
         virtual void beSilent();
         virtual void setPrecision(int precisionToUse);
@@ -464,6 +464,17 @@ public:
         loadDistancesFromFlatArray(matrix);
         return true;
     }
+    virtual bool loadMatrix
+        ( const std::vector<std::string>& names,
+          const TriangularMatrix<double>& matrix ) {
+        setSize(names.size());
+        graph.clear();
+        for (auto it = names.begin(); it != names.end(); ++it) {
+            addCluster(*it);
+        }
+        this->loadDistancesFromTriangle(matrix);
+        return true;
+    }
     bool writeTreeFile(int precision, const std::string &treeFilePath) const {
         return graph.writeTreeFile(isOutputToBeZipped, precision, treeFilePath);
     }
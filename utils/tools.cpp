@@ -573,6 +573,7 @@ void parseArg(int argc, char *argv[], Params &params) {
     params.transfer_bootstrap = 0;
     params.mpboot2 = false;
     params.mpboot2_relax_hclimb = false;
+    params.mpboot2_walkers = 1;
 
 
     params.aln_file = NULL;
@@ -589,7 +590,9 @@ void parseArg(int argc, char *argv[], Params &params) {
     params.topotest_replicates = 0;
     params.topotest_optimize_model = false;
     params.do_weighted_test = false;
+    params.topotest_workers = 1;
     params.do_au_test = false;
+    params.au_test_streaming = false;
     params.siteLL_file = NULL; //added by MA
     params.partition_file = NULL;
     params.partition_type = BRLEN_OPTIMIZE;
@@ -635,7 +638,10 @@ void parseArg(int argc, char *argv[], Params &params) {
     params.parsimony_pll_spr              = false;
     params.parsimony_tbr_iterations       = 0;
     params.use_lazy_parsimony_tbr         = false;
+    params.parsimony_weighted_patterns    = false;
     params.parsimony_hybrid_iterations    = 0;
+    params.parsimony_max_mem_size         = 0;
+    params.parsimony_max_mem_is_in_bytes  = false;
     params.optimize_ml_tree_with_parsimony = false;
     params.nni5 = true;
     params.nni5_num_eval = 1;
@@ -698,6 +704,7 @@ void parseArg(int argc, char *argv[], Params &params) {
 //    params.avoid_duplicated_trees = false;
     params.writeDistImdTrees = false;
     params.rf_dist_mode = 0;
+    params.rf_dist_stream = false;
     params.rf_same_pair = false;
     params.normalize_tree_dist = false;
     params.mvh_site_rate = false;
@@ -1156,6 +1163,7 @@ void parseArg(int argc, char *argv[], Params &params) {
                 const char* allowed[] = {
                     "square", "lower", "upper"
                     , "square.gz", "lower.gz", "upper.gz"
+                    , "binary"
                 };
                 throw_if_not_in_set ( "dist-format", params.dist_format
                                     , allowed, sizeof(allowed)/sizeof(allowed[0]));
@@ -1523,6 +1531,14 @@ void parseArg(int argc, char *argv[], Params &params) {
                 params.mpboot2_relax_hclimb = true;
                 continue;
             }
+            if (arg == "-mpboot2-walkers") {
+                string next_arg = next_argument(argc, argv, "number_of_walkers", cnt);
+                params.mpboot2_walkers = convert_int(next_arg.c_str());
+                if (params.mpboot2_walkers < 1) {
+                    throw "Number of walkers (-mpboot2-walkers) must be positive";
+                }
+                continue;
+            }
             if (arg=="-stats") {
                 params.run_mode = STATS;
                 continue;
@@ -1578,6 +1594,10 @@ void parseArg(int argc, char *argv[], Params &params) {
                 params.run_mode = PRINT_TAXA;
                 continue;
             }
+            if (arg=="--bench-newick") {
+                params.run_mode = BENCH_NEWICK;
+                continue;
+            }
             if (arg=="-area") {
                 params.run_mode = PRINT_AREA;
                 continue;
@@ -1852,10 +1872,26 @@ void parseArg(int argc, char *argv[], Params &params) {
                 params.do_weighted_test = true;
                 continue;
             }
+            if (arg=="--test-workers") {
+                ++cnt;
+                if (cnt >= argc) {
+                    throw "Use --test-workers <#trees>";
+                }
+                params.topotest_workers = convert_int(argv[cnt]);
+                if (params.topotest_workers < 1) {
+                    throw "--test-workers must be positive";
+                }
+                continue;
+            }
             if (arg=="-au" || arg=="--test-au") {
                 params.do_au_test = true;
                 continue;
             }
+            if (arg=="--test-au-stream") {
+                params.do_au_test = true;
+                params.au_test_streaming = true;
+                continue;
+            }
             if (arg=="-sp" || arg=="-Q") {
                 ++cnt;
                 if (cnt >= argc) {
@@ -2229,6 +2265,10 @@ void parseArg(int argc, char *argv[], Params &params) {
                 params.use_lazy_parsimony_tbr = true;
                 continue;
             }
+            if (arg=="-parsimony-weighted-patterns") {
+                params.parsimony_weighted_patterns = true;
+                continue;
+            }
             if (arg=="-parsimony-hybrid") {
                 std::string next_arg = next_argument(argc, argv,
                                                      "max_parsimony_iterations", cnt);
@@ -2238,6 +2278,37 @@ void parseArg(int argc, char *argv[], Params &params) {
             }
             
             
+            if (arg=="-pars-mem") {
+                std::string next_arg = next_argument(argc, argv,
+                                                     "max_parsimony_mem_size", cnt);
+                int    end_pos;
+                double mem = convert_double(next_arg.c_str(), end_pos);
+                if (mem <= 0) {
+                    throw "-pars-mem must be positive";
+                }
+                char suffix = next_arg.c_str()[end_pos];
+                if ( suffix == 'G') {
+                    params.parsimony_max_mem_size        = mem * 1073741824.0;
+                    params.parsimony_max_mem_is_in_bytes = true;
+                } else if ( suffix == 'M') {
+                    params.parsimony_max_mem_size        = mem * 1048576.0;
+                    params.parsimony_max_mem_is_in_bytes = true;
+                } else if ( suffix == '%') {
+                    params.parsimony_max_mem_size        = mem * 0.01;
+                    params.parsimony_max_mem_is_in_bytes = false;
+                    if (params.parsimony_max_mem_size > 1) {
+                        throw "-pars-mem percentage must be between 0 and 100";
+                    }
+                } else {
+                    if (mem > 1) {
+                        throw "Invalid -pars-mem option."
+                              " Example: -pars-mem 200M, -pars-mem 10G -pars-mem 50% -pars-mem 0.5";
+                    }
+                    params.parsimony_max_mem_size        = mem;
+                    params.parsimony_max_mem_is_in_bytes = false;
+                }
+                continue;
+            }
             if (arg=="-distance-uses-max-threads") {
                 params.distance_uses_max_threads = true;
                 continue;
@@ -2955,6 +3026,10 @@ void parseArg(int argc, char *argv[], Params &params) {
                 params.rf_dist_mode = RF_ADJACENT_PAIR;
                 continue;
             }
+            if (arg=="--tree-dist-stream") {
+                params.rf_dist_stream = true;
+                continue;
+            }
             if (arg=="-rf" || arg=="--tree-dist") {
                 params.rf_dist_mode = RF_TWO_TREE_SETS;
                 ++cnt;
@@ -4715,7 +4790,9 @@ void usage_iqtree(char* argv[], bool full_command) {
     << "  --trees FILE         Set of trees to evaluate log-likelihoods" << endl
     << "  --test NUM           Replicates for topology test" << endl
     << "  --test-weight        Perform weighted KH and SH tests" << endl
+    << "  --test-workers NUM   Number of trees evaluated concurrently (default: 1)" << endl
     << "  --test-au            Approximately unbiased (AU) test (Shimodaira 2002)" << endl
+    << "  --test-au-stream     AU test with histograms instead of all replicates" << endl
     << "  --sitelh             Write site log-likelihoods to .sitelh file" << endl
 
     << endl << "ANCESTRAL STATE RECONSTRUCTION:" << endl
@@ -4778,6 +4855,7 @@ void usage_iqtree(char* argv[], bool full_command) {
         << "  --suptag STRING      Node name (or ALL) to assign tree IDs where node occurs" << endl
         << endl << "TREE DISTANCE BY ROBINSON-FOULDS (RF) METRIC:" << endl
         << "  --tree-dist-all      Compute all-to-all RF distances for -t trees" << endl
+        << "  --tree-dist-stream   Read -t trees one at a time for --tree-dist-all" << endl
         << "  --tree-dist FILE     Compute RF distances between -t trees and this set" << endl
         << "  --tree-dist2 FILE    Like -rf but trees can have unequal taxon sets" << endl
     //            << "  -rf_adj              Computing RF distances of adjacent trees in <treefile>" << endl
@@ -4791,6 +4869,7 @@ void usage_iqtree(char* argv[], bool full_command) {
         << "  --rand UNI|CAT|BAL   UNIform | CATerpillar | BALanced random tree" << endl
         //<< "  --rand NET           Random circular split network" << endl
         << "  --rlen NUM NUM NUM   min, mean, and max random branch lengths" << endl
+        << "  --bench-newick       Time the NEWICK parsers on -t trees" << endl
 
         << endl << "MISCELLANEOUS:" << endl
         << "  --keep-ident         Keep identical sequences (default: remove & finally add)" << endl
@@ -194,7 +194,7 @@ typedef unsigned int UINT;
 enum RunMode {
     DETECTED, GREEDY, PRUNING, BOTH_ALG, EXHAUSTIVE, DYNAMIC_PROGRAMMING,
     CALC_DIST, PD_USER_SET, PRINT_TAXA, PRINT_AREA, SCALE_BRANCH_LEN,
-    SCALE_NODE_NAME, PD_DISTRIBUTION, LINEAR_PROGRAMMING, STATS //, GBO, MPRO
+    SCALE_NODE_NAME, PD_DISTRIBUTION, LINEAR_PROGRAMMING, STATS, BENCH_NEWICK //, GBO, MPRO
 }; //STATS and GBO added by MA (STATS for some statistics on tree, GBO = guided 'bootstrap'
 
 /**
@@ -467,6 +467,8 @@ public:
 
     int mpboot2; // Diep: 2021-04-24, why 'int'?
     bool mpboot2_relax_hclimb; // Diep: 2021-04-24, adding option for pMPBoot* (for convenience)
+    int  mpboot2_walkers;      // number of concurrent parsimony hill-climbing walkers
+                               // (each on its own tree, sharing the candidate set)
 
     /**
      *  Option to check memory consumption only
@@ -614,6 +616,16 @@ public:
     int    parsimony_spr_iterations;
     bool   use_lazy_parsimony_spr;
     int    parsimony_hybrid_iterations;
+
+    /**
+     *  memory budget for partial parsimony vectors, when whole trees
+     *  are scored (see ParsimonySlotVector in tree/memslot.h).
+     *  0 means: no budget (allocate a vector for every view).
+     *  It is in bytes if parsimony_max_mem_is_in_bytes is true,
+     *  otherwise it is a fraction of the number of views.
+     */
+    double parsimony_max_mem_size;
+    bool   parsimony_max_mem_is_in_bytes;
     
     /**
      *  TBR distance (radius) for parsimony tree
@@ -624,6 +636,12 @@ public:
 
     bool   use_lazy_parsimony_tbr;
 
+    /**
+     *  Fitch parsimony vectors hold one bit per bit-plane of each
+     *  pattern's frequency (rather than one bit per site)
+     */
+    bool   parsimony_weighted_patterns;
+
     bool   optimize_ml_tree_with_parsimony;
 	/**
 	 *  New search heuristics (DEFAULT: ON)
@@ -831,9 +849,17 @@ public:
     /** true to perform weighted SH and KH test */
     bool do_weighted_test;
 
+    /** number of trees of a tree set evaluated concurrently (default: 1),
+     each by its own worker tree sharing the model of the main tree */
+    int topotest_workers;
+
     /** true to do the approximately unbiased (AU) test */
     bool do_au_test;
 
+    /** true to accumulate the AU test replicates in per-tree histograms
+     instead of keeping them all (also done when they do not fit in memory) */
+    bool au_test_streaming;
+
     /**
             file specifying partition model
      */
@@ -1631,6 +1657,12 @@ public:
      */
     int rf_dist_mode;
 
+    /**
+     true to read trees one at a time for RF_ALL_PAIR and RF_ADJACENT_PAIR,
+     keeping only their split fingerprints in memory
+     */
+    bool rf_dist_stream;
+
     /**
      true to compute distance between the same k-th tree in two sets
      */
@@ -189,6 +189,20 @@ public:
         calculateRowTotals();
         return true;
     }
+    virtual bool loadMatrix(const std::vector<std::string>& names,
+                            const TriangularMatrix<double>& matrix) {
+        //Assumptions: as for the other loadMatrix (except that the
+        //  distance between taxon row and taxon col, for row>col,
+        //  is in matrix.getRow(row)[col]).
+        setSize(names.size());
+        clusters.clear();
+        for (auto it = names.begin(); it != names.end(); ++it) {
+            clusters.addCluster(*it);
+        }
+        this->loadDistancesFromTriangle(matrix);
+        calculateRowTotals();
+        return true;
+    }
     virtual bool constructTree() {
         clusterDuplicates();
 